@@ -0,0 +1,483 @@
+// benchmarks for struse.h
+//
+// Times the vector and single pass code against the simple approach it replaces
+// on generated text. Build optimized for each target, see the Makefile, and run
+// with a section name to only run that section:
+//
+//	bench [float|hash|remove|replace|reverse|transcode|wildcard]
+
+#define STRUSE_IMPLEMENTATION
+#include "struse.h"
+#include <stdlib.h>
+#include <time.h>
+
+// xorshift random numbers so every run times the same input
+static uint64_t rnd_state = 0x2545f4914f6cdd1dULL;
+static uint32_t rnd() { rnd_state ^= rnd_state << 13; rnd_state ^= rnd_state >> 7;
+	rnd_state ^= rnd_state << 17; return (uint32_t)(rnd_state >> 16); }
+
+// keeps results alive so the compiler does not remove the timed work
+static volatile uint64_t sink = 0;
+
+// seconds for the fastest of a few runs
+template <class F> static double best_time(F f, int runs = 3)
+{
+	double best = 1e30;
+	for (int r = 0; r < runs; r++) {
+		clock_t start = clock();
+		f();
+		double t = double(clock() - start) / CLOCKS_PER_SEC;
+		if (t < best)
+			best = t;
+	}
+	return best > 1e-9 ? best : 1e-9;
+}
+
+static double gbs(strl_t bytes, double t) { return double(bytes) / t * 1e-9; }
+
+// the backtracking wildcard search grows with a power of the text length on near
+// misses, the automaton stays linear
+static void bench_wildcard()
+{
+	printf("wildcard *a*a*b on runs of 'a' (no match)\n");
+	strl_t size = 1 << 20;
+	char *text = (char*)malloc(size);
+	memset(text, 'a', size);
+	strwild backtrack(strref("*a*a*b")), automaton(strref("*a*a*b"), true, SWE_AUTOMATON);
+	for (strl_t n = 500; n <= size; n *= 2) {
+		strref t(text, n);
+		double a = best_time([&]() { sink += t.find_wildcard(automaton).get_len(); });
+		if (n <= 2000) {
+			double b = best_time([&]() { sink += t.find_wildcard(backtrack).get_len(); }, 1);
+			printf("  %8u characters: backtrack %9.4fs  automaton %9.6fs\n", n, b, a);
+		} else if (n > (size / 4))
+			printf("  %8u characters: backtrack      (skipped)  automaton %9.6fs\n", n, a);
+	}
+	free(text);
+}
+
+// the backward byte loop find_last(char) used before it was vectorized
+static int loop_find_last(const char *s, strl_t len, char c)
+{
+	while (len--) {
+		if (s[len]==c)
+			return int(len);
+	}
+	return -1;
+}
+
+static int loop_find_last(const char *s, strl_t len, char c, char d)
+{
+	while (len--) {
+		if (s[len]==c || s[len]==d)
+			return int(len);
+	}
+	return -1;
+}
+
+// last path separator in short paths and last character in long lines
+static void bench_reverse()
+{
+	printf("find_last(char) and find_last(char, char) on paths and 4KB lines\n");
+	const strl_t lines = 4096, line_len = 4096;
+	char *text = (char*)malloc(lines * line_len);
+	for (strl_t i = 0; i < lines * line_len; i++)
+		text[i] = char('a' + rnd() % 26);
+	const strl_t path_len = 48;
+	for (strl_t i = 0; i < lines; i++)
+		text[i * path_len + rnd() % 16] = '/';
+	strl_t total = lines * path_len;
+	double a = best_time([&]() { for (int r = 0; r < 100; r++) for (strl_t i = 0; i < lines; i++)
+		sink += strref(text + i * path_len, path_len).find_last('/'); });
+	double b = best_time([&]() { for (int r = 0; r < 100; r++) for (strl_t i = 0; i < lines; i++)
+		sink += loop_find_last(text + i * path_len, path_len, '/'); });
+	printf("  %u character paths: find_last %6.2f GB/s  byte loop %6.2f GB/s\n", path_len, gbs(100 * total, a), gbs(100 * total, b));
+	a = best_time([&]() { for (int r = 0; r < 100; r++) for (strl_t i = 0; i < lines; i++)
+		sink += strref(text + i * path_len, path_len).find_last('/', '\\'); });
+	b = best_time([&]() { for (int r = 0; r < 100; r++) for (strl_t i = 0; i < lines; i++)
+		sink += loop_find_last(text + i * path_len, path_len, '/', '\\'); });
+	printf("  %u character paths, / or \\: find_last %6.2f GB/s  byte loop %6.2f GB/s\n", path_len, gbs(100 * total, a), gbs(100 * total, b));
+	for (strl_t i = 0; i < lines; i++)
+		text[i * line_len + rnd() % 64] = '/';
+	total = lines * line_len;
+	a = best_time([&]() { for (strl_t i = 0; i < lines; i++) sink += strref(text + i * line_len, line_len).find_last('/'); });
+	b = best_time([&]() { for (strl_t i = 0; i < lines; i++) sink += loop_find_last(text + i * line_len, line_len, '/'); });
+	printf("  %u character lines: find_last %6.2f GB/s  byte loop %6.2f GB/s\n", line_len, gbs(total, a), gbs(total, b));
+	a = best_time([&]() { for (strl_t i = 0; i < lines; i++) sink += strref(text + i * line_len, line_len).find_last('/', '\\'); });
+	b = best_time([&]() { for (strl_t i = 0; i < lines; i++) sink += loop_find_last(text + i * line_len, line_len, '/', '\\'); });
+	printf("  %u character lines, / or \\: find_last %6.2f GB/s  byte loop %6.2f GB/s\n", line_len, gbs(total, a), gbs(total, b));
+	free(text);
+}
+
+// time a hash over every key_len slice of text, returns GB/s
+template <class H> static double hash_rate(const char *text, strl_t size, strl_t key_len, H h)
+{
+	strl_t keys = size / key_len;
+	double t = best_time([&]() {
+		uint64_t sum = 0;
+		for (strl_t k = 0; k < keys; k++)
+			sum += h(strref(text + k * key_len, key_len));
+		sink += sum; });
+	return gbs(keys * key_len, t);
+}
+
+// hash64 variants against the byte at a time fnv1a hashes on identifier sized
+// keys and long lines of words
+static void bench_hash()
+{
+	printf("hash64 against fnv1a on keys and 4KB lines\n");
+	const strl_t size = 16 << 20;
+	char *text = (char*)malloc(size);
+	// words separated by single spaces with a tab or double space now and then
+	for (strl_t i = 0; i < size; i++) {
+		uint32_t r = rnd() % 128;
+		text[i] = r < 20 ? ' ' : (r < 22 ? '\t' : (r < 40 ? char('A' + rnd() % 26) : char('a' + rnd() % 26)));
+		if (text[i] == ' ' && i && text[i - 1] <= ' ' && (rnd() % 8))
+			text[i] = 'x';
+	}
+	const strl_t key_lens[] = { 8, 24, 4096 };
+	for (size_t l = 0; l < sizeof(key_lens) / sizeof(key_lens[0]); l++) {
+		strl_t n = key_lens[l];
+		printf("  %4u bytes: hash64 %6.2f  fnv1a %6.2f  fnv1a_64 %6.2f GB/s\n", n,
+			hash_rate(text, size, n, [](strref s) { return s.hash64(); }),
+			hash_rate(text, size, n, [](strref s) { return (uint64_t)s.fnv1a(); }),
+			hash_rate(text, size, n, [](strref s) { return s.fnv1a_64(); }));
+		printf("  %4u bytes: hash64_lower %6.2f  fnv1a_lower %6.2f GB/s\n", n,
+			hash_rate(text, size, n, [](strref s) { return s.hash64_lower(); }),
+			hash_rate(text, size, n, [](strref s) { return (uint64_t)s.fnv1a_lower(); }));
+		printf("  %4u bytes: hash64_ws %6.2f  fnv1a_ws %6.2f GB/s\n", n,
+			hash_rate(text, size, n, [](strref s) { return s.hash64_ws(); }),
+			hash_rate(text, size, n, [](strref s) { return (uint64_t)s.fnv1a_ws(); }));
+	}
+	free(text);
+}
+
+// JSON style array of numbers with a mix of integers, short decimals, exponents
+// and full precision doubles
+static strl_t number_array(char *text, strl_t cap, int count)
+{
+	strovl out(text, cap);
+	out.append('[');
+	for (int i = 0; i < count; i++) {
+		if (i)
+			out.append(", ");
+		switch (rnd() % 4) {
+			case 0: out.append_int64(int64_t(rnd() % 200000) - 100000); break;
+			case 1: out.sprintf_append("%.2f", double(rnd() % 100000) / 100.0); break;
+			case 2: out.sprintf_append("%.3e", double(rnd()) * (rnd() % 2 ? 1e-12 : 1e12)); break;
+			default: out.append_double(double(rnd()) / double(rnd() | 1) - 100.0); break;
+		}
+	}
+	out.append(']');
+	return out.len();
+}
+
+// the in place parser against copying each number out and calling libc as
+// strref::atod did for strings that are not zero terminated
+static void bench_float()
+{
+	printf("parse_double and parse_float on a JSON array of numbers\n");
+	const int count = 1000000;
+	const strl_t cap = count * 26 + 2;
+	char *text = (char*)malloc(cap + 1);
+	strl_t size = number_array(text, cap, count);
+	text[size] = 0;
+	strref json(text + 1, size - 2);
+	double a = best_time([&]() {
+		double sum = 0, v;
+		for (strref s = json; s; ) {
+			s += s.parse_double(v);
+			sum += v;
+			s.skip_whitespace();
+			s += s.get_first()==',';
+			s.skip_whitespace();
+		}
+		sink += uint64_t(sum); });
+	double f = best_time([&]() {
+		float sum = 0, v;
+		for (strref s = json; s; ) {
+			s += s.parse_float(v);
+			sum += v;
+			s.skip_whitespace();
+			s += s.get_first()==',';
+			s.skip_whitespace();
+		}
+		sink += uint64_t(sum); });
+	double b = best_time([&]() {
+		double sum = 0;
+		for (strref s = json; s; ) {
+			strl_t l = s.len_float_number();
+			strown<64> num(s.get_substr(0, l));
+			sum += ::atof(num.c_str());
+			s += l;
+			s.skip_whitespace();
+			s += s.get_first()==',';
+			s.skip_whitespace();
+		}
+		sink += uint64_t(sum); });
+	double c = best_time([&]() {
+		double sum = 0;
+		for (char *s = text + 1, *e; *s && *s != ']'; s = e + (*e == ',') + 1)
+			sum += strtod(s, &e);
+		sink += uint64_t(sum); });
+	printf("  %d numbers, %u bytes\n", count, size);
+	printf("  parse_double %6.1f M/s  parse_float %6.1f M/s  copy + atof %6.1f M/s  strtod %6.1f M/s\n",
+		count / a * 1e-6, count / f * 1e-6, count / b * 1e-6, count / c * 1e-6);
+	free(text);
+}
+
+// growing replace as strovl::replace did it before the single forward pass, counts
+// the matches and then searches backwards from each match for the one before it
+static strl_t old_replace_grow(char *scan, strl_t left, strl_t cap, const strref a, const strref b)
+{
+	strl_t len_a = a.get_len(), len_b = b.get_len();
+	int cnt = strref(scan, left).substr_count(a);
+	strl_t nl = cnt * (len_b - len_a) + left;
+	if (!cnt || nl > cap)
+		return left;
+	int ss = strref(scan, left).find_last(a);
+	int se = (int)left;
+	char *pd = scan + nl, *ps = scan + left;
+	while (ss >= 0) {
+		strl_t cp = se - ss - len_a;
+		while (cp--)
+			*--pd = *--ps;
+		ps -= len_a;
+		const char *be = b.get() + len_b;
+		cp = len_b;
+		while (cp--)
+			*--pd = *--be;
+		se = ss;
+		ss = strref(scan, se).find_last(a);
+	}
+	return nl;
+}
+
+// replace a short word with a longer one in a multi megabyte buffer
+static void bench_replace()
+{
+	printf("strovl replace of a growing word, one match per 128 characters\n");
+	const strl_t max_size = 16 << 20;
+	char *source = (char*)malloc(max_size), *work = (char*)malloc(max_size * 2);
+	for (strl_t i = 0; i < max_size; i++)
+		source[i] = char('a' + rnd() % 26);
+	for (strl_t i = 0; i + 4 < max_size; i += 96 + rnd() % 64)
+		memcpy(source + i, "{id}", 4);
+	strref a("{id}"), b("identifier");
+	for (strl_t size = 1 << 20; size <= max_size; size *= 2) {
+		int count = strref(source, size).substr_count(a);
+		double r = best_time([&]() {
+			memcpy(work, source, size);
+			strovl ovl(work, max_size * 2, size);
+			sink += ovl.replace(a, b).get_len(); });
+		double o = best_time([&]() {
+			memcpy(work, source, size);
+			sink += old_replace_grow(work, size, max_size * 2, a, b); });
+		printf("  %5u KB, %6d matches: replace %8.4fs  previous %8.4fs\n", size >> 10, count, r, o);
+	}
+	free(work);
+	free(source);
+}
+
+// strmod::remove(char) before it was vectorized, a branch per character
+static strl_t old_remove(char *scan, strl_t left, char a)
+{
+	char *start = scan, *write = scan;
+	while (left) {
+		while (left && *scan == a) {
+			left--;
+			scan++;
+		}
+		while (left && *scan != a) {
+			*write++ = *scan++;
+			left--;
+		}
+	}
+	return strl_t(write - start);
+}
+
+// strip carriage returns and whitespace from a large CRLF text file
+static void bench_remove()
+{
+	printf("remove on 64MB of CRLF text with 60 character lines\n");
+	const strl_t size = 64 << 20;
+	char *source = (char*)malloc(size), *work = (char*)malloc(size);
+	for (strl_t i = 0; i < size; i++) {
+		uint32_t r = rnd() % 64;
+		source[i] = r < 10 ? ' ' : (r < 11 ? '\t' : char('a' + r % 26));
+	}
+	for (strl_t i = 60; i + 1 < size; i += 50 + rnd() % 20) {
+		source[i] = '\r';
+		source[i + 1] = '\n';
+	}
+	double t = best_time([&]() { memcpy(work, source, size); });
+	double a = best_time([&]() {
+		memcpy(work, source, size);
+		strovl ovl(work, size, size);
+		sink += ovl.remove('\r').get_len(); }) - t;
+	double b = best_time([&]() {
+		memcpy(work, source, size);
+		sink += old_remove(work, size, '\r'); }) - t;
+	printf("  remove('\\r'):       %6.2f GB/s  byte loop %6.2f GB/s\n", gbs(size, a), gbs(size, b));
+	a = best_time([&]() {
+		memcpy(work, source, size);
+		strovl ovl(work, size, size);
+		sink += ovl.remove_whitespace().get_len(); }) - t;
+	b = best_time([&]() {
+		memcpy(work, source, size);
+		strl_t n = 0;
+		for (strl_t i = 0; i < size; i++) {
+			if ((uint8_t)work[i] > 0x20)
+				work[n++] = work[i];
+		}
+		sink += n; }) - t;
+	printf("  remove_whitespace(): %6.2f GB/s  byte loop %6.2f GB/s\n", gbs(size, a), gbs(size, b));
+
+	// erase the first line of a 1MB string until it is empty
+	const strl_t text = 1 << 20;
+	a = best_time([&]() {
+		memcpy(work, source, text);
+		strovl ovl(work, text, text);
+		while (ovl.get_len())
+			ovl.erase(0, 64); });
+	b = best_time([&]() {
+		memcpy(work, source, text);
+		for (strl_t len = text; len; ) {
+			strl_t n = len < 64 ? len : 64;
+			for (strl_t i = 0; i + n < len; i++)
+				work[i] = work[i + n];
+			len -= n;
+		} });
+	printf("  erase 64 characters at the front of 1MB until empty: erase %7.4fs  byte loop %7.4fs\n", a, b);
+	sink += work[0];
+	free(work);
+	free(source);
+}
+
+// code points of a text in one script, words of 2 to 9 letters between spaces and
+// punctuation, mixed changes script every few words and adds emoji
+enum corpus_script { CS_ASCII, CS_LATIN, CS_CYRILLIC, CS_CJK, CS_MIXED };
+static const char *corpus_names[] = { "ascii", "latin", "cyrillic", "cjk", "mixed" };
+
+static uint32_t corpus_letter(int script)
+{
+	switch (script) {
+		case CS_LATIN: return rnd() % 6 ? 'a' + rnd() % 26 : 0xe0 + rnd() % 0x1f;
+		case CS_CYRILLIC: return 0x430 + rnd() % 32;
+		case CS_CJK: return 0x4e00 + rnd() % 0x5000;
+		case CS_MIXED: return 0x1f600 + rnd() % 0x50;
+	}
+	return 'a' + rnd() % 26;
+}
+
+static strl_t corpus(uint32_t *codes, strl_t count, int script)
+{
+	strl_t n = 0;
+	int word_script = script;
+	while (n < count) {
+		if (script == CS_MIXED && !(rnd() % 4))
+			word_script = rnd() % 5;
+		strl_t len = word_script == CS_CJK ? 8 + rnd() % 24 : 2 + rnd() % 8;
+		for (strl_t i = 0; i < len && n < count; i++)
+			codes[n++] = corpus_letter(word_script);
+		if (n < count)
+			codes[n++] = rnd() % 8 ? ' ' : (rnd() % 2 ? ',' : '.');
+	}
+	return n;
+}
+
+// bulk utf8 conversions against a code point at a time with get_utf8 and push_utf8
+static void bench_transcode()
+{
+	printf("utf8 to and from utf16 and utf32, GB/s of utf8\n");
+	const strl_t count = 1 << 22;
+	uint32_t *codes = (uint32_t*)malloc(count * 4), *units32 = (uint32_t*)malloc(count * 4);
+	uint16_t *units16 = (uint16_t*)malloc(count * 4);
+	char *utf8 = (char*)malloc(count * 4), *back = (char*)malloc(count * 4);
+	for (int script = CS_ASCII; script <= CS_MIXED; script++) {
+		corpus(codes, count, script);
+		strovl text(utf8, count * 4);
+		text.append_utf32(codes, count);
+		strref t = text.get_strref();
+		strl_t n16 = t.to_utf16(units16, count * 2);
+		strl_t size = t.get_len();
+		printf("  %-8s %5.2f bytes per character\n", corpus_names[script], double(size) / count);
+
+		double a = best_time([&]() { sink += t.to_utf16(units16, count * 2); });
+		double b = best_time([&]() {
+			strl_t w = 0, skip;
+			for (strl_t r = 0; r < size; r += skip) {
+				size_t c = _strmod_read_utf8(utf8, size, r, skip);
+				if (c >= 0x10000) {
+					units16[w++] = uint16_t(0xd800 + ((c - 0x10000) >> 10));
+					units16[w++] = uint16_t(0xdc00 + (c & 0x3ff));
+				} else
+					units16[w++] = uint16_t(c);
+			}
+			sink += w; });
+		printf("    to_utf16     %6.2f  read_utf8 %6.2f\n", gbs(size, a), gbs(size, b));
+
+		a = best_time([&]() { sink += t.to_utf32(units32, count); });
+		b = best_time([&]() {
+			strl_t w = 0, skip;
+			for (strl_t r = 0; r < size; r += skip)
+				units32[w++] = uint32_t(_strmod_read_utf8(utf8, size, r, skip));
+			sink += w; });
+		printf("    to_utf32     %6.2f  read_utf8 %6.2f\n", gbs(size, a), gbs(size, b));
+
+		a = best_time([&]() {
+			strovl out(back, count * 4);
+			out.append_utf16(units16, n16);
+			sink += out.get_len(); });
+		b = best_time([&]() {
+			strovl out(back, count * 4);
+			for (strl_t r = 0; r < n16; r++) {
+				int c = units16[r];
+				if ((c & 0xfc00) == 0xd800 && (r + 1) < n16)
+					c = 0x10000 + ((c - 0xd800) << 10) + (units16[++r] - 0xdc00);
+				out.push_utf8(c);
+			}
+			sink += out.get_len(); });
+		printf("    append_utf16 %6.2f  push_utf8 %6.2f\n", gbs(size, a), gbs(size, b));
+
+		a = best_time([&]() {
+			strovl out(back, count * 4);
+			out.append_utf32(codes, count);
+			sink += out.get_len(); });
+		b = best_time([&]() {
+			strovl out(back, count * 4);
+			for (strl_t r = 0; r < count; r++)
+				out.push_utf8(int(codes[r]));
+			sink += out.get_len(); });
+		printf("    append_utf32 %6.2f  push_utf8 %6.2f\n", gbs(size, a), gbs(size, b));
+	}
+	free(back);
+	free(utf8);
+	free(units16);
+	free(units32);
+	free(codes);
+}
+
+struct bench_section {
+	const char *name;
+	void (*func)();
+};
+
+static const bench_section sections[] = {
+	{ "float", bench_float },
+	{ "hash", bench_hash },
+	{ "remove", bench_remove },
+	{ "replace", bench_replace },
+	{ "reverse", bench_reverse },
+	{ "transcode", bench_transcode },
+	{ "wildcard", bench_wildcard },
+};
+
+int main(int argc, char **argv)
+{
+	for (size_t s = 0; s < sizeof(sections) / sizeof(sections[0]); s++) {
+		if (argc < 2 || strref(argv[1]).same_str(sections[s].name))
+			sections[s].func();
+	}
+	return 0;
+}
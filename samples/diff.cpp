@@ -14,7 +14,7 @@
 #include <assert.h>
 
 typedef struct {
-	unsigned int hash;
+	uint64_t hash;
 	unsigned int line;
 } HashLookup;
 
@@ -42,15 +42,15 @@ unsigned char* ReadFile(const char *file, size_t &size) {
 }
 
 // get an ignore-whitespace hash for each line of a file
-unsigned int* LineByLineHash(strref file, strref **aLines, unsigned int &numLines) {
+uint64_t* LineByLineHash(strref file, strref **aLines, unsigned int &numLines) {
     int lines = file.count_lines();
     if (lines) {
-        unsigned int *hashes = new unsigned int[lines];
+        uint64_t *hashes = new uint64_t[lines];
 		strref *apLines = new strref[lines];
 		for (int curr=0; curr<lines; curr++) {
 			strref line = file.next_line(); // return line by line even if empty
 			apLines[curr] = line;
-            hashes[curr] = line.fnv1a();
+            hashes[curr] = line.hash64();
 		}
 		*aLines = apLines;
         numLines = lines;
@@ -80,12 +80,12 @@ int sortLineNumbers(const void *A, const void *B) {
 }
 
 // multi-hit binary search
-int LookupHashLookup(unsigned int value, HashLookup *lookup, int count)
+int LookupHashLookup(uint64_t value, HashLookup *lookup, int count)
 {
 	int first = 0;
     while (count!=first) {
         int index = (first+count)/2;
-        unsigned int read = lookup[index].hash;
+        uint64_t read = lookup[index].hash;
 		if (value==read) {
 			while (index && lookup[index-1].hash==value)
 				index--;
@@ -99,7 +99,7 @@ int LookupHashLookup(unsigned int value, HashLookup *lookup, int count)
 }
 
 void LineByLineBestMatch(LineMatches *matchBA, unsigned int numLinesA, unsigned int numLinesB,
-						 unsigned int *hashesA, unsigned int *hashesB, strref *aLinesA, strref *aLinesB)
+						 uint64_t *hashesA, uint64_t *hashesB, strref *aLinesA, strref *aLinesB)
 {
 	// step 1: make a sorted lookup for A for easier lookup from B
 	//		   (binary search)
@@ -112,7 +112,7 @@ void LineByLineBestMatch(LineMatches *matchBA, unsigned int numLinesA, unsigned
 
 	// step 2: find sequential matches going in B that exists in A
 	for (unsigned int lB = 0; lB<numLinesB; lB++) {
-		unsigned int hash = hashesB[lB];
+		uint64_t hash = hashesB[lB];
 		int lAI = LookupHashLookup(hash, lookupA, numLinesA);
 		if (lAI >= 0) {
 			int bestLineMatch = -1;
@@ -146,13 +146,13 @@ void LineByLineBestMatch(LineMatches *matchBA, unsigned int numLinesA, unsigned
 	}
 }
 
-void FindMatchingLines(LineMatches *matchBA, strref textA, unsigned int numLinesB, unsigned int *hashesB, strref *aLinesB)
+void FindMatchingLines(LineMatches *matchBA, strref textA, unsigned int numLinesB, uint64_t *hashesB, strref *aLinesB)
 {
 	unsigned int numHashA;
 	strref *aLinesA;
 
 	// step 1: convert original text to lines and hashes
-	unsigned int *hashesA = LineByLineHash(textA, &aLinesA, numHashA);
+	uint64_t *hashesA = LineByLineHash(textA, &aLinesA, numHashA);
 
 	// Find best matches for each line of B in A (number of sequential matching lines)
 	LineByLineBestMatch(matchBA, numHashA, numLinesB, hashesA, hashesB, aLinesA, aLinesB);
@@ -235,7 +235,7 @@ strovl CompareLines(strref textA, strref textB)
 	// step 1: convert new text (B) to lines and hashes
 	unsigned int numLinesB;
 	strref *aLinesB;
-	unsigned int *hashesB = LineByLineHash(textB, &aLinesB, numLinesB);
+	uint64_t *hashesB = LineByLineHash(textB, &aLinesB, numLinesB);
 
 	// step 2: find matching sequences in the original text (A)
 	LineMatches *matchBA = new LineMatches[numLinesB];
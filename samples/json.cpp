@@ -3,10 +3,12 @@
 
 #define JSON_STACK_SIZE 128		// max hierarchical depth of a json file
 
-#define PHASH(keyword, hash) (hash)
-#define JSON_KEYWORD_NULL PHASH("null", 0x77074ba4)
-#define JSON_KEYWORD_TRUE PHASH("true", 0x4db211e5)
-#define JSON_KEYWORD_FALSE PHASH("false", 0x0b069958)
+// keywords hashed at compile time
+using namespace struse_literals;
+
+#define JSON_KEYWORD_NULL "null"_fnv1a
+#define JSON_KEYWORD_TRUE "true"_fnv1a
+#define JSON_KEYWORD_FALSE "false"_fnv1a
 
 bool ParseJSON(strref json, JSONDataCB callback, void *user_data)
 {
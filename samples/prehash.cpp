@@ -25,8 +25,12 @@
 
 #define PHASH_EXTEND_CHARACTERS 12
 
+// edits queued before they are applied to the file
+#define PHASH_MAX_EDITS 1024
+#define PHASH_EDIT_TEXT 64*1024
+
 // trivial implementation to highlight how to use
-// wildcard search combined with exchange.
+// wildcard search combined with queued edits.
 bool prehash_search_and_replace(const char *file) {
     if (FILE *f = fopen(file, "rb")) {
         fseek(f, 0, SEEK_END);
@@ -45,9 +49,16 @@ bool prehash_search_and_replace(const char *file) {
             
             // find all instances of PHASH token
             // extra quotes inserted to allow running tool over this file
-            strref pattern("P""HASH(*{ \t}\"*@\"*{!\n\r/})");
+            strwild pattern("P""HASH(*{ \t}\"*@\"*{!\n\r/})");
             strref match;
             strown<PHASH_MAX_LENGTH> replace;
+            
+            // queue the exchanges and apply them together instead of moving
+            // the rest of the file for each match
+            static stredit_op ops[PHASH_MAX_EDITS];
+            static char text[PHASH_EDIT_TEXT];
+            stredit edits(ops, PHASH_MAX_EDITS, text, PHASH_EDIT_TEXT);
+            long grow = 0;
             while ((match = overlay.wildcard_after(pattern, match))) {
                 // get the keyword to hash
                 strref keyword = match.between('"', '"');
@@ -55,13 +66,23 @@ bool prehash_search_and_replace(const char *file) {
                 // generate a replacement to the original string
                 replace.sprintf("PHASH(\"" STRREF_FMT "\", 0x%08x)", STRREF_ARG(keyword), keyword.fnv1a());
                 
-                // exchange the match with the evaluated string
-                overlay.exchange(match, replace.get_strref());
+                // queue the exchange of the match with the evaluated string
+                strl_t pos = overlay.get_strref().substr_offs(match);
+                if (!edits.exchange(pos, match.get_len(), replace.get_strref())) {
+                    // out of edits, apply the queue and continue from the match in the edited text
+                    pos = strl_t(pos + grow);
+                    grow = 0;
+                    if (!overlay.commit(edits) || !edits.exchange(pos, match.get_len(), replace.get_strref()))
+                        break;
+                    match = strref(overlay.get() + pos, match.get_len());
+                }
+                grow += long(replace.get_len()) - long(match.get_len());
                 
                 // if about to run out of space, early out.
-                if (overlay.len()>(overlay.cap()-PHASH_EXTEND_CHARACTERS))
+                if ((overlay.len() + grow)>(overlay.cap()-PHASH_EXTEND_CHARACTERS))
                     break;
             }
+            overlay.commit(edits);
             
             // check if there was a change to the data
             if (size != overlay.len() || original_hash != overlay.fnv1a()) {
@@ -102,7 +123,7 @@ bool prehash_dual_buffer(const char *file) {
 
 				// find all instances of PHASH token
 				// extra quotes inserted to allow running tool over this file
-				strref pattern("P""HASH(*{ \t}\"*@\"*{!\n\r/})");
+				strwild pattern("P""HASH(*{ \t}\"*@\"*{!\n\r/})");
 				strl_t prevPos = 0;
 				strref match;
 				strown<PHASH_MAX_LENGTH> replace;
@@ -0,0 +1,869 @@
+// tests for struse.h
+//
+// Each search, parse, transcode and edit function is compared against a simple
+// reference on random input. The vector code paths depend on the compiler target
+// so build this more than once, see the Makefile:
+//
+//	default (SSE2 on x64, NEON on arm64), -mavx2 and -DSTRUSE_NO_SIMD
+
+#define STRUSE_IMPLEMENTATION
+#include "struse.h"
+#include <stdlib.h>
+#include <math.h>
+
+static int failures = 0;
+static int checks = 0;
+
+#define CHECK(test, ...) do { checks++; if (!(test)) { if (failures++ < 20) { \
+	printf("%s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } } while (0)
+
+// xorshift random numbers so every build tests the same input
+static uint64_t rnd_state = 0x2545f4914f6cdd1dULL;
+static uint32_t rnd() { rnd_state ^= rnd_state << 13; rnd_state ^= rnd_state >> 7;
+	rnd_state ^= rnd_state << 17; return (uint32_t)(rnd_state >> 16); }
+static uint32_t rnd(uint32_t n) { return n ? rnd() % n : 0; }
+
+// random text from an alphabet, long enough for several vector blocks
+static strl_t rnd_text(char *buf, strl_t max, const char *alphabet)
+{
+	strl_t n = (strl_t)strlen(alphabet);
+	strl_t len = rnd(8)==0 ? rnd(max) : rnd(max < 80 ? max : 80);
+	for (strl_t i = 0; i < len; i++)
+		buf[i] = alphabet[rnd(n)];
+	return len;
+}
+
+static char lower7(char c) { return (c>='A' && c<='Z') ? char(c+0x20) : c; }
+
+static bool ref_same(const char *a, const char *b, strl_t n, bool case_sensitive)
+{
+	for (strl_t i = 0; i < n; i++) {
+		if (case_sensitive ? a[i]!=b[i] : lower7(a[i])!=lower7(b[i]))
+			return false;
+	}
+	return true;
+}
+
+static int ref_find(const char *s, strl_t len, const char *f, strl_t flen, strl_t pos, bool case_sensitive)
+{
+	for (strl_t i = pos; flen && (i + flen) <= len; i++) {
+		if (ref_same(s + i, f, flen, case_sensitive))
+			return int(i);
+	}
+	return -1;
+}
+
+static int ref_find_last(const char *s, strl_t len, const char *f, strl_t flen, bool case_sensitive)
+{
+	for (strl_t i = len; flen && i >= flen; i--) {
+		if (ref_same(s + i - flen, f, flen, case_sensitive))
+			return int(i - flen);
+	}
+	return -1;
+}
+
+// character and substring searches
+static void test_find()
+{
+	char text[600], needle[32];
+	for (int it = 0; it < 20000; it++) {
+		strl_t len = rnd_text(text, sizeof(text), it&1 ? "abcdefgh" : "aAbBcC \n\t\x80\xff");
+		strref t(text, len);
+		char c = "abcAB \n\x80"[rnd(8)];
+		strl_t pos = rnd(len + 2);
+
+		int e = -1, l = -1;
+		for (strl_t i = 0; i < len; i++) {
+			if (text[i]==c) {
+				if (e < 0) e = int(i);
+				l = int(i);
+			}
+		}
+		CHECK(t.find(c)==e, "find('%c')", c);
+		CHECK(t.find_last(c)==l, "find_last('%c')", c);
+		int a = -1;
+		for (strl_t i = pos; i < len && a < 0; i++) {
+			if (text[i]==c) a = int(i);
+		}
+		CHECK(t.find_at(c, pos)==a, "find_at('%c', %u)", c, pos);
+		a = -1;
+		for (strl_t i = pos + 1; i < len && a < 0; i++) {
+			if (text[i]==c) a = int(i);
+		}
+		CHECK(t.find_after(c, pos)==a, "find_after('%c', %u)", c, pos);
+
+		strl_t nlen = 1 + rnd(it&2 ? 30 : 4);
+		if (rnd(2) && len) {
+			// needle taken from the text so there is a match
+			strl_t o = rnd(len);
+			if (nlen > (len - o)) nlen = len - o;
+			memcpy(needle, text + o, nlen);
+			if (rnd(2)) needle[rnd(nlen)] ^= 0x20;
+		} else
+			nlen = rnd_text(needle, nlen + 1, "abcAB ") + 1, needle[nlen-1] = 'a';
+		strref n(needle, nlen);
+		strl_t p = rnd(4) ? 0 : rnd(len);
+		CHECK(t.find(n, p)==ref_find(text, len, needle, nlen, p, false), "find(str, %u)", p);
+		CHECK(t.find_case(n, p)==ref_find(text, len, needle, nlen, p, true), "find_case(str, %u)", p);
+		CHECK(t.find_last(n)==ref_find_last(text, len, needle, nlen, false), "find_last(str)");
+		CHECK(t.find_last_case(n)==ref_find_last(text, len, needle, nlen, true), "find_last_case(str)");
+		int rh = ref_find(text, len, needle, nlen, p, false);
+		CHECK(t.find_rh(n, p)==(rh < 0 ? -1 : rh - int(p)), "find_rh(str, %u)", p);
+
+		bool cs = rnd(2)!=0;
+		strref_searcher searcher(n, cs);
+		CHECK(searcher.find(t, p)==ref_find(text, len, needle, nlen, p, cs), "strref_searcher.find");
+		int count = 0, ref_count = 0;
+		for (int o = ref_find(text, len, needle, nlen, 0, cs); o >= 0; o = ref_find(text, len, needle, nlen, strl_t(o + 1), cs))
+			ref_count++;
+		for (strref match : searcher.all(t)) {
+			CHECK(ref_same(match.get(), needle, nlen, cs), "strref_searcher.all");
+			count++;
+		}
+		CHECK(count==ref_count, "strref_searcher.all %d matches, expected %d", count, ref_count);
+	}
+}
+
+// character classes
+static void test_range()
+{
+	const char *ranges[] = { "a", "0-9", "a-zA-Z", "!a-z", "aeiouAEIOU", "\\x00-\\x20", "a-c e-g x-z 0-2 5-7", "\\x80-\\xff", "!\\x20-\\x7e", "ab!-" };
+	char text[600];
+	for (int it = 0; it < 20000; it++) {
+		strl_t len = rnd_text(text, sizeof(text), "abcxyz019 !-\n\x01\x7f\x80\xe9\xff");
+		strref t(text, len);
+		strrange r(strref(ranges[it % 10]), rnd(4)!=0);
+		strl_t pos = rnd(len + 1);
+		int f = -1, fn = -1;
+		for (strl_t i = pos; i < len; i++) {
+			if (f < 0 && r.has(text[i])) f = int(i);
+			if (fn < 0 && !r.has(text[i])) fn = int(i);
+		}
+		strl_t span = 0;
+		while ((pos + span) < len && r.has(text[pos + span]))
+			span++;
+		CHECK(r.find(t, pos)==f, "strrange(%s).find", ranges[it % 10]);
+		CHECK(r.find_not(t, pos)==fn, "strrange(%s).find_not", ranges[it % 10]);
+		CHECK(r.len(t, pos)==span, "strrange(%s).len", ranges[it % 10]);
+		CHECK(t.find_any_char_or_range(r, pos)==f, "find_any_char_or_range(%s)", ranges[it % 10]);
+		CHECK(t.find_any_not_in_range(r, pos)==fn, "find_any_not_in_range(%s)", ranges[it % 10]);
+	}
+}
+
+// text, pattern, case sensitive and the expected match, -1 for none
+struct wildcard_case {
+	const char *text, *pattern;
+	bool case_sensitive;
+	int pos;
+	strl_t len;
+};
+
+// word and line anchors
+static const wildcard_case wildcard_anchors[] = {
+	{ "xab ab", "<ab", true, 4, 2 }, { "x.ab", "<ab", true, 2, 2 }, { "abc ab", "ab>", true, 4, 2 },
+	{ "ab", "ab>", true, 0, 2 }, { "ab", "<ab>", true, 0, 2 }, { "xab cab", "<ab>", true, -1, 0 },
+	{ "it's", "<it>", true, -1, 0 }, { "one. two", "<two>", true, 5, 3 }, { "AB ab", "<ab>", true, 3, 2 },
+	{ "AB ab", "<ab>", false, 0, 2 }, { "cab ab", "<a*b>", true, 4, 2 }, { "one two three", "<t*>", true, 4, 3 },
+	{ "don't stop", "<*>", true, 0, 5 }, { "xy ab cd", "<?b", true, 3, 2 }, { "a1 b22", "<#", true, -1, 0 },
+	{ "a1 b22 33", "<##>", true, 7, 2 }, { "ab\ncd", "@cd", true, 3, 2 }, { "ab\ncd", "ab^", true, 0, 2 },
+	{ "xab\ncd ab", "ab^", true, 1, 2 }, { "ab\ncd", "^\\ncd", true, 2, 3 }, { "one two\nthree", "@t*^", true, 8, 5 },
+	{ "ab\ncd\nef", "@*@f", true, 6, 2 }, { "ab\ncd\nef", "c*@f", true, -1, 0 }, { "ab\ncd\nef", "@?d^", true, 3, 2 },
+	{ "ab cd\nef gh", "<cd^", true, 3, 2 }, { "abcd", "@a", true, 0, 1 },
+};
+
+// single characters and escaped control characters
+static const wildcard_case wildcard_singles[] = {
+	{ "a.b ab", "a?b", true, 0, 3 }, { "xaxb", "a?b", true, 1, 3 }, { "ab", "a?", true, 0, 2 },
+	{ "a", "a?", true, -1, 0 }, { "ab axxb", "a??b", true, 3, 4 }, { "x1y22z", "#", true, 1, 1 },
+	{ "x1y22z", "##", true, 3, 2 }, { "abc", "[!a]", true, 1, 1 }, { "abc abd", "ab[!c]", true, 4, 3 },
+	{ "a*b", "a\\*b", true, 0, 3 }, { "xa*b", "a\\*b", true, 1, 3 }, { "axb a?b", "a\\?b", true, 4, 3 },
+	{ "a[b]", "a\\[b", true, 0, 3 }, { "a<b", "a\\<b", true, 0, 3 },
+};
+
+// patterns the automaton takes, including near misses that make backtracking slow
+static const wildcard_case wildcard_automaton[] = {
+	{ "aaaaaaaaab", "*a*a*b", true, 0, 10 }, { "aaaaaaaaaa", "*a*a*b", true, -1, 0 },
+	{ "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab", "*a*a*a*b", true, 0, 37 }, { "aaaaaaaaaaaaaaaaaaaab aab", "a*a*b", true, 0, 21 },
+	{ "abababababababababac", "*a*b*c", true, 0, 20 }, { "abababababababababa", "*a*b*c", true, -1, 0 },
+	{ "aabab", "a*b", true, 0, 3 }, { "xaaaab", "a*b", true, 1, 5 }, { "aabbc", "a*{ab}", true, 0, 4 },
+	{ "ab cd", "a*%", true, 0, 2 }, { "a1b2", "*$", true, 0, 4 }, { "xAb", "ab", false, 1, 2 },
+	{ "xAb", "ab", true, -1, 0 }, { "hello.png full.png", "full*{! }.png", true, 10, 8 }, { "aaaa\naab", "a*@b", true, 5, 3 },
+	{ "a.b ab", "a?b", true, 0, 3 }, { "abc abd", "ab[!c]", true, 4, 3 },
+};
+
+static void check_wildcard(const wildcard_case *cases, int count)
+{
+	for (int k = 0; k < count; k++) {
+		const wildcard_case &c = cases[k];
+		strref t(c.text);
+		for (int e = SWE_BACKTRACK; e <= SWE_AUTOMATON; e++) {
+			strref m = t.find_wildcard(strwild(strref(c.pattern), c.case_sensitive, STRWILD_ENGINE(e)));
+			CHECK(c.pos < 0 ? !m.valid() : (m.get()==(t.get() + c.pos) && m.get_len()==c.len),
+				  "wildcard '%s' on '%s' engine %d", c.pattern, c.text, e);
+		}
+	}
+}
+
+// wildcard matches with known answers, then random patterns where both engines must agree
+static void test_wildcard()
+{
+	check_wildcard(wildcard_anchors, int(sizeof(wildcard_anchors) / sizeof(wildcard_anchors[0])));
+	check_wildcard(wildcard_singles, int(sizeof(wildcard_singles) / sizeof(wildcard_singles[0])));
+	check_wildcard(wildcard_automaton, int(sizeof(wildcard_automaton) / sizeof(wildcard_automaton[0])));
+	for (size_t k = 0; k < sizeof(wildcard_automaton) / sizeof(wildcard_automaton[0]); k++) {
+		const wildcard_case &c = wildcard_automaton[k];
+		CHECK(strwild(strref(c.pattern), c.case_sensitive, SWE_AUTOMATON).get_engine()==SWE_AUTOMATON, "automaton for '%s'", c.pattern);
+	}
+
+	// long near misses only the automaton finishes quickly
+	static char run[4000];
+	strwild aab(strref("*a*a*b"), true, SWE_AUTOMATON), abc(strref("*a*b*c"), true, SWE_AUTOMATON);
+	memset(run, 'a', sizeof(run));
+	strref r(run, strl_t(sizeof(run)));
+	CHECK(!r.find_wildcard(aab).valid(), "*a*a*b on a run of a");
+	run[sizeof(run) - 1] = 'b';
+	CHECK(r.find_wildcard(aab).get()==run && r.find_wildcard(aab).get_len()==sizeof(run), "*a*a*b on a run of a ending in b");
+	for (size_t i = 0; i < sizeof(run); i++)
+		run[i] = "ab"[i & 1];
+	CHECK(!r.find_wildcard(abc).valid(), "*a*b*c on ab repeated");
+	run[sizeof(run) - 1] = 'c';
+	CHECK(r.find_wildcard(abc).get()==run && r.find_wildcard(abc).get_len()==sizeof(run), "*a*b*c on ab repeated ending in c");
+
+	const char *tokens[] = { "a", "b", "ab", "abc", " ", "*", "*%", "*@", "*$", "*{ab}", "*{!a}", "*{a-c }", "?", "#", "[ab]", "[!a]", "[a-c]", "\\*", "x",
+		"<", ">", "@", "^" };
+	char text[400], pattern[64];
+	for (int it = 0; it < 20000; it++) {
+		strl_t plen = 0;
+		for (int i = 1 + rnd(5); i; i--) {
+			const char *tok = tokens[rnd(sizeof(tokens) / sizeof(tokens[0]))];
+			memcpy(pattern + plen, tok, strlen(tok));
+			plen += (strl_t)strlen(tok);
+		}
+		strl_t len = rnd_text(text, sizeof(text), "aabbcx 1\n.");
+		strref t(text, len);
+		bool cs = rnd(2)!=0;
+		strwild backtrack(strref(pattern, plen), cs), automaton(strref(pattern, plen), cs, SWE_AUTOMATON);
+		strl_t pos = rnd(len + 1);
+		strref x = t.find_wildcard(backtrack, pos), y = t.find_wildcard(automaton, pos);
+		CHECK(x.get()==y.get() && x.get_len()==y.get_len(), "wildcard engines differ on '%.*s'", (int)plen, pattern);
+	}
+}
+
+// multi pattern search
+static void test_multi()
+{
+	char text[300], pats[12][8];
+	strl_t plens[12];
+	for (int it = 0; it < 5000; it++) {
+		bool cs = rnd(2)!=0;
+		strmulti_node nodes[64];
+		strmulti m(nodes, 64, cs);
+		int np = 1 + rnd(10), added = 0;
+		int ref_hits = 0;
+		strl_t len = rnd_text(text, sizeof(text), "abcAB1");
+		for (int i = 0; i < np; i++) {
+			plens[added] = 1 + rnd(5);
+			for (strl_t j = 0; j < plens[added]; j++)
+				pats[added][j] = "abcAB1"[rnd(6)];
+			bool dup = false;
+			for (int j = 0; j < added; j++)
+				dup = dup || (plens[j]==plens[added] && ref_same(pats[j], pats[added], plens[j], cs));
+			if (dup || m.add(strref(pats[added], plens[added])) < 0)
+				continue;
+			for (int o = ref_find(text, len, pats[added], plens[added], 0, cs); o >= 0;
+				 o = ref_find(text, len, pats[added], plens[added], strl_t(o + 1), cs))
+				ref_hits++;
+			added++;
+		}
+		m.build();
+		strmulti_hit hit;
+		int hits = 0;
+		strl_t last_end = 0;
+		while (m.next(strref(text, len), hit)) {
+			CHECK(hit.pattern>=0 && hit.pattern<added && hit.len==plens[hit.pattern] &&
+				  ref_same(text + hit.pos, pats[hit.pattern], hit.len, cs), "strmulti hit");
+			CHECK((hit.pos + hit.len)>=last_end, "strmulti order");
+			last_end = hit.pos + hit.len;
+			hits++;
+		}
+		CHECK(hits==ref_hits, "strmulti %d hits, expected %d", hits, ref_hits);
+	}
+}
+
+// hashes that have an equivalent on modified text
+static void test_hash()
+{
+	char text[600], copy[640], ref[600];
+	for (int it = 0; it < 20000; it++) {
+		strl_t len = rnd_text(text, sizeof(text), "abcABC  \t\n\r\x01\x80");
+		uint64_t seed = rnd(4) ? 0 : rnd();
+		strl_t o = rnd(32);
+		memcpy(copy + o, text, len);
+		CHECK(strref(text, len).hash64(seed)==strref(copy + o, len).hash64(seed), "hash64 depends on alignment");
+
+		for (strl_t i = 0; i < len; i++)
+			ref[i] = lower7(text[i]);
+		CHECK(strref(text, len).hash64_lower(seed)==strref(ref, len).hash64(seed), "hash64_lower");
+
+		strl_t n = 0;
+		for (strl_t i = 0; i < len; i++) {
+			if ((uint8_t)text[i] <= 0x20) {
+				if (!n || ref[n-1]!=' ' || (uint8_t)text[i-1] > 0x20) ref[n++] = ' ';
+			} else
+				ref[n++] = text[i];
+		}
+		CHECK(strref(text, len).hash64_ws(seed)==strref(ref, n).hash64(seed), "hash64_ws");
+	}
+}
+
+// number parsing and writing
+static void test_numbers()
+{
+	char text[64];
+	for (int it = 0; it < 50000; it++) {
+		int64_t v = int64_t(((uint64_t)rnd() << 32) | rnd()) >> rnd(64);
+		int n = snprintf(text, sizeof(text), "%lld", (long long)v);
+		int64_t p;
+		CHECK(strref(text, n).parse_int(p)==strl_t(n) && p==v, "parse_int(%s)", text);
+		uint64_t u = (((uint64_t)rnd() << 32) | rnd()) >> rnd(64), pu;
+		n = snprintf(text, sizeof(text), "%llu", (unsigned long long)u);
+		CHECK(strref(text, n).parse_uint(pu)==strl_t(n) && pu==u, "parse_uint(%s)", text);
+		n = snprintf(text, sizeof(text), "%llx", (unsigned long long)u);
+		CHECK(strref(text, n).ahextou64()==u, "ahextou64(%s)", text);
+		n = snprintf(text, sizeof(text), "%X", (unsigned int)u);
+		CHECK(strref(text, n).ahextoui()==(unsigned int)u, "ahextoui(%s)", text);
+		n = 0;
+		for (uint32_t b = (uint32_t)u, k = 1 + rnd(32); k; k--)
+			text[n++] = char('0' + ((b >> (k - 1)) & 1));
+		text[n] = 0;
+		strref bin(text, n);
+		CHECK(bin.abinarytoui_skip()==(uint32_t)strtoul(text, nullptr, 2) && !bin.get_len(), "abinarytoui_skip(%.*s)", n, text);
+
+		strown<64> out;
+		out.append_int64(v);
+		n = snprintf(text, sizeof(text), "%lld", (long long)v);
+		CHECK(out.same_str_case(strref(text, n)), "append_int64(%s)", text);
+		out.clear();
+		out.append_hex(u, 0, (u & 1)!=0);
+		n = snprintf(text, sizeof(text), (u & 1) ? "%llX" : "%llx", (unsigned long long)u);
+		CHECK(out.same_str_case(strref(text, n)), "append_hex(%s)", text);
+
+		// doubles read back exactly
+		uint64_t bits = ((uint64_t)rnd() << 32) | rnd();
+		double d;
+		memcpy(&d, &bits, sizeof(d));
+		if (d!=d || isinf(d))
+			d = double(v) / 1024.0;
+		out.clear();
+		out.append_double(d);
+		double back;
+		CHECK(out.get_strref().parse_double(back)==out.get_len() && back==d, "append_double(%.17g) wrote " STRREF_FMT, d, STRREF_ARG(out));
+		n = snprintf(text, sizeof(text), "%.*g", 1 + (int)rnd(17), d);
+		CHECK(strref(text, n).parse_double(back)==strl_t(n) && back==strtod(text, nullptr), "parse_double(%s)", text);
+		float f = float(d), fb;
+		if (f==f && !isinf(f)) {
+			n = snprintf(text, sizeof(text), "%.*g", 1 + (int)rnd(9), f);
+			CHECK(strref(text, n).parse_float(fb)==strl_t(n) && fb==strtof(text, nullptr), "parse_float(%s)", text);
+			out.clear();
+			out.append_float(f);
+			CHECK(out.get_strref().parse_float(fb)==out.get_len() && fb==f, "append_float(%.9g) wrote " STRREF_FMT, f, STRREF_ARG(out));
+		}
+	}
+}
+
+// compiled and scanned formats write the same text
+static void test_format()
+{
+	const char *parts[] = { "abc", " ", "{0}", "{1}", "{2:8}", "{0:08}", "{1:x}", "{2:X08}", "{3}", "\\n", "{4:5}" };
+	char fmt[128];
+	for (int it = 0; it < 20000; it++) {
+		strl_t flen = 0;
+		for (int i = 1 + rnd(6); i; i--) {
+			const char *p = parts[rnd(sizeof(parts) / sizeof(parts[0]))];
+			memcpy(fmt + flen, p, strlen(p));
+			flen += (strl_t)strlen(p);
+		}
+		strref f(fmt, flen);
+		int64_t i = int64_t(rnd()) - (1ll << 31);
+		double d = double(int(rnd())) / 8.0;
+		uint32_t u = rnd();
+		strown<256> a, b;
+		a.format(f, i, "str", u, d, 'c');
+		b.format(strformat(f), i, "str", u, d, 'c');
+		CHECK(a.same_str_case(b.get_strref()), "format('%.*s') " STRREF_FMT " != " STRREF_FMT, (int)flen, fmt, STRREF_ARG(a), STRREF_ARG(b));
+
+		// short buffers are cut off at the same place and nothing is written after them
+		char guard[48];
+		strl_t cap = rnd(17);
+		memset(guard, '#', sizeof(guard));
+		strovl sa(guard, cap);
+		sa.format(f, i, "str", u, d, 'c');
+		strovl sb(guard + 24, cap);
+		sb.format(strformat(f), i, "str", u, d, 'c');
+		CHECK(sa.get_len()<=cap && sb.get_len()<=cap && sa.same_str_case(sb.get_strref()), "format into %u characters", cap);
+		CHECK(guard[cap]=='#' && guard[24 + cap]=='#', "format wrote past %u characters", cap);
+	}
+
+	// floats are written as the shortest float, not the double they promote to
+	strown<32> fl;
+	fl.format("{0} {1}", 0.1f, 0.1);
+	CHECK(fl.same_str_case(strref("0.1 0.1")), "format(float) wrote " STRREF_FMT, STRREF_ARG(fl));
+
+	// zero padded negative number right after text that fills the buffer
+	char small[4 + 16];
+	memset(small, '#', sizeof(small));
+	strovl o(small, 4);
+	o.format(strformat("abcd{0:08}"), -5);
+	CHECK(o.get_len()==4 && small[4]=='#', "format past full buffer");
+	o.clear();
+	o.format(strformat("abc{0:08}"), -5);
+	CHECK(o.same_str_case(strref("abc-")) && small[4]=='#', "format sign at end of buffer");
+}
+
+// code page case tables and the bulk conversions that use them
+static void test_code_pages()
+{
+	// cp437 pairs: c cedilla, u, e acute, a umlaut, a ring, ae, o umlaut, n tilde
+	static const uint8_t cp437[][2] = { { 0x87, 0x80 }, { 0x81, 0x9a }, { 0x82, 0x90 }, { 0x84, 0x8e },
+		{ 0x86, 0x8f }, { 0x91, 0x92 }, { 0x94, 0x99 }, { 0xa4, 0xa5 } };
+	for (size_t i = 0; i < sizeof(cp437) / sizeof(cp437[0]); i++) {
+		CHECK((uint8_t)strref::toupper_win((char)cp437[i][0])==cp437[i][1], "toupper_win(%02x)", cp437[i][0]);
+		CHECK((uint8_t)strref::tolower_win((char)cp437[i][1])==cp437[i][0], "tolower_win(%02x)", cp437[i][1]);
+	}
+
+	// a character that changes case changes back
+	char (*lower[])(char) = { strref::tolower, strref::tolower_win, strref::tolower_amiga, strref::tolower_macos };
+	char (*upper[])(char) = { strref::toupper, strref::toupper_win, strref::toupper_amiga, strref::toupper_macos };
+	for (int p = 0; p < 4; p++) {
+		for (int c = 0; c < 256; c++) {
+			char l = lower[p]((char)c), u = upper[p]((char)c);
+			CHECK(l==(char)c || upper[p](l)==(char)c, "code page %d lower %02x and back", p, c);
+			CHECK(u==(char)c || lower[p](u)==(char)c, "code page %d upper %02x and back", p, c);
+		}
+	}
+
+	// whole strings a vector at a time against one character at a time
+	char text[600], buf[600];
+	for (int it = 0; it < 5000; it++) {
+		strl_t len = rnd(it&1 ? 600 : 40);
+		for (strl_t i = 0; i < len; i++)
+			text[i] = char(rnd(4) ? 'A' + rnd(58) : rnd(256));
+		int p = int(rnd(4));
+		bool up = rnd(2)!=0;
+		strovl o(buf, sizeof(buf));
+		o.copy(strref(text, len));
+		switch (p) {
+			case 0: if (up) o.toupper(); else o.tolower(); break;
+			case 1: if (up) o.toupper_win(); else o.tolower_win(); break;
+			case 2: if (up) o.toupper_amiga(); else o.tolower_amiga(); break;
+			default: if (up) o.toupper_macos(); else o.tolower_macos(); break;
+		}
+		bool same = o.get_len()==len;
+		for (strl_t i = 0; i < len && same; i++)
+			same = buf[i]==(up ? upper[p] : lower[p])(text[i]);
+		CHECK(same, "code page %d %s on %u characters", p, up ? "toupper" : "tolower", len);
+	}
+}
+
+static uint32_t ref_lower_utf32(uint32_t c)
+{
+	if ((c>='A' && c<='Z') || (c>=0xc0 && c<=0xde && c!=0xd7) || (c>=0x391 && c<=0x3ab && c!=0x3a2) || (c>=0x410 && c<=0x42f))
+		return c + 0x20;
+	if (c>=0x400 && c<=0x40f)
+		return c + 0x50;
+	return c;
+}
+
+static strl_t ref_utf8_encode(char *o, uint32_t c)
+{
+	if (c < 0x80) { o[0] = char(c); return 1; }
+	if (c < 0x800) { o[0] = char(0xc0 | (c>>6)); o[1] = char(0x80 | (c & 0x3f)); return 2; }
+	if (c < 0x10000) { o[0] = char(0xe0 | (c>>12)); o[1] = char(0x80 | ((c>>6) & 0x3f)); o[2] = char(0x80 | (c & 0x3f)); return 3; }
+	o[0] = char(0xf0 | (c>>18)); o[1] = char(0x80 | ((c>>12) & 0x3f)); o[2] = char(0x80 | ((c>>6) & 0x3f)); o[3] = char(0x80 | (c & 0x3f));
+	return 4;
+}
+
+// decode utf8 where each byte that does not start a well formed character is 0xfffd
+static strl_t ref_utf8_decode(const char *s, strl_t len, uint32_t *out, bool &valid)
+{
+	strl_t n = 0;
+	valid = true;
+	for (strl_t i = 0; i < len;) {
+		uint8_t c = (uint8_t)s[i];
+		strl_t k = c < 0x80 ? 1 : (c>=0xc2 && c<0xe0) ? 2 : (c>=0xe0 && c<0xf0) ? 3 : (c>=0xf0 && c<0xf5) ? 4 : 0;
+		uint32_t cp = k==1 ? c : (c & (0x7f >> k));
+		bool ok = k && (i + k) <= len;
+		for (strl_t j = 1; ok && j < k; j++) {
+			uint8_t x = (uint8_t)s[i + j];
+			if ((x & 0xc0)!=0x80) ok = false;
+			cp = (cp << 6) | (x & 0x3f);
+		}
+		if ((k==3 && (cp < 0x800 || (cp>=0xd800 && cp<0xe000))) || (k==4 && (cp < 0x10000 || cp > 0x10ffff)))
+			ok = false;
+		out[n++] = ok ? cp : 0xfffd;
+		i += ok ? k : 1;
+		valid = valid && ok;
+	}
+	return n;
+}
+
+// utf16 units as utf8 where unpaired surrogates are 0xfffd
+static strl_t ref_utf16_to_utf8(char *o, const uint16_t *u, strl_t units)
+{
+	strl_t n = 0;
+	for (strl_t i = 0; i < units; i++) {
+		uint32_t c = u[i];
+		if ((c & 0xfc00)==0xd800 && (i + 1) < units && (u[i + 1] & 0xfc00)==0xdc00)
+			c = 0x10000 + ((c - 0xd800) << 10) + (u[++i] - 0xdc00);
+		else if ((c & 0xf800)==0xd800)
+			c = 0xfffd;
+		n += ref_utf8_encode(o + n, c);
+	}
+	return n;
+}
+
+// code points from blocks where ref_lower_utf32 is the whole case mapping
+static uint32_t rnd_code_point()
+{
+	static const uint32_t edges[] = { 0x7f, 0x80, 0x7ff, 0x800, 0xd7ff, 0xe000, 0xfffd, 0xffff, 0x10000, 0x10ffff };
+	switch (rnd(7)) {
+		case 0: return 0x20 + rnd(0x5f);
+		case 1: return 0x20 + rnd(0x5f);
+		case 2: return 0xa0 + rnd(0x60);
+		case 3: return rnd(2) ? 0x391 + rnd(0x39) : 0x400 + rnd(0x50);
+		case 4: return rnd(2) ? 0x800 + rnd(0x800) : 0x3040 + rnd(0x6fc0);
+		case 5: return edges[rnd(sizeof(edges) / sizeof(edges[0]))];
+		default: return 0x20000 + rnd(0xe0000);
+	}
+}
+
+// utf-8 validation, counting, transcoding and case
+static void test_utf8()
+{
+	// code point, lowercase and uppercase, some change size in utf8
+	static const uint32_t sizing[][3] = { { 'a', 'a', 'A' }, { 'B', 'b', 'B' }, { '.', '.', '.' },
+		{ 0xe9, 0xe9, 0xc9 }, { 0x23a, 0x2c65, 0x23a }, { 0x2c65, 0x2c65, 0x23a }, { 0x2c62, 0x26b, 0x2c62 },
+		{ 0x26b, 0x26b, 0x2c62 }, { 0x130, 'i', 0x130 }, { 0x131, 0x131, 'I' }, { 0x212a, 'k', 0x212a },
+		{ 0x17f, 0x17f, 'S' }, { 0x2126, 0x3c9, 0x2126 }, { 0x3c9, 0x3c9, 0x3a9 }, { 0x4e00, 0x4e00, 0x4e00 } };
+	char text[1200], lower[1200], out[1200], ref[1800], mixed[160];
+	uint32_t cps[300], cps_lower[300], u32[1200], ref32[1200];
+	uint16_t u16[600], part[600];
+	strl_t ends[40];
+	for (int it = 0; it < 20000; it++) {
+		int n = int(rnd(it&1 ? 300 : 40));
+		strl_t len = 0, len_lower = 0;
+		for (int i = 0; i < n; i++) {
+			cps[i] = rnd_code_point();
+			cps_lower[i] = ref_lower_utf32(cps[i]);
+			len += ref_utf8_encode(text + len, cps[i]);
+			len_lower += ref_utf8_encode(lower + len_lower, cps_lower[i]);
+		}
+		strref t(text, len);
+		CHECK(t.valid_utf8(), "valid_utf8");
+		CHECK(t.count_utf8_chars()==strl_t(n), "count_utf8_chars");
+		strl_t at = rnd(n + 2), off = 0;
+		for (strl_t i = 0; i < at && i < strl_t(n); i++)
+			off += ref_utf8_encode(out, cps[i]);
+		CHECK(t.utf8_offset_of(at)==(at > strl_t(n) ? -1 : int(off)), "utf8_offset_of(%u)", at);
+
+		strl_t units = 0;
+		for (int i = 0; i < n; i++)
+			units += cps[i] >= 0x10000 ? 2 : 1;
+		CHECK(t.utf16_len()==units, "utf16_len");
+		strl_t read = 0;
+		CHECK(t.to_utf32(u32, 300, &read)==strl_t(n) && read==len && !memcmp(u32, cps, n * sizeof(uint32_t)), "to_utf32");
+		CHECK(t.to_utf16(u16, 600, &read)==units && read==len, "to_utf16");
+		strovl o(out, sizeof(out));
+		CHECK(o.append_utf16(u16, units)==units && o.same_str_case(t), "append_utf16");
+		o.clear();
+		CHECK(o.append_utf32(u32, n)==strl_t(n) && o.same_str_case(t), "append_utf32");
+
+		// output that runs out of room ends on a whole character
+		strl_t cap = rnd(units + 1), w = t.to_utf16(part, cap, &read);
+		CHECK(w<=cap && !memcmp(part, u16, w * sizeof(uint16_t)) && strref(text, read).utf16_len()==w, "to_utf16 into %u units", cap);
+		cap = rnd(len + 1);
+		strovl small(out, cap);
+		read = small.append_utf16(u16, units);
+		CHECK(small.get_len()<=cap && small.same_str_case(strref(text, small.get_len())) &&
+			  strref(text, small.get_len()).utf16_len()==read, "append_utf16 into %u characters", cap);
+
+		// unpaired surrogates
+		if (units) {
+			memcpy(part, u16, units * sizeof(uint16_t));
+			part[rnd(units)] = uint16_t(0xd800 + rnd(0x800));
+			strl_t rn = ref_utf16_to_utf8(ref, part, units);
+			o.clear();
+			o.append_utf16(part, units);
+			CHECK(o.same_str_case(strref(ref, rn)), "append_utf16 with an unpaired surrogate");
+		}
+
+		o.copy(t);
+		o.tolower_utf8();
+		CHECK(o.same_str_case(strref(lower, len_lower)), "tolower_utf8");
+		CHECK(t.same_str_utf8(strref(lower, len_lower)), "same_str_utf8");
+		if (n) {
+			int a = int(rnd(n)), b = a + int(rnd(n - a));
+			strl_t s = 0, e = 0;
+			for (int i = 0; i < n; i++) {
+				if (i < a) s += ref_utf8_encode(out, cps_lower[i]);
+				if (i <= b) e += ref_utf8_encode(out, cps_lower[i]);
+			}
+			int f = t.find_utf8(strref(lower + s, e - s));
+			CHECK(f>=0 && f<=int(strl_t(t.utf8_offset_of(strl_t(a)))), "find_utf8");
+		}
+
+		// in place case changes where characters grow and shrink, with the buffer exactly
+		// full or too short so the result ends at the last whole character that fits
+		for (int upper = 0; upper < 2; upper++) {
+			int mn = int(rnd(40));
+			strl_t mlen = 0, full = 0, fit = 0;
+			for (int i = 0; i < mn; i++) {
+				const uint32_t *c = sizing[rnd(sizeof(sizing) / sizeof(sizing[0]))];
+				mlen += ref_utf8_encode(mixed + mlen, c[0]);
+				full += ref_utf8_encode(ref + full, c[1 + upper]);
+				ends[i] = full;
+			}
+			strl_t cap = full > mlen ? (rnd(2) ? full : mlen + rnd(full - mlen)) : mlen;
+			for (int i = 0; i < mn && ends[i] <= cap; i++)
+				fit = ends[i];
+			strovl m(out, cap);
+			m.copy(strref(mixed, mlen));
+			if (upper)
+				m.toupper_utf8();
+			else
+				m.tolower_utf8();
+			CHECK(m.same_str_case(strref(ref, fit)), "%s in place into %u bytes", upper ? "toupper_utf8" : "tolower_utf8", cap);
+		}
+
+		// broken sequences
+		if (len) {
+			text[rnd(len)] = char("\x80\xbf\xc0\xc1\xf5\xff\xe0\xed"[rnd(8)]);
+			bool valid;
+			strl_t rn = ref_utf8_decode(text, len, ref32, valid);
+			CHECK(t.to_utf32(u32, 1200, &read)==rn && read==len && !memcmp(u32, ref32, rn * sizeof(uint32_t)), "to_utf32 on broken text");
+			CHECK(t.valid_utf8()==valid, "valid_utf8 on broken text");
+		}
+	}
+}
+
+// in place edits
+static void test_edit()
+{
+	char text[700], ref[2400], buf[1400], from[6][16], to[6][16];
+	for (int it = 0; it < 20000; it++) {
+		strl_t len = rnd_text(text, 600, "abAB \r\n\t.\x80");
+		strovl o(buf, sizeof(buf));
+
+		// remove a character
+		char c = "a\r\n\x80"[rnd(4)];
+		strl_t n = 0;
+		for (strl_t i = 0; i < len; i++)
+			if (text[i]!=c) ref[n++] = text[i];
+		o.copy(strref(text, len));
+		o.remove(c);
+		CHECK(o.same_str_case(strref(ref, n)), "remove(char)");
+
+		// remove a range or everything outside it
+		strrange r(strref(it&1 ? "a-z" : "\\x00-\\x20"));
+		bool in = rnd(2)!=0;
+		n = 0;
+		for (strl_t i = 0; i < len; i++)
+			if (r.has(text[i])!=in) ref[n++] = text[i];
+		o.copy(strref(text, len));
+		o.remove(r, in);
+		CHECK(o.same_str_case(strref(ref, n)), "remove(range, %d)", in);
+
+		// erase and exchange
+		strl_t pos = rnd(len + 2), size = rnd(20), ins = rnd(30);
+		n = 0;
+		if (pos <= len) {
+			strl_t cut = size < (len - pos) ? size : len - pos;
+			memcpy(ref, text, pos);
+			memcpy(ref + pos, text + pos + cut, len - pos - cut);
+			n = len - cut;
+		} else {
+			memcpy(ref, text, len);
+			n = len;
+		}
+		o.copy(strref(text, len));
+		o.erase(pos, size);
+		CHECK(o.same_str_case(strref(ref, n)), "erase(%u, %u)", pos, size);
+		if (pos <= len) {
+			memmove(ref + pos + ins, ref + pos, n - pos);
+			memset(ref + pos, 'Q', ins);
+			n += ins;
+		}
+		o.copy(strref(text, len));
+		char q[30];
+		memset(q, 'Q', sizeof(q));
+		o.exchange(pos, size, strref(q, ins));
+		CHECK(o.same_str_case(strref(ref, n)), "exchange(%u, %u, %u)", pos, size, ins);
+
+		// replace and replace_many with one pair do the same
+		strl_t fl = 1 + rnd(3), tl = rnd(5);
+		for (strl_t i = 0; i < fl; i++) from[0][i] = "ab "[rnd(3)];
+		for (strl_t i = 0; i < tl; i++) to[0][i] = "xyz"[rnd(3)];
+		n = 0;
+		for (strl_t i = 0; i < len;) {
+			if ((i + fl) <= len && ref_same(text + i, from[0], fl, false)) {
+				memcpy(ref + n, to[0], tl);
+				n += tl;
+				i += fl;
+			} else
+				ref[n++] = text[i++];
+		}
+		o.copy(strref(text, len));
+		o.replace(strref(from[0], fl), strref(to[0], tl));
+		CHECK(o.same_str_case(strref(ref, n)), "replace");
+		strref f1(from[0], fl), t1(to[0], tl);
+		o.copy(strref(text, len));
+		o.replace_many(&f1, &t1, 1);
+		CHECK(o.same_str_case(strref(ref, n)), "replace_many");
+
+		// several pairs, at each position the longest from string that matches case ignored
+		// is replaced and the earlier pair wins between equal lengths. From strings of 8 or
+		// more characters take the 8 character compare and a short cap leaves the text as is
+		strref fs[6], ts[6];
+		int np = 1 + int(rnd(6));
+		for (int p = 0; p < np; p++) {
+			fl = 1 + rnd(12);
+			if (p && rnd(3)==0) {
+				// same start as an earlier pair
+				const strref &e = fs[rnd(p)];
+				strl_t k = 1 + rnd(e.get_len());
+				memcpy(from[p], e.get(), k);
+				for (strl_t i = k; i < fl; i++) from[p][i] = "abAB "[rnd(5)];
+				if (rnd(2)) fl = k;
+			} else if (rnd(2) && len) {
+				strl_t x = rnd(len);
+				if (fl > (len - x)) fl = len - x;
+				memcpy(from[p], text + x, fl);
+			} else {
+				for (strl_t i = 0; i < fl; i++) from[p][i] = "abAB "[rnd(5)];
+			}
+			if (rnd(2)) from[p][rnd(fl)] ^= 0x20;
+			tl = rnd(fl + 3);
+			for (strl_t i = 0; i < tl; i++) to[p][i] = "xyzXYZ"[rnd(6)];
+			fs[p] = strref(from[p], fl);
+			ts[p] = strref(to[p], tl);
+		}
+		strl_t ahead = 0;
+		n = 0;
+		for (strl_t i = 0; i < len;) {
+			int best = -1;
+			for (int p = 0; p < np; p++) {
+				if (fs[p].get_len() <= (len - i) && ref_same(text + i, fs[p].get(), fs[p].get_len(), false) &&
+					(best < 0 || fs[p].get_len() > fs[best].get_len()))
+					best = p;
+			}
+			if (best < 0) {
+				ref[n++] = text[i++];
+				continue;
+			}
+			memcpy(ref + n, ts[best].get(), ts[best].get_len());
+			n += ts[best].get_len();
+			i += fs[best].get_len();
+			if (n > i && (n - i) > ahead)
+				ahead = n - i;
+		}
+		strl_t cap = rnd(2) ? len + rnd(ahead + 2) : strl_t(sizeof(buf));
+		strovl om(buf, cap);
+		om.copy(strref(text, len));
+		om.replace_many(strreplace(fs, ts, np));
+		if ((len + ahead) <= cap)
+			CHECK(om.same_str_case(strref(ref, n)), "replace_many with %d pairs", np);
+		else
+			CHECK(om.same_str_case(strref(text, len)), "replace_many with %d pairs into %u bytes", np, cap);
+
+		// queued edits against the original text in any order, edits at the same position
+		// keep their queue order and overlapping edits or a result over cap change nothing
+		stredit_op ops[8];
+		stredit edits(ops, 8);
+		strl_t epos[8], esize[8], elen[8];
+		char etext[8][4];
+		int order[8], ne = int(rnd(9));
+		for (int e = 0; e < ne; e++) {
+			epos[e] = (e && rnd(4)==0) ? epos[rnd(e)] : (rnd(6)==0 ? len : rnd(len + 2));
+			esize[e] = rnd(3)==0 ? 0 : rnd(4);
+			elen[e] = rnd(4);
+			memset(etext[e], '0' + e, sizeof(etext[e]));
+			edits.exchange(epos[e], esize[e], strref(etext[e], elen[e]));
+			int j = e;
+			for (; j && epos[order[j-1]] > epos[e]; j--)
+				order[j] = order[j-1];
+			order[j] = e;
+		}
+		bool overlap = false;
+		strl_t at = 0, eahead = 0;
+		n = 0;
+		for (int k = 0; k < ne; k++) {
+			int e = order[k];
+			if (epos[e] > len)
+				break;
+			if (epos[e] < at) {
+				overlap = true;
+				break;
+			}
+			memcpy(ref + n, text + at, epos[e] - at);
+			n += epos[e] - at;
+			memcpy(ref + n, etext[e], elen[e]);
+			n += elen[e];
+			at = epos[e] + (esize[e] < (len - epos[e]) ? esize[e] : len - epos[e]);
+			if (n > at && (n - at) > eahead)
+				eahead = n - at;
+		}
+		memcpy(ref + n, text + at, len - at);
+		n += len - at;
+		strl_t ecap = rnd(2) ? strl_t(sizeof(buf)) : len + rnd(eahead + 3);
+		bool applied = !overlap && (len + eahead) <= ecap;
+		strovl oe(buf, ecap);
+		oe.copy(strref(text, len));
+		CHECK(oe.commit(edits)==applied && oe.same_str_case(applied ? strref(ref, n) : strref(text, len)),
+			  "commit %d edits into %u bytes, overlap %d", ne, ecap, overlap);
+		CHECK(edits.edits()==(applied ? 0 : ne), "commit clears the edits when applied");
+
+		// gap buffer against a contiguous string
+		strgap g(buf + 700, 700);
+		strovl c2(ref, 700);
+		for (int e = 0; e < 20; e++) {
+			strl_t p = rnd(c2.get_len() + 1), s = rnd(6), k = rnd(6);
+			switch (rnd(3)) {
+				case 0: if (g.insert(strref(text, k), p)) c2.insert(strref(text, k), p); break;
+				case 1: g.remove(p, s); c2.erase(p, s); break;
+				default: if (g.exchange(p, s, strref(text, k))) c2.exchange(p, s, strref(text, k)); break;
+			}
+		}
+		CHECK(g.gap_pos() + g.gap_len() + g.after().get_len()==g.cap(), "strgap gap");
+		CHECK(g.get_strref().same_str_case(c2.get_strref()), "strgap");
+	}
+
+	// pairs with an empty from string or past MAX_REPLACE_PAIRS are left out
+	strref many_from[MAX_REPLACE_PAIRS + 1], many_to[MAX_REPLACE_PAIRS + 1];
+	for (int p = 0; p <= MAX_REPLACE_PAIRS; p++) {
+		many_from[p] = strref("ab");
+		many_to[p] = strref("x");
+	}
+	strreplace table;
+	CHECK(!table.set(many_from, many_to, MAX_REPLACE_PAIRS + 1) && table.pairs()==MAX_REPLACE_PAIRS, "strreplace past MAX_REPLACE_PAIRS");
+	many_from[1] = strref();
+	CHECK(!table.set(many_from, many_to, 3) && table.pairs()==2, "strreplace with an empty from");
+	CHECK(table.set(many_from + 2, many_to + 2, 2) && table.pairs()==2, "strreplace");
+}
+
+int main(int argc, char **argv)
+{
+	(void)argc;
+	(void)argv;
+	test_find();
+	test_range();
+	test_wildcard();
+	test_multi();
+	test_hash();
+	test_numbers();
+	test_format();
+	test_code_pages();
+	test_utf8();
+	test_edit();
+	printf("%d checks, %d failed\n", checks, failures);
+	return failures ? 1 : 0;
+}
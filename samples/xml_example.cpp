@@ -28,19 +28,20 @@ const char aXMLExample[] = {
 	"</root>\n"
 };
 
-#define PHASH(name, hash) (hash)
-
-#define SPRITE_TAG_SPRITE PHASH("sprite", 0x81e2581c)
-#define SPRITE_TAG_COLOR PHASH("color", 0x3d7e6258)
-#define SPRITE_TAG_BITMAP PHASH("bitmap", 0x46544626)
-#define SPRITE_TAG_DOUBLESIDED PHASH("doublesided", 0x06216465)
-#define SPRITE_TAG_SIZE PHASH("size", 0x23a0d95c)
-#define SPRITE_SPRITE_TYPE PHASH("type", 0x5127f14d)
-#define SPRITE_COLOR_RED PHASH("red", 0x40f480dc)
-#define SPRITE_COLOR_GREEN PHASH("green", 0x011decbc)
-#define SPRITE_COLOR_BLUE PHASH("blue", 0x82fbf5cd)
-#define SPRITE_SIZE_WIDTH PHASH("width", 0x95876e1f)
-#define SPRITE_SIZE_HEIGHT PHASH("height", 0xd5bdbb42)
+// tag and attribute names hashed at compile time
+using namespace struse_literals;
+
+#define SPRITE_TAG_SPRITE "sprite"_fnv1a
+#define SPRITE_TAG_COLOR "color"_fnv1a
+#define SPRITE_TAG_BITMAP "bitmap"_fnv1a
+#define SPRITE_TAG_DOUBLESIDED "doublesided"_fnv1a
+#define SPRITE_TAG_SIZE "size"_fnv1a
+#define SPRITE_SPRITE_TYPE "type"_fnv1a
+#define SPRITE_COLOR_RED "red"_fnv1a
+#define SPRITE_COLOR_GREEN "green"_fnv1a
+#define SPRITE_COLOR_BLUE "blue"_fnv1a
+#define SPRITE_SIZE_WIDTH "width"_fnv1a
+#define SPRITE_SIZE_HEIGHT "height"_fnv1a
 
 //typedef bool(*XMLDataCB)(void* /*user*/, strref /*tag_or_data*/, const strref* /*tag_stack*/, int /*depth*/, XML_TYPE /*type*/);
 
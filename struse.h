@@ -30,6 +30,11 @@ Add this #define to *one* C++ file before #include "struse.h" to create the impl
 #include ...
 #define STRUSE_IMPLEMENTATION
 #include "struse.h"
+
+Searches and conversions use SSE2/AVX2 (x86) or NEON (arm64) when the compiler targets
+them, add this #define before #include "struse.h" to only use portable code:
+
+#define STRUSE_NO_SIMD
 */
 
 #ifndef __STRUSE_H__
@@ -63,6 +68,27 @@ typedef unsigned int strl_t;
 #define STRREF_FMT "%.*s"
 #define STRREF_ARG(s) (int)(s).get_len(), (s).get()
 
+class strrange;
+class strwild;
+template <class B> class strmod;
+
+// compile time fnv1a hashes, the same values as strref::fnv1a, fnv1a_lower and fnv1a_64
+//	example: switch (tag.fnv1a()) { case fnv1a_const("sprite", 6): ... }
+constexpr unsigned int fnv1a_const(const char *str, strl_t len, unsigned int seed = 2166136261) {
+	return len ? fnv1a_const(str + 1, len - 1, ((uint8_t)*str ^ seed) * 16777619) : seed; }
+constexpr unsigned int fnv1a_lower_const(const char *str, strl_t len, unsigned int seed = 2166136261) {
+	return len ? fnv1a_lower_const(str + 1, len - 1, ((uint8_t)((*str>='a' && *str<='z') ? (*str + 'A' - 'a') : *str) ^ seed) * 16777619) : seed; }
+constexpr uint64_t fnv1a_64_const(const char *str, strl_t len, uint64_t seed = 14695981039346656037ULL) {
+	return len ? fnv1a_64_const(str + 1, len - 1, ((uint8_t)*str ^ seed) * 1099511628211ULL) : seed; }
+
+// string literal hashes
+//	example: using namespace struse_literals; switch (tag.fnv1a()) { case "sprite"_fnv1a: ... }
+namespace struse_literals {
+	constexpr unsigned int operator""_fnv1a(const char *str, size_t len) { return fnv1a_const(str, (strl_t)len); }
+	constexpr unsigned int operator""_fnv1a_lower(const char *str, size_t len) { return fnv1a_lower_const(str, (strl_t)len); }
+	constexpr uint64_t operator""_fnv1a_64(const char *str, size_t len) { return fnv1a_64_const(str, (strl_t)len); }
+}
+
 // internal helper functions for strref
 int _find_rh(const char *text, strl_t len, const char *comp, strl_t comp_len);
 int _find_rh_case(const char *text, strl_t len, const char *comp, strl_t comp_len);
@@ -111,14 +137,32 @@ public:
     // whitespace ignore fnv1a (any sequence whitespace is replaced by one space)
     unsigned int fnv1a_ws(unsigned int seed = 2166136261) const;
 
+	// fast 64 bit hash (multiply and fold 16 bytes at a time), not the same values as fnv1a
+	uint64_t hash64(uint64_t seed = 0) const;
+	uint64_t hash64_lower(uint64_t seed = 0) const;	// ascii7 case ignored
+	uint64_t hash64_ws(uint64_t seed = 0) const;		// any sequence of whitespace hashed as one space
+
 	// convert string to basic integer
 	int64_t atoi() const;
 	uint64_t atoui() const;
 
+	// parse decimal integer with optional sign, returns number of characters consumed
+	// (including leading whitespace) or 0 if there are no digits. value saturates on overflow.
+	strl_t parse_int(int64_t &value, bool *overflow = nullptr) const;
+	strl_t parse_uint(uint64_t &value, bool *overflow = nullptr) const;
+
+	// exactly 'digits' (1-8) decimal digits at pos, -1 if any is not a digit (e.g. "hh:mm")
+	int atoi_fixed(strl_t pos, int digits) const;
+
 	// convert string to floating point
 	float atof() const;
 	double atod() const;
 
+	// parse floating point number in place with '.' as decimal point regardless of locale,
+	// returns number of characters consumed (including leading whitespace) or 0 if not a number
+	strl_t parse_float(float &value) const;
+	strl_t parse_double(double &value) const;
+
 	// number of characters of basic integer in string
 	int atoi_skip();
 
@@ -131,6 +175,10 @@ public:
 	size_t ahextoui_skip();
 	size_t abinarytoui_skip();
 
+	// decode pairs of hex digits into bytes skipping whitespace between pairs (such as a line
+	// of a memory dump), stops at any other character. returns number of bytes written.
+	strl_t ahextobytes(uint8_t *bytes, strl_t max_bytes) const;
+
 	// output string with newline (printf)
 	void writeln();
 
@@ -207,6 +255,23 @@ public:
 	// check if there are any potential non-text characters in the string
 	bool valid_ascii7() const;
 
+	// check that the string is well formed utf8
+	bool valid_utf8() const;
+
+	// number of utf8 characters, which is the number of bytes that do not continue a character
+	strl_t count_utf8_chars() const;
+
+	// byte position of utf8 character n, the length if there are exactly n characters or -1 if fewer
+	int utf8_offset_of(strl_t n) const;
+
+	// number of utf16 units needed for well formed utf8
+	strl_t utf16_len() const;
+
+	// convert utf8 to utf16 or utf32 in caller memory, bytes that are not well formed utf8 become 0xfffd.
+	// Returns units written, stops before a character that does not fit and sets read to bytes converted.
+	strl_t to_utf16(uint16_t *out, strl_t cap, strl_t *read = nullptr) const;
+	strl_t to_utf32(uint32_t *out, strl_t cap, strl_t *read = nullptr) const;
+
 	// fetch a utf-8 character from the beginning of this string
 	size_t get_utf8() const;
 
@@ -251,7 +316,14 @@ public:
 	strref wildcard_after(const strref wild, strref prev, bool case_sensitive = true) const {
 		return find_wildcard(wild, is_substr(prev.get()) ? strl_t(prev.get()+prev.get_len()-get()) : 0, case_sensitive); }
 
-	// character filter by string, as in a wildcard [] operator
+	// wildcard search with a precompiled pattern
+	strref find_wildcard(const strwild &wild, strl_t pos = 0) const;
+	strref next_wildcard(const strwild &wild, strref prev) const {
+		return find_wildcard(wild, is_substr(prev.get()) ? (strl_t(prev.get()-get())+1) : 0); }
+	strref wildcard_after(const strwild &wild, strref prev) const {
+		return find_wildcard(wild, is_substr(prev.get()) ? strl_t(prev.get()+prev.get_len()-get()) : 0); }
+
+	// character filter by string, as in a wildcard [] operator (use strrange to test many characters)
 	bool char_matches_ranges(uint8_t c) const;
 	bool char_matches_ranges(char c) const { return char_matches_ranges((uint8_t)c); }
 
@@ -265,6 +337,9 @@ public:
 	bool same_str(const strref str, char same1, char same2) const;
 	bool same_str_case(const strref str, char same1, char same2) const;
 
+	// whole string compare of utf8 with unicode simple case folding
+	bool same_str_utf8(const strref str) const;
+
 	// mid string compare
 	bool same_substr(const strref str, strl_t pos) const;
 	bool same_substr_esc(const strref str, strl_t pos) const;
@@ -345,8 +420,14 @@ public:
 	// return position in this string of the first occurrence of the argument or negative if not found, case sensitive
 	int find_case(const char *str) const;
 	int find_case_esc(const strref str, strl_t pos) const;
+
+	// return byte position of the first occurrence of the argument or negative if not found,
+	// utf8 with unicode simple case folding
+	int find_utf8(const strref str, strl_t pos = 0) const;
 	int find_case_esc_range(const strref str, const strref range, strl_t pos) const;
 	int find_esc_range(const strref str, const strref range, strl_t pos) const;
+	int find_case_esc_range(const strref str, const strrange &range, strl_t pos) const;
+	int find_esc_range(const strref str, const strrange &range, strl_t pos) const; // range is tested with lowercase characters
 
 	// return position in this string of the last occurrence of the argument or negative if not found, not case sensitive
 	int find_last(const strref str) const;
@@ -367,9 +448,12 @@ public:
 	// find any char from str or char range or char - with backslash prefix
 	int find_any_char_or_range(const strref range, strl_t pos = 0) const;
 	int find_any_not_in_range(const strref range, strl_t pos = 0) const;
+	int find_any_char_or_range(const strrange &range, strl_t pos = 0) const;
+	int find_any_not_in_range(const strrange &range, strl_t pos = 0) const;
 
 	// find any char from str or char range or char - with backslash prefix
 	int find_range_char_within_range(const strref range_find, const strref range_within, strl_t pos = 0) const;
+	int find_range_char_within_range(const strrange &range_find, const strrange &range_within, strl_t pos = 0) const;
 
 	// find but not within parenthesis
 	int find_skip_parens(char token) const;
@@ -509,6 +593,7 @@ public:
 
 	// get a range of characters matching the range
 	strref get_range_word(const strref range, strl_t pos = 0) const;
+	strref get_range_word(const strrange &range, strl_t pos = 0) const;
 	
 	// get the next block of characters separated by whitespace
 	strref get_word_ws() const {
@@ -590,6 +675,8 @@ public:
 	strref split_token_trim_track_parens(char c);
 	strref split_range(const strref range, strl_t pos=0);
 	strref split_range_trim(const strref range, strl_t pos=0);
+	strref split_range(const strrange &range, strl_t pos=0);
+	strref split_range_trim(const strrange &range, strl_t pos=0);
 	strref split_label();
 	strref split_lang();
 	strref split_num();
@@ -644,6 +731,255 @@ public:
 		if (add<length) { string += add; length -= add; } else { clear(); } }
 };
 
+// compiled character range, built once from a range string using the same rules
+// as wildcard [] and *{} (a-z for a range, backslash escape codes, ! prefix to exclude)
+// and then reused for searching instead of parsing the range string for each character.
+class strrange {
+protected:
+	uint32_t bits[8];		// one bit per character value
+	uint8_t nib_lo[16];		// low nibble lookup, one bit per high nibble group
+	uint8_t nib_hi[16];		// high nibble lookup, bit of high nibble group
+	uint8_t span_first[4];	// first character of each span of matching characters
+	uint8_t span_size[4];	// number of characters after first in each span
+	uint8_t spans;			// number of spans
+	uint8_t flags;			// which vector tests are valid / inverted
+
+	void compile();
+
+public:
+	strrange() : spans(0), flags(0) { memset(bits, 0, sizeof(bits)); }
+	strrange(const strref range, bool case_sensitive = true) { set(range, case_sensitive); }
+
+	// case insensitive ranges match characters that are in the range after lowercasing
+	void set(const strref range, bool case_sensitive = true);
+
+	// any single character in chars (no ranges or escape codes)
+	void set_chars(const strref chars);
+
+	void clear();
+	void add(uint8_t c) { add(c, c); }
+	void add(uint8_t first, uint8_t last);
+	void add(const strrange &range);
+	void invert();
+
+	// test a single character
+	bool has(uint8_t c) const { return ((bits[c>>5]>>(c&31)) & 1) != 0; }
+	bool has(char c) const { return has((uint8_t)c); }
+
+	// find first character in str at pos or after that is / is not in this range
+	int find(const strref str, strl_t pos = 0) const;
+	int find_not(const strref str, strl_t pos = 0) const;
+
+	// number of characters from pos that are in this range
+	strl_t len(const strref str, strl_t pos = 0) const;
+
+	// offset to first character that is (match) or isn't (!match) in range, or len if none
+	strl_t scan(const uint8_t *s, strl_t len, bool match) const;
+
+	// remove characters that are (match) or aren't (!match) in range in place, returns the new length
+	strl_t remove(uint8_t *s, strl_t len, bool match = true) const;
+};
+
+// wildcard pattern limits
+#define MAX_WILDCARD_SEGMENTS 64
+#define MAX_WILDCARD_STEPS 48
+#define MAX_WILDCARD_SEARCH_STACK 32
+#define MAX_WILDCARD_RANGES 16
+#define MAX_WILDCARD_STATES 63
+#define MAX_WILDCARD_CLASSES 32
+
+// how a compiled wildcard pattern searches
+enum STRWILD_ENGINE {
+	SWE_BACKTRACK,	// follow the steps and step back on failure, can be quadratic on near misses
+	SWE_AUTOMATON,	// bit-parallel state machine (shift-and), linear time
+};
+
+// compiled wildcard pattern (see find_wildcard for the syntax), split into search
+// steps with character ranges compiled once so the same pattern can be searched
+// for many times. The pattern string is referenced and must remain valid.
+//
+// The automaton engine finds the leftmost match and the shortest match from there,
+// ending in a greedy *{}, *%, *@ or *$ if the pattern ends with one. Patterns with
+// word or line anchors (<, >, @, ^) or more than MAX_WILDCARD_STATES states use the
+// backtrack engine.
+class strwild {
+protected:
+	strref segs[MAX_WILDCARD_SEGMENTS];		// substrings and range strings from the pattern
+	strrange ranges[MAX_WILDCARD_RANGES];	// compiled ranges used by steps
+	uint8_t step_range[MAX_WILDCARD_STEPS];	// index of compiled range used by each step
+	uint8_t step_within[MAX_WILDCARD_STEPS];	// index of range to find within if step has two
+	char type[MAX_WILDCARD_STEPS];			// search steps
+	int steps;
+	bool case_sensitive;
+
+	// automaton, bit n of a state set means the first n pattern states are matched
+	STRWILD_ENGINE engine;
+	uint8_t char_class[256];						// character to class
+	uint64_t class_next[MAX_WILDCARD_CLASSES];	// states entered by a class from the previous state
+	uint64_t class_loop[MAX_WILDCARD_CLASSES];	// states that repeat on a class
+	uint64_t repeat;			// states that may be skipped (zero or more characters)
+	strrange first;				// characters that can start a match
+	bool skip_first;			// matches only start on characters in first
+	int states;					// number of pattern states, all states matched = accepted
+	int tail;					// range index of a greedy end of pattern or -1
+
+	bool build_automaton();
+	strref find_automaton(const strref str, strl_t pos) const;
+
+public:
+	strwild() : steps(0), case_sensitive(true), engine(SWE_BACKTRACK) {}
+	strwild(const strref pattern, bool case_sensitive = true, STRWILD_ENGINE engine = SWE_BACKTRACK) {
+		set(pattern, case_sensitive, engine); }
+
+	void set(const strref pattern, bool case_sensitive = true, STRWILD_ENGINE engine = SWE_BACKTRACK);
+
+	// false if the pattern was too complex to compile
+	bool valid() const { return steps>0; }
+
+	// engine in use, may be backtrack if the pattern did not fit an automaton
+	STRWILD_ENGINE get_engine() const { return engine; }
+
+	// find the first match in str starting at pos
+	strref find(const strref str, strl_t pos = 0) const;
+};
+
+#define MAX_FORMAT_SEGMENTS 32
+
+// argument types for the variadic format functions
+enum STRFORMAT_ARG {
+	SFA_STRING,
+	SFA_CHAR,
+	SFA_INT,
+	SFA_UINT,
+	SFA_DOUBLE,
+	SFA_FLOAT,
+};
+
+// one argument to the variadic format functions, strings are referenced and
+// numbers are converted as they are written. Unsupported types fail to compile.
+struct strformat_arg {
+	union {
+		const char *str;
+		int64_t i;
+		uint64_t u;
+		double d;
+	};
+	strl_t len;
+	STRFORMAT_ARG type;
+
+	strformat_arg(const strref s) : str(s.get()), len(s.get_len()), type(SFA_STRING) {}
+	strformat_arg(const char *s) : str(s), len(s ? (strl_t)strlen(s) : 0), type(SFA_STRING) {}
+	template <class B> strformat_arg(const strmod<B> &s) : str(s.get()), len(s.get_len()), type(SFA_STRING) {}
+	strformat_arg(char c) : i(c), len(0), type(SFA_CHAR) {}
+	strformat_arg(int v) : i(v), len(0), type(SFA_INT) {}
+	strformat_arg(long v) : i(v), len(0), type(SFA_INT) {}
+	strformat_arg(long long v) : i(v), len(0), type(SFA_INT) {}
+	strformat_arg(unsigned int v) : u(v), len(0), type(SFA_UINT) {}
+	strformat_arg(unsigned long v) : u(v), len(0), type(SFA_UINT) {}
+	strformat_arg(unsigned long long v) : u(v), len(0), type(SFA_UINT) {}
+	strformat_arg(double v) : d(v), len(0), type(SFA_DOUBLE) {}
+	strformat_arg(float v) : d(v), len(0), type(SFA_FLOAT) {}
+};
+
+// literal text of a compiled format followed by a {n} argument
+struct strformat_seg {
+	strref text;		// literal text, escape codes are converted when written
+	int16_t arg;		// argument index or -1 if there is only text
+	uint16_t width;		// minimum width, numbers are right aligned and strings left aligned
+	char hex;			// 'x' or 'X' for hexadecimal integers, otherwise 0
+	bool zero;			// pad numbers with zeros instead of spaces
+	bool esc;			// text contains escape codes
+};
+
+// compiled {n} format (see format_append) that is scanned once and reused for
+// many lines. The format string is referenced and must remain valid.
+class strformat {
+protected:
+	strformat_seg segs[MAX_FORMAT_SEGMENTS];
+	int count;
+
+public:
+	strformat() : count(0) {}
+	strformat(const strref format) { set(format); }
+
+	// false if the format has more than MAX_FORMAT_SEGMENTS arguments, the rest is ignored
+	bool set(const strref format);
+
+	int segments() const { return count; }
+	const strformat_seg& segment(int i) const { return segs[i]; }
+};
+
+#define MAX_REPLACE_PAIRS 64
+
+// compiled table of (from, to) pairs for replace_many. At each position the longest from
+// string that matches is replaced, case ignored like replace, and scanning continues after
+// it. The strings are referenced and must remain valid.
+class strreplace {
+protected:
+	strref from[MAX_REPLACE_PAIRS];
+	strref to[MAX_REPLACE_PAIRS];
+	uint64_t prefix[MAX_REPLACE_PAIRS];		// first 8 characters of from lowercased
+	uint64_t prefix_mask[MAX_REPLACE_PAIRS];	// bits of prefix for from strings under 8 characters
+	strrange first;					// first characters of from strings in either case
+	uint8_t head[256];				// longest pair starting with each lowercase character
+	uint8_t next[MAX_REPLACE_PAIRS];	// next pair with the same first character, longest first
+	int count;
+
+public:
+	strreplace() : count(0) { memset(head, 0xff, sizeof(head)); }
+	strreplace(const strref *f, const strref *t, int pairs) { set(f, t, pairs); }
+
+	// false if there are more than MAX_REPLACE_PAIRS pairs or a from string is empty,
+	// those pairs are left out
+	bool set(const strref *f, const strref *t, int pairs);
+
+	int pairs() const { return count; }
+	const strref& get_from(int i) const { return from[i]; }
+	const strref& get_to(int i) const { return to[i]; }
+
+	// position of the next match at or after pos and its pair, or -1 if none
+	int find(const strref str, strl_t pos, int &pair) const;
+};
+
+// one queued edit, replace size characters at pos of the original text with len characters of text
+struct stredit_op {
+	strl_t pos;
+	strl_t size;
+	const char *text;
+	strl_t len;
+};
+
+// list of (position, length, replacement) edits queued against the current text of a string
+// and applied in one pass by strmod::commit. Positions are in the text as it was when the
+// edits were queued so earlier edits do not move later ones, the queue order does not matter
+// but edits may not overlap. Both buffers are caller memory, replacement text is copied into
+// the text buffer if there is one, otherwise it is referenced and must remain valid and must
+// not point into the string being edited.
+class stredit {
+protected:
+	stredit_op *ops;
+	char *text;
+	int count, max_ops;
+	strl_t text_len, text_cap;
+
+public:
+	stredit(stredit_op *op_buf, int op_cap, char *text_buf = nullptr, strl_t text_buf_cap = 0) :
+		ops(op_buf), text(text_buf), count(0), max_ops(op_cap), text_len(0), text_cap(text_buf_cap) {}
+
+	void clear() { count = 0; text_len = 0; }
+	int edits() const { return count; }
+	const stredit_op& edit(int i) const { return ops[i]; }
+
+	// queue an edit, false if the op or text buffer is full
+	bool exchange(strl_t pos, strl_t size, const strref insert);
+	bool insert(strl_t pos, const strref insert) { return exchange(pos, 0, insert); }
+	bool remove(strl_t pos, strl_t size) { return exchange(pos, size, strref()); }
+
+	// apply all edits to string and clear them. false and nothing changed if edits overlap
+	// or the result does not fit, edits past the end are ignored like strmod::exchange
+	bool apply(char *string, strl_t &length, strl_t cap);
+};
+
 // internal helper functions for strmod
 strl_t _strmod_copy(char *string, strl_t cap, const char *str);
 strl_t _strmod_copy(char *string, strl_t cap, strref str);
@@ -651,13 +987,31 @@ strl_t _strmod_append(char *string, strl_t length, strl_t cap, const char *str);
 strl_t _strmod_append(char *string, strl_t length, strl_t cap, strref str);
 strl_t _strmod_insert(char *string, strl_t length, strl_t cap, const strref sub, strl_t pos);
 strl_t _strmod_utf8_tolower(char *string, strl_t length, strl_t cap);
+strl_t _strmod_utf8_toupper(char *string, strl_t length, strl_t cap);
+strl_t _strmod_utf8_case_to(char *out, strl_t cap, const strref str, bool upper);
+strl_t _strmod_utf16_to_utf8(char *out, strl_t cap, const uint16_t *src, strl_t count, strl_t &read);
+strl_t _strmod_utf32_to_utf8(char *out, strl_t cap, const uint32_t *src, strl_t count, strl_t &read);
 strl_t _strmod_write_utf8( char *string, strl_t cap, size_t code, strl_t pos );
 void _strmod_substrcopy(char *string, strl_t length, strl_t cap, strl_t src, strl_t dst, strl_t chars);
 void _strmod_tolower(char *string, strl_t length);
 void _strmod_toupper(char *string, strl_t length);
+void _strmod_tolower_win_ascii(char *string, strl_t length);
+void _strmod_toupper_win_ascii(char *string, strl_t length);
+void _strmod_tolower_amiga_ascii(char *string, strl_t length);
+void _strmod_toupper_amiga_ascii(char *string, strl_t length);
+void _strmod_tolower_macos_ascii(char *string, strl_t length);
+void _strmod_toupper_macos_ascii(char *string, strl_t length);
 strl_t _strmod_format_insert(char *string, strl_t length, strl_t cap, strl_t pos, strref format, const strref *args);
+strl_t _strmod_format_append(char *string, strl_t length, strl_t cap, strref format, const strformat_arg *args, int count);
+strl_t _strmod_format_append(char *string, strl_t length, strl_t cap, const strformat &format, const strformat_arg *args, int count);
 strl_t _strmod_append_num(char* str, strl_t left, uint32_t num, strl_t size, uint32_t radix);
+strl_t _strmod_append_int64(char* str, strl_t left, int64_t num);
+strl_t _strmod_append_uint64(char* str, strl_t left, uint64_t num);
+strl_t _strmod_append_hex(char* str, strl_t left, uint64_t num, strl_t digits, bool upper);
+strl_t _strmod_append_double(char* str, strl_t left, double num);
+strl_t _strmod_append_float(char* str, strl_t left, float num);
 strl_t _strmod_remove(char *string, strl_t length, char a);
+strl_t _strmod_remove(char *string, strl_t length, const strrange &range, bool in_range);
 strl_t _strmod_remove(char *string, strl_t length, strl_t start, strl_t len);
 strl_t _strmod_exchange(char *string, strl_t length, strl_t cap, strl_t start, strl_t size, const strref insert);
 strl_t _strmod_cleanup_path(char *file, strl_t len);
@@ -714,6 +1068,12 @@ public:
 
 	// mirror strref functionality
 	int count_char(char c) const { return get_strref().count_char(c); }
+	bool valid_utf8() const { return get_strref().valid_utf8(); }
+	strl_t count_utf8_chars() const { return get_strref().count_utf8_chars(); }
+	int utf8_offset_of(strl_t n) const { return get_strref().utf8_offset_of(n); }
+	strl_t utf16_len() const { return get_strref().utf16_len(); }
+	strl_t to_utf16(uint16_t *out, strl_t cap, strl_t *read = nullptr) const { return get_strref().to_utf16(out, cap, read); }
+	strl_t to_utf32(uint32_t *out, strl_t cap, strl_t *read = nullptr) const { return get_strref().to_utf32(out, cap, read); }
 	int len_eol() const { return get_strref().len_eol(); }
 	int len_next_line() const { return get_strref().len_next_line(); }
 	strl_t len_float_number() const { return get_strref().len_float_number(); }
@@ -722,6 +1082,7 @@ public:
 	// get fnv1a hash for string
 	unsigned int fnv1a(unsigned int seed = 2166136261) const { return get_strref().fnv1a(seed);  }
 	unsigned int fnv1a_append(unsigned int base_fnv1a_hash) const { return get_strref().fnv1a(base_fnv1a_hash); }
+	uint64_t hash64(uint64_t seed = 0) const { return get_strref().hash64(seed); }
 
 	// whole string compare
 	bool same_str(const strref str) const { return get_strref().same_str_case(str); }
@@ -732,6 +1093,7 @@ public:
 		return get_strref().same_str_case(str, same1, same2); }
 	bool same_str(const char *str) const { return get_strref().same_str(str); }
 	bool same_str_case(const char *str) const { return get_strref().same_str_case(str); }
+	bool same_str_utf8(const strref str) const { return get_strref().same_str_utf8(str); }
 
 	// prefix compare
 	strl_t prefix_len(const strref str) const { return get_strref().prefix_len(str); }
@@ -769,7 +1131,8 @@ public:
 	int find_after_last(char a, char b) const { return get_strref().find_after_last(a, b); }
 	int find_after_last(char a1, char a2, char b) const { return get_strref().find_after_last(a1, a2, b); }
 	int find(const strref str) const { return get_strref().find(str); }
-	int find(const strref str, strl_t pos) const { get_strref().find(str, pos); }
+	int find(const strref str, strl_t pos) const { return get_strref().find(str, pos); }
+	int find_utf8(const strref str, strl_t pos = 0) const { return get_strref().find_utf8(str, pos); }
 	int find(const char *str, strl_t pos = 0) const { return get_strref().find(str, pos); }
 	int find_case(const strref str) const { return get_strref().find_case(str); }
 	int find_case(const char *str) const { return get_strref().find_case(str); }
@@ -845,7 +1208,12 @@ public:
 
 	// find a wildcard right after the end of the previous find
 	strref wildcard_after(const strref wild, strref prev, bool case_sensitive = true) const {
-		return get_strref().next_wildcard(wild, prev, case_sensitive); }
+		return get_strref().wildcard_after(wild, prev, case_sensitive); }
+
+	// wildcard search with a precompiled pattern
+	strref find_wildcard(const strwild &wild, strl_t pos = 0) const { return get_strref().find_wildcard(wild, pos); }
+	strref next_wildcard(const strwild &wild, strref prev) const { return get_strref().next_wildcard(wild, prev); }
+	strref wildcard_after(const strwild &wild, strref prev) const { return get_strref().wildcard_after(wild, prev); }
 
 	// write a single utf-8 character to pos and return how many bytes was required
 	strl_t write_utf8(int code, strl_t pos) { return _strmod_write_utf8(charstr(), cap(), code, pos); }
@@ -871,6 +1239,19 @@ public:
 	void tolower_utf8() { set_len_int(_strmod_utf8_tolower(charstr(), len(), cap())); }
 	void toupper_utf8() { set_len_int(_strmod_utf8_toupper(charstr(), len(), cap())); }
 
+	// lower or upper case utf8 into another string in one pass, cut at its capacity
+	template <class O> strref tolower_utf8_to(strmod<O> &out) const {
+		out.set_len(_strmod_utf8_case_to(out.charstr(), out.cap(), get_strref(), false)); return out.get_strref(); }
+	template <class O> strref toupper_utf8_to(strmod<O> &out) const {
+		out.set_len(_strmod_utf8_case_to(out.charstr(), out.cap(), get_strref(), true)); return out.get_strref(); }
+
+	// append utf16 or utf32 as utf8, unpaired surrogates and codes past 0x10ffff become 0xfffd.
+	// Stops before a character that does not fit, returns the units read.
+	strl_t append_utf16(const uint16_t *src, strl_t count) {
+		strl_t read; add_len_int(_strmod_utf16_to_utf8(end(), cap()-len(), src, count, read)); return read; }
+	strl_t append_utf32(const uint32_t *src, strl_t count) {
+		strl_t read; add_len_int(_strmod_utf32_to_utf8(end(), cap()-len(), src, count, read)); return read; }
+
 	// get the end of the current string
 	char *end() { return charstr()+len(); }
 
@@ -919,11 +1300,35 @@ public:
 	// format this string using {n} notation to index into the args list
 	void format(const strref format, const strref *args) {
 		set_len_int(_strmod_format_insert(charstr(), 0, cap(), 0, format, args)); }
+	void format(const strref format, strref *args) {
+		set_len_int(_strmod_format_insert(charstr(), 0, cap(), 0, format, args)); }
+	template <size_t N> void format(const strref format, const strref (&args)[N]) {
+		set_len_int(_strmod_format_insert(charstr(), 0, cap(), 0, format, args)); }
 
 	// append a formatted string, return the appended part as a strref
 	strref format_append(const strref format, const strref *args) { strl_t l = len();
 		set_len_int(_strmod_format_insert(charstr(), len(), cap(), len(), format, args));
 		return strref(charstr()+l, len()-l); }
+	strref format_append(const strref format, strref *args) { return format_append(format, (const strref*)args); }
+	template <size_t N> strref format_append(const strref format, const strref (&args)[N]) {
+		return format_append(format, (const strref*)args); }
+
+	// variadic format with strings, chars, integers and floating point arguments
+	// {n} is argument n, {n:8} is at least 8 characters wide, {n:08} zero pads a number and
+	// {n:x} or {n:X08} is a hexadecimal integer. A strformat skips scanning the format.
+	//	example: str.format_append("{0}: {1:x08} {2}\n", name, id, scale)
+	template <typename... A> strref format_append(const strref format, const A&... args) {
+		const strformat_arg a[] = { strformat_arg(args)..., strformat_arg(0) }; strl_t l = len();
+		set_len_int(_strmod_format_append(charstr(), len(), cap(), format, a, (int)sizeof...(A)));
+		return strref(charstr()+l, len()-l); }
+	template <typename... A> strref format_append(const strformat &format, const A&... args) {
+		const strformat_arg a[] = { strformat_arg(args)..., strformat_arg(0) }; strl_t l = len();
+		set_len_int(_strmod_format_append(charstr(), len(), cap(), format, a, (int)sizeof...(A)));
+		return strref(charstr()+l, len()-l); }
+	template <typename... A> void format(const strref format, const A&... args) {
+		clear(); format_append(format, args...); }
+	template <typename... A> void format(const strformat &format, const A&... args) {
+		clear(); format_append(format, args...); }
 
 	// prepend a formatted string, return the prepend part as a strref
 	strref format_prepend(const strref format, const strref *args) { strl_t l = len();
@@ -939,6 +1344,19 @@ public:
 		return *this;
 	}
 
+	// append numbers without printf, hex is zero padded to digits (0 = as many as needed)
+	// and double is the shortest string that reads back as the same value
+	strmod& append_int64(int64_t num) {
+		add_len_int(_strmod_append_int64(charstr() + len(), cap() - len(), num)); return *this; }
+	strmod& append_uint64(uint64_t num) {
+		add_len_int(_strmod_append_uint64(charstr() + len(), cap() - len(), num)); return *this; }
+	strmod& append_hex(uint64_t num, strl_t digits = 0, bool upper = false) {
+		add_len_int(_strmod_append_hex(charstr() + len(), cap() - len(), num, digits, upper)); return *this; }
+	strmod& append_double(double num) {
+		add_len_int(_strmod_append_double(charstr() + len(), cap() - len(), num)); return *this; }
+	strmod& append_float(float num) {
+		add_len_int(_strmod_append_float(charstr() + len(), cap() - len(), num)); return *this; }
+
 	// c style sprintf (work around windows _s preference)
 #ifdef _WIN32
 	int sprintf(const char *format, ...) { va_list args; va_start(args, format);
@@ -966,6 +1384,13 @@ public:
 	strref replace(const strref a, const strref b) {
 		set_len(_strmod_inplace_replace_int(charstr(), len(), cap(), a, b)); return get_strref(); }
 
+	// replace all occurrences of several strings in one pass, see strreplace. Nothing is
+	// replaced if the result does not fit or growing replacements need more room on the way
+	strref replace_many(const strreplace &table) {
+		set_len(_strmod_inplace_replace_many_int(charstr(), len(), cap(), table)); return get_strref(); }
+	strref replace_many(const strref *from, const strref *to, int pairs) {
+		strreplace table(from, to, pairs); return replace_many(table); }
+
 	// replace strings bookended by a specific string
 	strref replace_bookend(const strref a, const strref b, const strref bookend) { if (len() && get() && a && bookend)
 		set_len(_strmod_inplace_replace_bookend_int(charstr(), len(), cap(), a, b, bookend)); return get_strref(); }
@@ -976,6 +1401,10 @@ public:
     
     void exchange(const strref original, const strref insert) {
         if (is_substr(original.get())) { exchange(strl_t(original.get()-get()), original.get_len(), insert); } }
+
+	// apply queued edits in one pass, see stredit. false and nothing changed if they do not fit
+	bool commit(stredit &edits) {
+		strl_t l = len(); bool ok = edits.apply(charstr(), l, cap()); set_len_int(l); return ok; }
             
     // remove a part of this string
 	strref remove(strl_t start, strl_t _length) {
@@ -984,6 +1413,13 @@ public:
 	// remove all instances of a character from this string
 	strref remove(char a) { set_len_int(_strmod_remove(charstr(), len(), a)); return get_strref(); }
 
+	// remove all characters in range, or all characters not in range if in_range is false
+	strref remove(const strrange &range, bool in_range = true) {
+		set_len_int(_strmod_remove(charstr(), len(), range, in_range)); return get_strref(); }
+
+	// remove all whitespace and control characters (0 to 0x20)
+	strref remove_whitespace() { strrange r; r.add(0, 0x20); return remove(r); }
+
 	// zero terminate this string and return it
 	const char *c_str() { charstr()[len()<cap()?len():(cap()-1)] = 0; return charstr(); }
 
@@ -991,9 +1427,7 @@ public:
 	char* charend() { return charstr()+len(); }
 
 	// remove a portion of this string
-	void erase(strl_t pos, strl_t length) { if (pos<len()) { if ((pos+length)>len())
-		length = len()-pos; if (length) { for (strl_t i = 0; i<length; i++)
-		charstr()[pos+i] = charstr()[pos+i+length];	} sub_len_int(length); } }
+	void erase(strl_t pos, strl_t length) { set_len_int(_strmod_remove(charstr(), len(), pos, length)); }
 
 	strmod& cleanup_path() { 
 		set_len(_strmod_cleanup_path(charstr(), get_len()));
@@ -1060,6 +1494,75 @@ public:
     strovl(char *ptr, strl_t space, strl_t length) { set_overlay(ptr, space); string_length = length; }
 };
 
+// gap buffer string, instance with 'strgap name(char *, size)'. The unused space is kept as a
+// gap at the last edit so insert, remove and exchange only move the text between the previous
+// edit and this one instead of everything after it. get_strref moves the gap to the end to
+// return the text as one contiguous string, before and after return the two parts as they are.
+class strgap {
+protected:
+	char *string_ptr;
+	strl_t string_space;
+	strl_t gap_start;	// characters before the gap
+	strl_t gap_end;		// offset of the characters after the gap
+
+public:
+	strgap() { invalidate(); }
+	strgap(char *ptr, strl_t space, strl_t length = 0) { set_overlay(ptr, space, length); }
+
+	void invalidate() { string_ptr = nullptr; string_space = 0; gap_start = 0; gap_end = 0; }
+	void set_overlay(char *ptr, strl_t space, strl_t length = 0) {
+		string_ptr = ptr; string_space = space; gap_start = length; gap_end = space; }
+
+	strl_t cap() const { return string_space; }
+	strl_t len() const { return gap_start + string_space - gap_end; }
+	strl_t gap_pos() const { return gap_start; }		// characters before the gap
+	strl_t gap_len() const { return gap_end - gap_start; }	// free space in the gap
+	bool empty() const { return !len(); }
+	bool full() const { return gap_start==gap_end; }
+	void clear() { gap_start = 0; gap_end = string_space; }
+
+	// the text before and after the gap
+	strref before() const { return strref(string_ptr, gap_start); }
+	strref after() const { return strref(string_ptr + gap_end, string_space - gap_end); }
+
+	// character at pos, pos must be less than len()
+	char get_at(strl_t pos) const { return string_ptr[pos<gap_start ? pos : (pos + gap_end - gap_start)]; }
+	char operator[](strl_t pos) const { return get_at(pos); }
+
+	// move the gap to pos, moves the characters between the gap and pos
+	void move_gap(strl_t pos);
+
+	// insert, false and nothing inserted if it does not fit
+	bool insert(const strref sub, strl_t pos);
+	bool append(const strref sub) { return insert(sub, len()); }
+	bool prepend(const strref sub) { return insert(sub, 0); }
+
+	// remove a portion of this string
+	void remove(strl_t start, strl_t length);
+	void erase(strl_t pos, strl_t length) { remove(pos, length); }
+
+	// replace size characters at pos, false and nothing changed if it does not fit
+	bool exchange(strl_t pos, strl_t size, const strref insert);
+
+	// replace a part of before(), after() or get_strref() with another string
+	bool exchange(const strref original, const strref insert) {
+		const char *o = original.get();
+		if (o>=string_ptr && o<=(string_ptr + gap_start))
+			return exchange(strl_t(o - string_ptr), original.get_len(), insert);
+		if (o>=(string_ptr + gap_end) && o<=(string_ptr + string_space))
+			return exchange(gap_start + strl_t(o - string_ptr - gap_end), original.get_len(), insert);
+		return false; }
+
+	// move the gap to the end and return the contiguous text
+	strref get_strref() { move_gap(len()); return before(); }
+
+	// find a string after pos, see strref::find
+	int find(const strref str, strl_t pos = 0) { return get_strref().find(str, pos); }
+
+	// zero terminate and return the contiguous text, the last character is replaced if full
+	const char *c_str() { get_strref(); if (!string_space) return ""; string_ptr[gap_start<string_space ? gap_start : (string_space-1)] = 0; return string_ptr; }
+};
+
 
 // helper for relative strings. purpose is for string collections that may need to grow
 // by allocating a new buffer and copying. requires calling get(base strref) tp use string.
@@ -1133,195 +1636,694 @@ public:
 	iterator begin() { return iterator(*this); }
 };
 
+// node of a strmulti pattern tree, one per unique pattern prefix
+struct strmulti_node {
+	int child;		// first node one character longer or 0
+	int sibling;	// next node with the same parent or 0
+	int fail;		// node of the longest suffix that is also a prefix
+	int out;		// next node on the fail chain that ends a pattern or 0
+	int pattern;	// index of the pattern ending here or -1
+	strl_t depth;	// prefix length
+	uint8_t c;		// last character of prefix
+};
+
+// position of a pattern found in a text, also holds the state to find the next one
+struct strmulti_hit {
+	strl_t pos;		// offset of the pattern in the text
+	strl_t len;		// length of the pattern
+	int pattern;	// index of the pattern, in order of add
+	int node, out;	// search state
+	strl_t scan;	// search position
+	strmulti_hit(strl_t start = 0) : pos(0), len(0), pattern(-1), node(0), out(0), scan(start) {}
+	bool valid() const { return pattern>=0; }
+};
+
+// multi-pattern search (Aho-Corasick), finds every occurrence of any number of
+// patterns in one pass over the text. Patterns are added to a tree in a caller
+// provided node array, a pattern needs at most its length in nodes plus one root node.
+// Identical patterns are reported with the first index. The pattern strings are
+// only read by add.
+//
+//	strmulti_node nodes[1024];
+//	strmulti keywords(nodes, 1024);
+//	keywords.add(patterns, num_patterns);
+//	keywords.build();
+//	strmulti_hit hit;
+//	while (keywords.next(text, hit))
+//		printf("%d at %d\n", hit.pattern, hit.pos);
+class strmulti {
+protected:
+	strmulti_node *nodes;
+	int capacity;
+	int num_nodes;
+	int num_patterns;
+	bool case_sensitive;
+	int root[256];		// nodes one character from the root
+	strrange first;		// characters that can start a pattern
+
+	int child(int node, uint8_t c) const;
+
+public:
+	strmulti(strmulti_node *node_array, int node_count, bool case_sensitive = true);
+
+	void clear();
+
+	// add a pattern, returns the pattern index or -1 if empty or out of nodes
+	int add(const strref pattern);
+
+	// add a number of patterns, returns false if any could not be added
+	bool add(const strref *patterns, int count);
+	template <strl_t S> bool add(strcol<S> &patterns) {
+		bool ok = true; for (strref pattern : patterns) ok = add(pattern)>=0 && ok; return ok; }
+
+	// link the patterns for searching, call after adding patterns
+	void build();
+
+	int patterns() const { return num_patterns; }
+	int nodes_used() const { return num_nodes; }
+
+	// find the next pattern in text ending after hit, in order of end position
+	bool next(const strref text, strmulti_hit &hit) const;
+
+	// first pattern to end in text at or after pos, returns offset or -1
+	int find(const strref text, strl_t pos = 0, int *pattern = nullptr) const;
+};
+
+// substring search with the needle prepared once for searching in many texts.
+// Short needles are found with the vector first and last character search used by
+// strref::find, longer needles with a Horspool skip table. The needle is referenced
+// and must remain valid.
+//
+//	strref_searcher needle("needle");
+//	for (strref match : needle.all(text))
+//		...
+class strref_searcher {
+protected:
+	strref needle;
+	bool case_sensitive;
+	bool use_skip;			// skip table is built
+	uint8_t last;			// last character of needle or its lowercase bit for letters
+	uint8_t last_fold;
+	strl_t skip[256];		// Horspool shift for the last character of each window
+
+public:
+	strref_searcher() : case_sensitive(true), use_skip(false), last(0), last_fold(0) {}
+	strref_searcher(const strref str, bool case_sensitive = true) { set(str, case_sensitive); }
+
+	void set(const strref str, bool case_sensitive = true);
+
+	strref get_needle() const { return needle; }
+	strl_t get_len() const { return needle.get_len(); }
+
+	// first match in text at or after pos, or -1
+	int find(const strref text, strl_t pos = 0) const;
+
+	// all matches in text including overlapping ones
+	class iterator {
+		const strref_searcher *searcher;
+		strref text;
+		int pos;
+	public:
+		iterator() : searcher(nullptr), pos(-1) {}
+		iterator(const strref_searcher &s, const strref t, int p) : searcher(&s), text(t), pos(p) {}
+		void operator++() { pos = (pos<0 || !searcher) ? -1 : searcher->find(text, strl_t(pos + 1)); }
+		bool operator==(const iterator &i) const { return pos==i.pos; }
+		bool operator!=(const iterator &i) const { return pos!=i.pos; }
+		strref operator*() const { return pos<0 ? strref() : text.get_substr(strl_t(pos), searcher->get_len()); }
+		int offset() const { return pos; }
+	};
+	class range {
+		const strref_searcher &searcher;
+		strref text;
+	public:
+		range(const strref_searcher &s, const strref t) : searcher(s), text(t) {}
+		iterator begin() const { return iterator(searcher, text, searcher.find(text)); }
+		iterator end() const { return iterator(searcher, text, -1); }
+	};
+	range all(const strref text) const { return range(*this, text); }
+};
+
 #ifdef STRUSE_IMPLEMENTATION
 //#include <math.h>
-#include <stdlib.h> // atof
+#include <stdlib.h> // malloc, free, strtol for code that relies on this header
 
-// Windows extended ascii: https://msdn.microsoft.com/en-us/library/9hxt0028(v=vs.80).aspx
-// Unicode: http://unicode-table.com/en/#basic-latin
-// Mac OS Roman ascii: https://en.wikipedia.org/wiki/Mac_OS_Roman
-// Amiga ascii: http://www.amigacoding.com/index.php/AMOSi:ASCII_Table
+// select vector instruction set from compiler target
+#ifndef STRUSE_NO_SIMD
+#if defined(__AVX2__)
+#define STRUSE_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#define STRUSE_SSE2
+#if defined(__SSSE3__) || defined(__AVX__)
+#define STRUSE_SSSE3
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define STRUSE_NEON
+#endif
+#endif
 
-static const uint8_t _aMacOSRomanHigh_ToLower[0x80] = {
-	0x8a, 0x8c, 0x8d, 0x8e, 0x96, 0x9a, 0x9f, 0x87,
-	0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
-	0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97,
-	0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f,
-	0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
-	0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xbe, 0xbf,
-	0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7,
-	0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0xbf,
-	0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
-	0xc8, 0xc9, 0xca, 0x88, 0x8a, 0x9b, 0xcf, 0xcf,
-	0xd0, 0xd1, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7,
-	0xd8, 0xd8, 0xda, 0xdb, 0xdc, 0xdd, 0xde, 0xdf,
-	0xe0, 0xe1, 0xe2, 0xe3, 0xe4, 0x89, 0x90, 0x87,
-	0x91, 0x8f, 0x92, 0x94, 0x95, 0x93, 0x97, 0x99,
-	0xf0, 0x98, 0x9c, 0x9e, 0x9d, 0xfd, 0xfe, 0xff };
-
-static const uint8_t _aMacOSRomanHigh_ToUpper[0x80] = {
-	0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0xe7,
-	0xcb, 0xe5, 0x80, 0xcc, 0x81, 0x82, 0x83, 0xe9,
-	0xe6, 0xe8, 0xea, 0xed, 0xeb, 0xec, 0x84, 0xee,
-	0xf1, 0xef, 0x85, 0xcd, 0xf2, 0xf4, 0xf3, 0x86,
-	0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
-	0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xae, 0xaf,
-	0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7,
-	0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xae, 0xaf,
-	0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
-	0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xce,
-	0xd0, 0xd1, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7,
-	0xd9, 0xd9, 0xda, 0xdb, 0xdc, 0xdd, 0xde, 0xdf,
-	0xe0, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7,
-	0xe8, 0xe9, 0xea, 0xeb, 0xec, 0xed, 0xee, 0xef,
-	0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
-	0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff };
-
-
-uint8_t int_tolower_macos_roman_ascii(uint8_t c) {
-	if (c>='A' && c<='Z')
-		return (uint8_t)(c+'a'-'A');
-	if (c>=0x80)
-		return _aMacOSRomanHigh_ToLower[c&0x7f];
-	return c;
+#if defined(STRUSE_AVX2)
+#include <immintrin.h>
+#elif defined(STRUSE_SSSE3)
+#include <tmmintrin.h>
+#elif defined(STRUSE_SSE2)
+#include <emmintrin.h>
+#elif defined(STRUSE_NEON)
+#include <arm_neon.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h> // _BitScanForward
+#endif
+
+// index of lowest set bit (v must be non-zero)
+static inline int int_ctz32(uint32_t v)
+{
+#ifdef _MSC_VER
+	unsigned long i; _BitScanForward(&i, v); return (int)i;
+#else
+	return __builtin_ctz(v);
+#endif
 }
 
-uint8_t int_toupper_macos_roman_ascii(uint8_t c) {
-	if (c>='a' && c<='z')
-		return (uint8_t)(c+'A'-'a');
-	if (c>=0x80)
-		return _aMacOSRomanHigh_ToUpper[c&0x7f];
-	return c;
+// index of highest set bit (v must be non-zero)
+static inline int int_msb32(uint32_t v)
+{
+#ifdef _MSC_VER
+	unsigned long i; _BitScanReverse(&i, v); return (int)i;
+#else
+	return 31 - __builtin_clz(v);
+#endif
 }
 
-uint8_t int_tolower_amiga_ascii(uint8_t c) {
-	if (c>='A' && c<='Z')
-		return (uint8_t)(c+'a'-'A');
-	if (c>=0xc0 && c<0xe0)
-		return (uint8_t)(c+0x20);
-	return c;
+// 64 bit versions of the above
+static inline int int_ctz64(uint64_t v)
+{
+	uint32_t lo = (uint32_t)v;
+	return lo ? int_ctz32(lo) : (32 + int_ctz32((uint32_t)(v>>32)));
 }
 
-uint8_t int_toupper_amiga_ascii(uint8_t c) {
-	if (c>='a' && c<='z')
-		return (uint8_t)(c+'A'-'a');
-	if (c>=0xe0)
-		return (uint8_t)(c-0x20);
-	return c;
+static inline int int_msb64(uint64_t v)
+{
+	uint32_t hi = (uint32_t)(v>>32);
+	return hi ? (32 + int_msb32(hi)) : int_msb32((uint32_t)v);
 }
 
-uint8_t int_toupper_win_ascii(uint8_t c) {
-	if (c<'a')
-		return c;
-	if (c<='z')
-		return (uint8_t)(c+'A'-'a');
-	switch (c) {
-		case 0x84:
-			return 0x83;
-		case 0x86:
-			return 0x8f;
-		case 0x82:
-			return 0x90;
-		case 0x91:
-			return 0x92;
-		case 0x94:
-			return 0x99;
-		case 0x81:
-			return 0x9a;
-	}
-	return c;
+// number of set bits
+static inline int int_popcount32(uint32_t v)
+{
+#ifdef _MSC_VER
+	v = v - ((v>>1) & 0x55555555);
+	v = (v & 0x33333333) + ((v>>2) & 0x33333333);
+	return (int)((((v + (v>>4)) & 0x0f0f0f0f) * 0x01010101)>>24);
+#else
+	return __builtin_popcount(v);
+#endif
 }
 
-uint8_t int_tolower_win_ascii(uint8_t c) {
-	if (c<'A')
+// 16 byte vector helpers shared by SSE2 and NEON, masks have one bit per byte
+#if defined(STRUSE_SSE2)
+#define STRUSE_V16
+typedef __m128i int_v16;
+static inline int_v16 int_v16_load(const uint8_t *p) { return _mm_loadu_si128((const __m128i*)p); }
+static inline void int_v16_store(uint8_t *p, int_v16 v) { _mm_storeu_si128((__m128i*)p, v); }
+static inline int_v16 int_v16_set1(uint8_t c) { return _mm_set1_epi8((char)c); }
+static inline int_v16 int_v16_eq(int_v16 a, int_v16 b) { return _mm_cmpeq_epi8(a, b); }
+static inline int_v16 int_v16_or(int_v16 a, int_v16 b) { return _mm_or_si128(a, b); }
+static inline int_v16 int_v16_and(int_v16 a, int_v16 b) { return _mm_and_si128(a, b); }
+static inline int_v16 int_v16_xor(int_v16 a, int_v16 b) { return _mm_xor_si128(a, b); }
+static inline int_v16 int_v16_sub(int_v16 a, int_v16 b) { return _mm_sub_epi8(a, b); }
+static inline int_v16 int_v16_min(int_v16 a, int_v16 b) { return _mm_min_epu8(a, b); }
+static inline int_v16 int_v16_subs(int_v16 a, int_v16 b) { return _mm_subs_epu8(a, b); }
+static inline uint32_t int_v16_sum(int_v16 v) { __m128i t = _mm_sad_epu8(v, _mm_setzero_si128());
+	return (uint32_t)(_mm_cvtsi128_si32(t) + _mm_cvtsi128_si32(_mm_srli_si128(t, 8))); }
+static inline uint32_t int_v16_mask(int_v16 m) { return (uint32_t)_mm_movemask_epi8(m); }
+#ifdef STRUSE_SSSE3
+#define STRUSE_V16_LOOKUP
+static inline int_v16 int_v16_lookup(int_v16 table, int_v16 idx) { return _mm_shuffle_epi8(table, idx); }
+static inline int_v16 int_v16_lo_nibble(int_v16 v) { return _mm_and_si128(v, _mm_set1_epi8(0x0f)); }
+static inline int_v16 int_v16_hi_nibble(int_v16 v) { return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0f)); }
+static inline int_v16 int_v16_prev1(int_v16 v, int_v16 prev) { return _mm_alignr_epi8(v, prev, 15); }
+static inline int_v16 int_v16_prev2(int_v16 v, int_v16 prev) { return _mm_alignr_epi8(v, prev, 14); }
+static inline int_v16 int_v16_prev3(int_v16 v, int_v16 prev) { return _mm_alignr_epi8(v, prev, 13); }
+#endif
+static inline void int_v16_widen(uint16_t *p, int_v16 v) { __m128i z = _mm_setzero_si128();
+	_mm_storeu_si128((__m128i*)p, _mm_unpacklo_epi8(v, z)); _mm_storeu_si128((__m128i*)(p + 8), _mm_unpackhi_epi8(v, z)); }
+static inline void int_v16_widen(uint32_t *p, int_v16 v) { __m128i z = _mm_setzero_si128(), l = _mm_unpacklo_epi8(v, z), h = _mm_unpackhi_epi8(v, z);
+	_mm_storeu_si128((__m128i*)p, _mm_unpacklo_epi16(l, z)); _mm_storeu_si128((__m128i*)(p + 4), _mm_unpackhi_epi16(l, z));
+	_mm_storeu_si128((__m128i*)(p + 8), _mm_unpacklo_epi16(h, z)); _mm_storeu_si128((__m128i*)(p + 12), _mm_unpackhi_epi16(h, z)); }
+static inline bool int_v16_narrow(uint8_t *p, const uint16_t *s) {
+	__m128i a = _mm_loadu_si128((const __m128i*)s), b = _mm_loadu_si128((const __m128i*)(s + 8));
+	if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi16((short)0xff80)), _mm_setzero_si128()))!=0xffff)
+		return false;
+	_mm_storeu_si128((__m128i*)p, _mm_packus_epi16(a, b)); return true; }
+static inline bool int_v16_narrow(uint8_t *p, const uint32_t *s) {
+	__m128i a = _mm_loadu_si128((const __m128i*)s), b = _mm_loadu_si128((const __m128i*)(s + 4));
+	__m128i c = _mm_loadu_si128((const __m128i*)(s + 8)), d = _mm_loadu_si128((const __m128i*)(s + 12));
+	__m128i m = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), _mm_set1_epi32((int)0xffffff80));
+	if (_mm_movemask_epi8(_mm_cmpeq_epi8(m, _mm_setzero_si128()))!=0xffff)
+		return false;
+	_mm_storeu_si128((__m128i*)p, _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d))); return true; }
+#elif defined(STRUSE_NEON)
+#define STRUSE_V16
+typedef uint8x16_t int_v16;
+static inline int_v16 int_v16_load(const uint8_t *p) { return vld1q_u8(p); }
+static inline void int_v16_store(uint8_t *p, int_v16 v) { vst1q_u8(p, v); }
+static inline int_v16 int_v16_set1(uint8_t c) { return vdupq_n_u8(c); }
+static inline int_v16 int_v16_eq(int_v16 a, int_v16 b) { return vceqq_u8(a, b); }
+static inline int_v16 int_v16_or(int_v16 a, int_v16 b) { return vorrq_u8(a, b); }
+static inline int_v16 int_v16_and(int_v16 a, int_v16 b) { return vandq_u8(a, b); }
+static inline int_v16 int_v16_xor(int_v16 a, int_v16 b) { return veorq_u8(a, b); }
+static inline int_v16 int_v16_sub(int_v16 a, int_v16 b) { return vsubq_u8(a, b); }
+static inline int_v16 int_v16_min(int_v16 a, int_v16 b) { return vminq_u8(a, b); }
+static inline int_v16 int_v16_subs(int_v16 a, int_v16 b) { return vqsubq_u8(a, b); }
+static inline uint32_t int_v16_sum(int_v16 v) { return vaddlvq_u8(v); }
+#define STRUSE_V16_LOOKUP
+static inline int_v16 int_v16_lookup(int_v16 table, int_v16 idx) { return vqtbl1q_u8(table, idx); }
+static inline int_v16 int_v16_lo_nibble(int_v16 v) { return vandq_u8(v, vdupq_n_u8(0x0f)); }
+static inline int_v16 int_v16_hi_nibble(int_v16 v) { return vshrq_n_u8(v, 4); }
+static inline int_v16 int_v16_prev1(int_v16 v, int_v16 prev) { return vextq_u8(prev, v, 15); }
+static inline int_v16 int_v16_prev2(int_v16 v, int_v16 prev) { return vextq_u8(prev, v, 14); }
+static inline int_v16 int_v16_prev3(int_v16 v, int_v16 prev) { return vextq_u8(prev, v, 13); }
+static inline void int_v16_widen(uint16_t *p, int_v16 v) { vst1q_u16(p, vmovl_u8(vget_low_u8(v))); vst1q_u16(p + 8, vmovl_high_u8(v)); }
+static inline void int_v16_widen(uint32_t *p, int_v16 v) { uint16x8_t l = vmovl_u8(vget_low_u8(v)), h = vmovl_high_u8(v);
+	vst1q_u32(p, vmovl_u16(vget_low_u16(l))); vst1q_u32(p + 4, vmovl_high_u16(l));
+	vst1q_u32(p + 8, vmovl_u16(vget_low_u16(h))); vst1q_u32(p + 12, vmovl_high_u16(h)); }
+static inline bool int_v16_narrow(uint8_t *p, const uint16_t *s) {
+	uint16x8_t a = vld1q_u16(s), b = vld1q_u16(s + 8);
+	if (vmaxvq_u16(vorrq_u16(a, b))>=0x80)
+		return false;
+	vst1q_u8(p, vcombine_u8(vmovn_u16(a), vmovn_u16(b))); return true; }
+static inline bool int_v16_narrow(uint8_t *p, const uint32_t *s) {
+	uint32x4_t a = vld1q_u32(s), b = vld1q_u32(s + 4), c = vld1q_u32(s + 8), d = vld1q_u32(s + 12);
+	if (vmaxvq_u32(vorrq_u32(vorrq_u32(a, b), vorrq_u32(c, d)))>=0x80)
+		return false;
+	uint16x8_t l = vcombine_u16(vmovn_u32(a), vmovn_u32(b)), h = vcombine_u16(vmovn_u32(c), vmovn_u32(d));
+	vst1q_u8(p, vcombine_u8(vmovn_u16(l), vmovn_u16(h))); return true; }
+static inline uint32_t int_v16_mask(int_v16 m) {
+	static const uint8_t bits[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+	uint8x16_t t = vandq_u8(m, vld1q_u8(bits));
+	return (uint32_t)vaddv_u8(vget_low_u8(t)) | ((uint32_t)vaddv_u8(vget_high_u8(t))<<8); }
+#endif
+
+// Windows extended ascii: https://msdn.microsoft.com/en-us/library/9hxt0028(v=vs.80).aspx
+// Unicode: http://unicode-table.com/en/#basic-latin
+// Mac OS Roman ascii: https://en.wikipedia.org/wiki/Mac_OS_Roman
+// Amiga ascii: http://www.amigacoding.com/index.php/AMOSi:ASCII_Table
+
+// 256 entry case tables for each extended ascii code page, index by character
+static const uint8_t _aWinAscii_ToLower[0x100] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f,
+	0x40, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f,
+	0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x5b, 0x5c, 0x5d, 0x5e, 0x5f,
+	0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f,
+	0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x7b, 0x7c, 0x7d, 0x7e, 0x7f,
+	0x87, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x84, 0x86,
+	0x82, 0x91, 0x91, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x94, 0x81, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f,
+	0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa4, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xae, 0xaf,
+	0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0xbf,
+	0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf,
+	0xd0, 0xd1, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xdb, 0xdc, 0xdd, 0xde, 0xdf,
+	0xe0, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xeb, 0xec, 0xed, 0xee, 0xef,
+	0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff };
+
+static const uint8_t _aWinAscii_ToUpper[0x100] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f,
+	0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f,
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x5b, 0x5c, 0x5d, 0x5e, 0x5f,
+	0x60, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f,
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x7b, 0x7c, 0x7d, 0x7e, 0x7f,
+	0x80, 0x9a, 0x90, 0x83, 0x8e, 0x85, 0x8f, 0x80, 0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
+	0x90, 0x92, 0x92, 0x93, 0x99, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f,
+	0xa0, 0xa1, 0xa2, 0xa3, 0xa5, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xae, 0xaf,
+	0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0xbf,
+	0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf,
+	0xd0, 0xd1, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xdb, 0xdc, 0xdd, 0xde, 0xdf,
+	0xe0, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xeb, 0xec, 0xed, 0xee, 0xef,
+	0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff };
+
+static const uint8_t _aAmigaAscii_ToLower[0x100] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f,
+	0x40, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f,
+	0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x5b, 0x5c, 0x5d, 0x5e, 0x5f,
+	0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f,
+	0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x7b, 0x7c, 0x7d, 0x7e, 0x7f,
+	0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
+	0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f,
+	0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xae, 0xaf,
+	0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0xbf,
+	0xe0, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xeb, 0xec, 0xed, 0xee, 0xef,
+	0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff,
+	0xe0, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xeb, 0xec, 0xed, 0xee, 0xef,
+	0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff };
+
+static const uint8_t _aAmigaAscii_ToUpper[0x100] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f,
+	0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f,
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x5b, 0x5c, 0x5d, 0x5e, 0x5f,
+	0x60, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f,
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x7b, 0x7c, 0x7d, 0x7e, 0x7f,
+	0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
+	0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f,
+	0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xae, 0xaf,
+	0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0xbf,
+	0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf,
+	0xd0, 0xd1, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xdb, 0xdc, 0xdd, 0xde, 0xdf,
+	0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf,
+	0xd0, 0xd1, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xdb, 0xdc, 0xdd, 0xde, 0xdf };
+
+static const uint8_t _aMacOSRoman_ToLower[0x100] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f,
+	0x40, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f,
+	0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x5b, 0x5c, 0x5d, 0x5e, 0x5f,
+	0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f,
+	0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x7b, 0x7c, 0x7d, 0x7e, 0x7f,
+	0x8a, 0x8c, 0x8d, 0x8e, 0x96, 0x9a, 0x9f, 0x87, 0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
+	0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f,
+	0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xbe, 0xbf,
+	0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0xbf,
+	0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0x88, 0x8b, 0x9b, 0xcf, 0xcf,
+	0xd0, 0xd1, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd8, 0xda, 0xdb, 0xdc, 0xdd, 0xde, 0xdf,
+	0xe0, 0xe1, 0xe2, 0xe3, 0xe4, 0x89, 0x90, 0x87, 0x91, 0x8f, 0x92, 0x94, 0x95, 0x93, 0x97, 0x99,
+	0xf0, 0x98, 0x9c, 0x9e, 0x9d, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff };
+
+static const uint8_t _aMacOSRoman_ToUpper[0x100] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f,
+	0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f,
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x5b, 0x5c, 0x5d, 0x5e, 0x5f,
+	0x60, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f,
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x7b, 0x7c, 0x7d, 0x7e, 0x7f,
+	0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0xe7, 0xcb, 0xe5, 0x80, 0xcc, 0x81, 0x82, 0x83, 0xe9,
+	0xe6, 0xe8, 0xea, 0xed, 0xeb, 0xec, 0x84, 0xee, 0xf1, 0xef, 0x85, 0xcd, 0xf2, 0xf4, 0xf3, 0x86,
+	0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xae, 0xaf,
+	0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xae, 0xaf,
+	0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xce,
+	0xd0, 0xd1, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd9, 0xd9, 0xda, 0xdb, 0xdc, 0xdd, 0xde, 0xdf,
+	0xe0, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xeb, 0xec, 0xed, 0xee, 0xef,
+	0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff };
+
+uint8_t int_tolower_macos_roman_ascii(uint8_t c) { return _aMacOSRoman_ToLower[c]; }
+uint8_t int_toupper_macos_roman_ascii(uint8_t c) { return _aMacOSRoman_ToUpper[c]; }
+uint8_t int_tolower_amiga_ascii(uint8_t c) { return _aAmigaAscii_ToLower[c]; }
+uint8_t int_toupper_amiga_ascii(uint8_t c) { return _aAmigaAscii_ToUpper[c]; }
+uint8_t int_toupper_win_ascii(uint8_t c) { return _aWinAscii_ToUpper[c]; }
+uint8_t int_tolower_win_ascii(uint8_t c) { return _aWinAscii_ToLower[c]; }
+
+// unicode 14 simple case mappings in two levels, a block of 64 code points picks a row of
+// indices and each index is a code point delta for lowercase, uppercase and case folding
+#define STRUSE_UNICODE_CASE_END 0x1e944
+#define STRUSE_UNICODE_CASE_SHIFT 6
+
+static const uint8_t _aUnicodeCase_Block[1958] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 0, 0, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 21, 22, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 23, 24, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 25, 0, 0, 26, 27, 0, 28, 28, 29, 28, 30, 31, 32, 33,
+	0, 0, 0, 0, 34, 35, 36, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 37, 38, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 39, 40, 28, 41, 42, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 43, 44, 0, 45, 46, 47, 48,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 49, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 51, 52, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 53, 54, 55, 56, 0, 57, 58, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 59, 60, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 61, 62, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 63, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 64, 65 };
+
+static const uint8_t _aUnicodeCase_Index[4224] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+	0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 0,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 2, 2, 2, 2, 2, 2, 2, 4,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 7, 8, 5, 6, 5, 6, 5, 6, 0, 5, 6, 5, 6, 5, 6, 5,
+	6, 5, 6, 5, 6, 5, 6, 5, 6, 0, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 9, 5, 6, 5, 6, 5, 6, 10,
+	11, 12, 5, 6, 5, 6, 13, 5, 6, 14, 14, 5, 6, 0, 15, 16, 17, 5, 6, 14, 18, 19, 20, 21, 5, 6, 22, 0, 20, 23, 24, 25,
+	5, 6, 5, 6, 5, 6, 26, 5, 6, 26, 0, 0, 5, 6, 26, 5, 6, 27, 27, 5, 6, 5, 6, 28, 5, 6, 0, 0, 5, 6, 0, 29,
+	0, 0, 0, 0, 30, 31, 32, 30, 31, 32, 30, 31, 32, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 33, 5, 6,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 0, 30, 31, 32, 5, 6, 34, 35, 5, 6, 5, 6, 5, 6, 5, 6,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6,
+	36, 0, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 0, 0, 0, 0, 0, 0, 37, 5, 6, 38, 39, 40,
+	40, 5, 6, 41, 42, 43, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 44, 45, 46, 47, 48, 0, 49, 49, 0, 50, 0, 51, 52, 0, 0, 0,
+	49, 53, 0, 54, 0, 55, 56, 0, 57, 58, 56, 59, 60, 0, 0, 58, 0, 61, 62, 0, 0, 63, 0, 0, 0, 0, 0, 0, 0, 64, 0, 0,
+	65, 0, 66, 65, 0, 0, 0, 67, 65, 68, 69, 69, 70, 0, 0, 0, 0, 0, 71, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 72, 73, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 74, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 5, 6, 5, 6, 0, 0, 5, 6, 0, 0, 0, 24, 24, 24, 0, 75,
+	0, 0, 0, 0, 0, 0, 76, 0, 77, 77, 77, 0, 78, 0, 79, 79, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 80, 81, 81, 81, 0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 2, 82, 2, 2, 2, 2, 2, 2, 2, 2, 2, 83, 84, 84, 85, 86, 87, 0, 0, 0, 88, 89, 90, 5, 6, 5, 6, 5, 6, 5, 6,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 91, 92, 93, 94, 95, 96, 0, 5, 6, 97, 5, 6, 0, 36, 36, 36,
+	98, 98, 98, 98, 98, 98, 98, 98, 98, 98, 98, 98, 98, 98, 98, 98, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6,
+	5, 6, 0, 0, 0, 0, 0, 0, 0, 0, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6,
+	100, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 101, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 0, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102,
+	102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103,
+	103, 103, 103, 103, 103, 103, 103, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104,
+	104, 104, 104, 104, 104, 104, 0, 104, 0, 0, 0, 0, 0, 104, 0, 0, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105,
+	105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 0, 0, 105, 105, 105,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106,
+	106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106,
+	106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 107, 107, 107, 107, 107, 107, 0, 0, 108, 108, 108, 108, 108, 108, 0, 0,
+	109, 110, 111, 112, 112, 113, 114, 115, 116, 0, 0, 0, 0, 0, 0, 0, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117,
+	117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 0, 0, 117, 117, 117,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 118, 0, 0, 0, 119, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 120, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 0, 0, 0, 0, 0, 121, 0, 0, 122, 0,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6,
+	123, 123, 123, 123, 123, 123, 123, 123, 124, 124, 124, 124, 124, 124, 124, 124, 123, 123, 123, 123, 123, 123, 0, 0, 124, 124, 124, 124, 124, 124, 0, 0,
+	123, 123, 123, 123, 123, 123, 123, 123, 124, 124, 124, 124, 124, 124, 124, 124, 123, 123, 123, 123, 123, 123, 123, 123, 124, 124, 124, 124, 124, 124, 124, 124,
+	123, 123, 123, 123, 123, 123, 0, 0, 124, 124, 124, 124, 124, 124, 0, 0, 0, 123, 0, 123, 0, 123, 0, 123, 0, 124, 0, 124, 0, 124, 0, 124,
+	123, 123, 123, 123, 123, 123, 123, 123, 124, 124, 124, 124, 124, 124, 124, 124, 125, 125, 126, 126, 126, 126, 127, 127, 128, 128, 129, 129, 130, 130, 0, 0,
+	123, 123, 123, 123, 123, 123, 123, 123, 124, 124, 124, 124, 124, 124, 124, 124, 123, 123, 123, 123, 123, 123, 123, 123, 124, 124, 124, 124, 124, 124, 124, 124,
+	123, 123, 123, 123, 123, 123, 123, 123, 124, 124, 124, 124, 124, 124, 124, 124, 123, 123, 0, 131, 0, 0, 0, 0, 124, 124, 132, 132, 133, 0, 134, 0,
+	0, 0, 0, 131, 0, 0, 0, 0, 135, 135, 135, 135, 133, 0, 0, 0, 123, 123, 0, 0, 0, 0, 0, 0, 124, 124, 136, 136, 0, 0, 0, 0,
+	123, 123, 0, 0, 0, 93, 0, 0, 124, 124, 137, 137, 97, 0, 0, 0, 0, 0, 0, 131, 0, 0, 0, 0, 138, 138, 139, 139, 133, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 140, 0, 0, 0, 141, 142, 0, 0, 0, 0, 0, 0, 143, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 144, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	145, 145, 145, 145, 145, 145, 145, 145, 145, 145, 145, 145, 145, 145, 145, 145, 146, 146, 146, 146, 146, 146, 146, 146, 146, 146, 146, 146, 146, 146, 146, 146,
+	0, 0, 0, 5, 6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 147, 147, 147, 147, 147, 147, 147, 147, 147, 147,
+	147, 147, 147, 147, 147, 147, 147, 147, 147, 147, 147, 147, 147, 147, 147, 147, 148, 148, 148, 148, 148, 148, 148, 148, 148, 148, 148, 148, 148, 148, 148, 148,
+	148, 148, 148, 148, 148, 148, 148, 148, 148, 148, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102,
+	102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103,
+	103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103,
+	5, 6, 149, 150, 151, 152, 153, 5, 6, 5, 6, 5, 6, 154, 155, 156, 157, 0, 5, 6, 0, 5, 6, 0, 0, 0, 0, 0, 0, 0, 158, 158,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6,
+	5, 6, 5, 6, 0, 0, 0, 0, 0, 0, 0, 5, 6, 5, 6, 0, 0, 0, 5, 6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159, 159,
+	159, 159, 159, 159, 159, 159, 0, 159, 0, 0, 0, 0, 0, 159, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 0, 0, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 5, 6, 5, 6, 160, 5, 6,
+	5, 6, 5, 6, 5, 6, 5, 6, 0, 0, 0, 5, 6, 161, 0, 0, 5, 6, 5, 6, 162, 0, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6,
+	5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 163, 164, 165, 166, 163, 0, 167, 168, 169, 170, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6, 5, 6,
+	5, 6, 5, 6, 171, 172, 173, 5, 6, 5, 6, 0, 0, 0, 0, 0, 5, 6, 0, 0, 0, 0, 5, 6, 5, 6, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 5, 6, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 174, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175,
+	175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175,
+	175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+	0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176,
+	176, 176, 176, 176, 176, 176, 176, 176, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177,
+	177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176,
+	176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 0, 0, 0, 0, 177, 177, 177, 177, 177, 177, 177, 177,
+	177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 0, 178, 178, 178, 178,
+	178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 0, 178, 178, 178, 178, 178, 178, 178, 0, 178, 178, 0, 179, 179, 179, 179, 179, 179, 179, 179, 179,
+	179, 179, 0, 179, 179, 179, 179, 179, 179, 179, 179, 179, 179, 179, 179, 179, 179, 179, 0, 179, 179, 179, 179, 179, 179, 179, 0, 179, 179, 0, 0, 0,
+	78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78,
+	78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83,
+	83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 83, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180, 180,
+	180, 180, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181, 181,
+	181, 181, 181, 181, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+static const int32_t _aUnicodeCase_Delta[182][3] = {
+	{ 0, 0, 0 }, { 32, 0, 32 }, { 0, -32, 0 }, { 0, 743, 775 },
+	{ 0, 121, 0 }, { 1, 0, 1 }, { 0, -1, 0 }, { -199, 0, 0 },
+	{ 0, -232, 0 }, { -121, 0, -121 }, { 0, -300, -268 }, { 0, 195, 0 },
+	{ 210, 0, 210 }, { 206, 0, 206 }, { 205, 0, 205 }, { 79, 0, 79 },
+	{ 202, 0, 202 }, { 203, 0, 203 }, { 207, 0, 207 }, { 0, 97, 0 },
+	{ 211, 0, 211 }, { 209, 0, 209 }, { 0, 163, 0 }, { 213, 0, 213 },
+	{ 0, 130, 0 }, { 214, 0, 214 }, { 218, 0, 218 }, { 217, 0, 217 },
+	{ 219, 0, 219 }, { 0, 56, 0 }, { 2, 0, 2 }, { 1, -1, 1 },
+	{ 0, -2, 0 }, { 0, -79, 0 }, { -97, 0, -97 }, { -56, 0, -56 },
+	{ -130, 0, -130 }, { 10795, 0, 10795 }, { -163, 0, -163 }, { 10792, 0, 10792 },
+	{ 0, 10815, 0 }, { -195, 0, -195 }, { 69, 0, 69 }, { 71, 0, 71 },
+	{ 0, 10783, 0 }, { 0, 10780, 0 }, { 0, 10782, 0 }, { 0, -210, 0 },
+	{ 0, -206, 0 }, { 0, -205, 0 }, { 0, -202, 0 }, { 0, -203, 0 },
+	{ 0, 42319, 0 }, { 0, 42315, 0 }, { 0, -207, 0 }, { 0, 42280, 0 },
+	{ 0, 42308, 0 }, { 0, -209, 0 }, { 0, -211, 0 }, { 0, 10743, 0 },
+	{ 0, 42305, 0 }, { 0, 10749, 0 }, { 0, -213, 0 }, { 0, -214, 0 },
+	{ 0, 10727, 0 }, { 0, -218, 0 }, { 0, 42307, 0 }, { 0, 42282, 0 },
+	{ 0, -69, 0 }, { 0, -217, 0 }, { 0, -71, 0 }, { 0, -219, 0 },
+	{ 0, 42261, 0 }, { 0, 42258, 0 }, { 0, 84, 116 }, { 116, 0, 116 },
+	{ 38, 0, 38 }, { 37, 0, 37 }, { 64, 0, 64 }, { 63, 0, 63 },
+	{ 0, -38, 0 }, { 0, -37, 0 }, { 0, -31, 1 }, { 0, -64, 0 },
+	{ 0, -63, 0 }, { 8, 0, 8 }, { 0, -62, -30 }, { 0, -57, -25 },
+	{ 0, -47, -15 }, { 0, -54, -22 }, { 0, -8, 0 }, { 0, -86, -54 },
+	{ 0, -80, -48 }, { 0, 7, 0 }, { 0, -116, 0 }, { -60, 0, -60 },
+	{ 0, -96, -64 }, { -7, 0, -7 }, { 80, 0, 80 }, { 0, -80, 0 },
+	{ 15, 0, 15 }, { 0, -15, 0 }, { 48, 0, 48 }, { 0, -48, 0 },
+	{ 7264, 0, 7264 }, { 0, 3008, 0 }, { 38864, 0, 0 }, { 8, 0, 0 },
+	{ 0, -8, -8 }, { 0, -6254, -6222 }, { 0, -6253, -6221 }, { 0, -6244, -6212 },
+	{ 0, -6242, -6210 }, { 0, -6243, -6211 }, { 0, -6236, -6204 }, { 0, -6181, -6180 },
+	{ 0, 35266, 35267 }, { -3008, 0, -3008 }, { 0, 35332, 0 }, { 0, 3814, 0 },
+	{ 0, 35384, 0 }, { 0, -59, -58 }, { -7615, 0, -7615 }, { 0, 8, 0 },
+	{ -8, 0, -8 }, { 0, 74, 0 }, { 0, 86, 0 }, { 0, 100, 0 },
+	{ 0, 128, 0 }, { 0, 112, 0 }, { 0, 126, 0 }, { 0, 9, 0 },
+	{ -74, 0, -74 }, { -9, 0, -9 }, { 0, -7205, -7173 }, { -86, 0, -86 },
+	{ -100, 0, -100 }, { -112, 0, -112 }, { -128, 0, -128 }, { -126, 0, -126 },
+	{ -7517, 0, -7517 }, { -8383, 0, -8383 }, { -8262, 0, -8262 }, { 28, 0, 28 },
+	{ 0, -28, 0 }, { 16, 0, 16 }, { 0, -16, 0 }, { 26, 0, 26 },
+	{ 0, -26, 0 }, { -10743, 0, -10743 }, { -3814, 0, -3814 }, { -10727, 0, -10727 },
+	{ 0, -10795, 0 }, { 0, -10792, 0 }, { -10780, 0, -10780 }, { -10749, 0, -10749 },
+	{ -10783, 0, -10783 }, { -10782, 0, -10782 }, { -10815, 0, -10815 }, { 0, -7264, 0 },
+	{ -35332, 0, -35332 }, { -42280, 0, -42280 }, { 0, 48, 0 }, { -42308, 0, -42308 },
+	{ -42319, 0, -42319 }, { -42315, 0, -42315 }, { -42305, 0, -42305 }, { -42258, 0, -42258 },
+	{ -42282, 0, -42282 }, { -42261, 0, -42261 }, { 928, 0, 928 }, { -48, 0, -48 },
+	{ -42307, 0, -42307 }, { -35384, 0, -35384 }, { 0, -928, 0 }, { 0, -38864, -38864 },
+	{ 40, 0, 40 }, { 0, -40, 0 }, { 39, 0, 39 }, { 0, -39, 0 },
+	{ 34, 0, 34 }, { 0, -34, 0 } };
+
+// unicode case mapping used by int_unicode_case
+enum STRUSE_UNICODE_CASE {
+	SUC_LOWER,
+	SUC_UPPER,
+	SUC_FOLD,
+};
+
+// simple case mapping of a code point without branches other than the range check
+static inline size_t int_unicode_case(size_t c, STRUSE_UNICODE_CASE map)
+{
+	if (c>=STRUSE_UNICODE_CASE_END)
 		return c;
-	if (c<='Z')
-		return (uint8_t)(c+'a'-'A');
-	switch (c) {
-		case 0x8e:
-			return 0x84;
-		case 0x8f:
-			return 0x86;
-		case 0x90:
-			return 0x82;
-		case 0x92:
-			return 0x91;
-		case 0x99:
-			return 0x94;
-		case 0x9a:
-			return 0x81;
-	}
-	return c;
+	size_t row = size_t(_aUnicodeCase_Block[c>>STRUSE_UNICODE_CASE_SHIFT])<<STRUSE_UNICODE_CASE_SHIFT;
+	uint8_t i = _aUnicodeCase_Index[row | (c & ((1<<STRUSE_UNICODE_CASE_SHIFT)-1))];
+	return size_t(int32_t(c) + _aUnicodeCase_Delta[i][map]);
 }
 
 // General lowercase of unicode range
 size_t int_tolower_unicode(size_t c)
 {
-	if (c<'A' || c==0xd7 || c==0x138 || c==0x149)
-		return c;
-	if (c<='Z')
-		return c+'a'-'A';
-	if (c<0xc0)
-		return c;
-	if (c<0xe0 || (c>=0x391 && c<0x3ab) || (c>=0x3d8 && c<0x3f0) || (c>=0x410 && c<0x430))
-		return c+0x20;
-	if (c<0x100)
-		return c;
-	if (c<0x178) {
-		if (c>0x138 && c<0x149)
-			return ((c-1)|1)+1;
-		return c | 1;
-	}
-	if ((c>=0x460 && c<0x482) || (c>=0x48a && c<0x4c0) || (c>=0x4d0 && c<0x530))
-		return c | 1;
-	if (c>=0x4c1 && c<0x4cf)
-		return ((c-1)|1)+1;
-	if (c>=0x400 && c<0x410)
-		return c+0x50;
-
-	if (c>=0x531 && c<0x556)
-		return c+0x30;
-
-	if (c==0x178)
-		return 0xff;
-	if (c==0x4c0)
-		return 0x4cf;
-
-	return c;
+	return int_unicode_case(c, SUC_LOWER);
 }
 
 // General uppercase of unicode range
 size_t int_toupper_unicode(size_t c)
 {
-	if (c<'a' || c==0xd7 || c==0x138 || c==0x149)
-		return c;
-	if (c<='z')
-		return c+'A'-'c';
-	if (c<0xe0)
-		return c;
-	if (c==0xff)
-		return 0x178;
-	if (c<0x100 || (c>=0x3b1 && c<0x3cb) || (c>=0x3f8 && c<0x410) || (c>=0x430 && c<0x450))
-		return c-0x20;
-	if (c<0x178) {
-		if (c>0x138 && c<0x149)
-			return ((c-1)&1UL)+1;
-		return c & ~1UL;
-	}
-	if ((c>=0x460 && c<0x482) || (c>=0x48a && c<0x4c0) || (c>=0x4d0 && c<0x530))
-		return c & ~1UL;
-	if (c>=0x4c1 && c<0x4cf)
-		return ((c-1)&1UL)+1;
-	if (c>=0x450 && c<0x460)
-		return c-0x50;
-
-	if (c>=0x561 && c<0x586)
-		return c-0x30;
-
-	if (c==0x4cf)
-		return 0x4c0;
-
-	return c;
+	return int_unicode_case(c, SUC_UPPER);
 }
 
 // english latin lowercase
@@ -1340,6 +2342,77 @@ uint8_t int_toupper_ascii7(uint8_t c)
 	return c;
 }
 
+// read one utf8 character
+static inline size_t int_read_utf8(const uint8_t *s, const uint8_t *e, strl_t &skip)
+{
+	const uint8_t *start = s;
+	if (*s<0x80) {
+		skip = 1;
+		return *s;
+	}
+	size_t c = *s++ & 0x7f;
+	for (size_t m = 0x40; (m & c) && s<e; m <<= 5)
+		c = ((c & ~m) << 6) | (*s++ & 0x3f);
+	skip = strl_t(s - start);
+	return c;
+}
+
+// bytes needed to write a code as utf8
+static inline strl_t int_utf8_size(size_t c)
+{
+	return c<0x80 ? 1 : (c<0x800 ? 2 : (c<0x10000 ? 3 : 4));
+}
+
+// length of a well formed utf8 sequence starting at s or 0 if it is not one, overlong
+// sequences, surrogates and codes past 0x10ffff are not well formed
+static inline strl_t int_utf8_valid_len(const uint8_t *s, const uint8_t *e)
+{
+	uint8_t a = *s;
+	if (a<0x80)
+		return 1;
+	strl_t n = a>=0xf0 ? 4 : (a>=0xe0 ? 3 : 2);
+	if (a<0xc2 || a>=0xf5 || strl_t(e-s)<n)
+		return 0;
+	uint8_t lo = a==0xe0 ? 0xa0 : (a==0xf0 ? 0x90 : 0x80);
+	uint8_t hi = a==0xed ? 0x9f : (a==0xf4 ? 0x8f : 0xbf);
+	if (s[1]<lo || s[1]>hi)
+		return 0;
+	for (strl_t i = 2; i<n; i++) {
+		if ((s[i] & 0xc0)!=0x80)
+			return 0;
+	}
+	return n;
+}
+
+// case folded code of the next utf8 character, bytes that do not start a valid sequence
+// fold to a value outside of unicode so they only match themselves
+static inline size_t int_utf8_fold_next(const uint8_t *&s, const uint8_t *e)
+{
+	uint8_t a = *s;
+	if (a<0x80) {
+		s++;
+		return int_tolower_ascii7(a);
+	}
+	if (!int_utf8_valid_len(s, e)) {
+		s++;
+		return 0x110000 + a;
+	}
+	strl_t skip;
+	size_t c = int_read_utf8(s, e, skip);
+	s += skip;
+	return int_unicode_case(c, SUC_FOLD);
+}
+
+// true if the folded utf8 characters of n all match from the start of s
+static bool int_utf8_fold_prefix(const uint8_t *s, const uint8_t *se, const uint8_t *n, const uint8_t *ne)
+{
+	while (n<ne) {
+		if (s>=se || int_utf8_fold_next(s, se)!=int_utf8_fold_next(n, ne))
+			return false;
+	}
+	return true;
+}
+
 // convert escape codes to characters
 // supports: \a, \b, \f, \n, \r, \t, \v, \000, \x00
 // any other character is returned as same
@@ -1504,29 +2577,342 @@ unsigned int strref::fnv1a_ws(unsigned int seed) const
     return hash;
 }
 
-// convert numeric string to integer
-int64_t strref::atoi() const
+// hash64 constants
+#define STRUSE_HASH_P0 0xa0761d6478bd642fULL
+#define STRUSE_HASH_P1 0xe7037ed1a0b428dbULL
+
+// 64x64 bit multiply, returns low half of the result and high half in hi
+static inline uint64_t int_mul128(uint64_t a, uint64_t b, uint64_t &hi)
 {
-	if (string) {
-		const unsigned char *s = get_u();
-		const unsigned char *e = s + length;
-		while (s!=e && *s<=0x20) s++;
-		if (s<e) {
-			int64_t v = 0;
-			bool neg = *s=='-';
-			if (neg) s++;
-			while (s!=e) {
-				unsigned char c = *s++;
-				if (c<'0' || c>'9') break;
-				v = c-'0' + v*10;
-			}
-			return neg ? -v : v;
-		}
-	}
-	return 0;
+#if defined(__SIZEOF_INT128__)
+	__uint128_t r = (__uint128_t)a * b;
+	hi = (uint64_t)(r>>64);
+	return (uint64_t)r;
+#elif defined(_MSC_VER) && defined(_M_X64)
+	return _umul128(a, b, &hi);
+#else
+	uint64_t al = (uint32_t)a, ah = a>>32, bl = (uint32_t)b, bh = b>>32;
+	uint64_t ll = al*bl, lh = al*bh, hl = ah*bl, hh = ah*bh;
+	uint64_t mid = (ll>>32) + (uint32_t)lh + (uint32_t)hl;
+	hi = hh + (lh>>32) + (hl>>32) + (mid>>32);
+	return (ll & 0xffffffff) | (mid<<32);
+#endif
 }
 
-uint64_t strref::atoui() const
+// 64x64 bit multiply, high and low half of the result combined
+static inline uint64_t int_hash_mix(uint64_t a, uint64_t b)
+{
+	uint64_t hi, lo = int_mul128(a, b, hi);
+	return lo ^ hi;
+}
+
+// ascii7 lowercase of 8 characters packed in a word
+static inline uint64_t int_tolower_swar(uint64_t x)
+{
+	const uint64_t ones = 0x0101010101010101ULL;
+	uint64_t h = x & (0x7f*ones);
+	uint64_t upper = ((h + (0x80-'A')*ones) ^ (h + (0x7f-'Z')*ones)) & ~x & (0x80*ones);
+	return x | (upper>>2);
+}
+
+// little endian reads so hashes are the same on any platform
+static inline uint64_t int_read64(const uint8_t *p, bool lower)
+{
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__==__ORDER_BIG_ENDIAN__
+	v = __builtin_bswap64(v);
+#endif
+	return lower ? int_tolower_swar(v) : v;
+}
+
+static inline uint64_t int_read32(const uint8_t *p, bool lower)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__==__ORDER_BIG_ENDIAN__
+	v = __builtin_bswap32(v);
+#endif
+	return lower ? int_tolower_swar(v) : v;
+}
+
+static inline void int_write64(uint8_t *p, uint64_t v)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__==__ORDER_BIG_ENDIAN__
+	v = __builtin_bswap64(v);
+#endif
+	memcpy(p, &v, sizeof(v));
+}
+
+// hash 16 bytes into h
+static inline uint64_t int_hash_block(uint64_t h, const uint8_t *p, bool lower)
+{
+	return int_hash_mix(int_read64(p, lower) ^ STRUSE_HASH_P1, int_read64(p + 8, lower) ^ h);
+}
+
+// hash the last 0 to 16 bytes and the total length
+static inline uint64_t int_hash_tail(uint64_t h, const uint8_t *p, strl_t tail, uint64_t total, bool lower)
+{
+	uint64_t a = 0, b = 0;
+	if (tail>=8) {
+		a = int_read64(p, lower);
+		b = int_read64(p + tail - 8, lower);
+	} else if (tail>=4) {
+		a = int_read32(p, lower);
+		b = int_read32(p + tail - 4, lower);
+	} else if (tail) {
+		a = ((uint64_t)p[0]<<16) | ((uint64_t)p[tail>>1]<<8) | p[tail-1];
+		if (lower)
+			a = int_tolower_swar(a);
+	}
+	h = int_hash_mix(a ^ STRUSE_HASH_P1, b ^ h);
+	return int_hash_mix(h ^ total ^ STRUSE_HASH_P0, STRUSE_HASH_P1);
+}
+
+static uint64_t int_hash64(const uint8_t *p, strl_t len, uint64_t seed, bool lower)
+{
+	uint64_t h = int_hash_mix(seed ^ STRUSE_HASH_P0, STRUSE_HASH_P1);
+	strl_t left = len;
+	for (; left>16; left -= 16, p += 16)
+		h = int_hash_block(h, p, lower);
+	return int_hash_tail(h, p, left, len, lower);
+}
+
+// get 64 bit hash of a string
+uint64_t strref::hash64(uint64_t seed) const
+{
+	return int_hash64(get_u(), string ? length : 0, seed, false);
+}
+
+// get 64 bit hash of a string with ascii7 case ignored
+uint64_t strref::hash64_lower(uint64_t seed) const
+{
+	return int_hash64(get_u(), string ? length : 0, seed, true);
+}
+
+// 0x80 in each byte of x that is whitespace (0 to 0x20)
+static inline uint64_t int_ws_swar(uint64_t x)
+{
+	const uint64_t ones = 0x0101010101010101ULL;
+	return ~((x | (0x80*ones)) - 0x21*ones) & ~x & (0x80*ones);
+}
+
+// get 64 bit hash of a string treating any sequence of whitespace as a single space,
+// the same as hash64 of the string with whitespace replaced.
+uint64_t strref::hash64_ws(uint64_t seed) const
+{
+	const uint8_t *scan = get_u();
+	strl_t left = string ? length : 0;
+
+	// 8 characters at a time whitespace becomes a space and whitespace after whitespace
+	// is dropped, blocks are hashed once there is more data after them
+	const uint64_t ones = 0x0101010101010101ULL;
+	uint64_t h = int_hash_mix(seed ^ STRUSE_HASH_P0, STRUSE_HASH_P1);
+	uint8_t buf[24];
+	strl_t fill = 0;
+	uint64_t total = 0, prev_ws = 0;
+	while (left) {
+		strl_t n = left<8 ? left : 8;
+		uint64_t x, past = 0;
+		if (n==8)
+			x = int_read64(scan, false);
+		else {
+			// overlapping reads repeat the same characters so they can be combined
+			if (n>=4)
+				x = int_read32(scan, false) | (int_read32(scan + n - 4, false)<<(8*(n-4)));
+			else
+				x = scan[0] | ((uint64_t)scan[n>>1]<<(8*(n>>1))) | ((uint64_t)scan[n-1]<<(8*(n-1)));
+			past = (0x80*ones)<<(8*n);
+		}
+		uint64_t ws = int_ws_swar(x);
+		uint64_t drop = (ws & ((ws<<8) | prev_ws)) | past;
+		prev_ws = ws>>56;
+		if (ws) {
+			uint64_t lanes = (ws>>7) * 0xff;
+			x = (x & ~lanes) | (lanes & (' '*ones));
+		}
+		if (!drop) {
+			int_write64(buf + fill, x);
+			fill += 8;
+			total += 8;
+		} else {
+			strl_t start = fill;
+			for (int i = 0; i<8; ++i) {
+				buf[fill] = (uint8_t)(x>>(8*i));
+				fill += (strl_t)(((drop>>(8*i+7)) & 1) ^ 1);
+			}
+			total += fill - start;
+		}
+		if (fill>16) {
+			h = int_hash_block(h, buf, false);
+			memcpy(buf, buf + 16, 8);
+			fill -= 16;
+		}
+		scan += n;
+		left -= n;
+	}
+	return int_hash_tail(h, buf, fill, total, false);
+}
+
+// decimal digits are parsed 8 at a time, each byte xor '0' is 0-9 for a digit
+#define STRUSE_DIGITS_ZERO 0x3030303030303030ULL
+
+// bit 7 set in each byte of t (chunk xor '0') that is not a decimal digit
+static inline uint64_t int_nondigit_swar(uint64_t t)
+{
+	return (((t & 0x7f7f7f7f7f7f7f7fULL) + 0x7676767676767676ULL) | t) & 0x8080808080808080ULL;
+}
+
+// value of 8 digits 0-9, first digit in the lowest byte
+static inline uint64_t int_digits8_swar(uint64_t d)
+{
+	d = d * 10 + (d >> 8);
+	return (((d & 0x000000ff000000ffULL) * (100 + (1000000ULL << 32))) +
+		(((d >> 16) & 0x000000ff000000ffULL) * (1 + (10000ULL << 32)))) >> 32;
+}
+
+static const uint64_t int_pow10_u64[20] = {
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+	1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+	100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+	1000000000000000000ULL, 10000000000000000000ULL };
+
+// value of decimal digits at s into v, returns end of digits. v wraps the same
+// as a v = v*10 + c loop, only numbers over 19 digits are checked for overflow.
+static inline const uint8_t* int_parse_digits(const uint8_t *s, const uint8_t *e, uint64_t &v, bool &overflow)
+{
+	const uint8_t *b = s;
+	uint64_t r = 0;
+	for (;;) {
+		if ((e - s) < 8) {
+			for (; s != e; ++s) {
+				uint8_t c = uint8_t(*s - '0');
+				if (c > 9)
+					break;
+				r = r * 10 + c;
+			}
+			break;
+		}
+		uint64_t t = int_read64(s, false) ^ STRUSE_DIGITS_ZERO;
+		uint64_t nd = int_nondigit_swar(t);
+		if (!nd) {
+			r = r * 100000000ULL + int_digits8_swar(t);
+			s += 8;
+			continue;
+		}
+		int n = int_ctz64(nd) >> 3;
+		s += n;
+		if (n > 3)	// drop the non-digits, leading zero bytes add nothing
+			r = r * int_pow10_u64[n] + int_digits8_swar(t << ((8 - n) * 8));
+		else	// a few digits are quicker one by one
+			for (; n; --n, t >>= 8)
+				r = r * 10 + (t & 0xff);
+		break;
+	}
+	v = r;
+	if ((s - b) > 19) {
+		for (r = 0; b != s; ++b) {
+			uint64_t m = r * 10;
+			if (r > (~0ULL / 10) || (r = m + (*b - '0')) < m) {
+				overflow = true;
+				break;
+			}
+		}
+	}
+	return s;
+}
+
+// convert numeric string to integer
+int64_t strref::atoi() const
+{
+	if (string) {
+		const unsigned char *s = get_u();
+		const unsigned char *e = s + length;
+		while (s!=e && *s<=0x20) s++;
+		if (s<e) {
+			uint64_t v = 0;
+			bool neg = *s=='-', overflow = false;
+			if (neg) s++;
+			int_parse_digits(s, e, v, overflow);
+			return neg ? (int64_t)(0-v) : (int64_t)v;
+		}
+	}
+	return 0;
+}
+
+// parse a decimal integer and return the number of characters consumed
+strl_t strref::parse_uint(uint64_t &value, bool *overflow) const
+{
+	value = 0;
+	if (overflow)
+		*overflow = false;
+	if (!string)
+		return 0;
+	const uint8_t *b = get_u(), *s = b, *e = b + length;
+	while (s!=e && *s<=0x20) s++;
+	if (s!=e && *s=='+') s++;
+	bool ovf = false;
+	const uint8_t *d = int_parse_digits(s, e, value, ovf);
+	if (d==s)
+		return 0;
+	if (ovf)
+		value = ~0ULL;
+	if (overflow)
+		*overflow = ovf;
+	return strl_t(d-b);
+}
+
+strl_t strref::parse_int(int64_t &value, bool *overflow) const
+{
+	value = 0;
+	if (overflow)
+		*overflow = false;
+	if (!string)
+		return 0;
+	const uint8_t *b = get_u(), *s = b, *e = b + length;
+	while (s!=e && *s<=0x20) s++;
+	bool neg = false;
+	if (s!=e && (*s=='-' || *s=='+'))
+		neg = *s++=='-';
+	bool ovf = false;
+	uint64_t v = 0;
+	const uint8_t *d = int_parse_digits(s, e, v, ovf);
+	if (d==s)
+		return 0;
+	const uint64_t lim = neg ? (1ULL<<63) : ((1ULL<<63)-1);
+	if (ovf || v > lim) {
+		ovf = true;
+		v = lim;
+	}
+	value = neg ? (int64_t)(0-v) : (int64_t)v;
+	if (overflow)
+		*overflow = ovf;
+	return strl_t(d-b);
+}
+
+// fixed width field such as the parts of a time stamp
+int strref::atoi_fixed(strl_t pos, int digits) const
+{
+	if (!string || digits < 1 || digits > 8 || pos > length || strl_t(digits) > (length - pos))
+		return -1;
+	const uint8_t *s = get_u() + pos;
+	uint64_t t;
+	if ((length - pos) >= 8)
+		t = int_read64(s, false) << ((8 - digits) * 8);
+	else {
+		t = 0;
+		for (int i = 0; i < digits; ++i)
+			t |= uint64_t(s[i]) << ((8 - digits + i) * 8);
+	}
+	if (digits < 8)
+		t |= STRUSE_DIGITS_ZERO >> (digits * 8);	// pad with leading '0'
+	t ^= STRUSE_DIGITS_ZERO;
+	if (int_nondigit_swar(t))
+		return -1;
+	return (int)int_digits8_swar(t);
+}
+
+uint64_t strref::atoui() const
 {
 	if (string) {
 		const unsigned char *s = get_u();
@@ -1536,31 +2922,479 @@ uint64_t strref::atoui() const
 		if (left>=2 && *s=='0' && s[1]=='x' ) { return ahextou64(); }
 
 		uint64_t v = 0;
-		while (left) {
-			unsigned char c = *s++;
-			if (c<'0' || c>'9') break;
-			v = c-'0' + v*10;
-			--left;
-		}
+		bool overflow = false;
+		int_parse_digits(s, s + left, v, overflow);
 		return v;
 	}
 	return 0;
 }
 
+// powers of ten as normalized 128 bit mantissas rounded down (high, low), 10^-100 to 10^100.
+// numbers outside this range are still exact through the slower decimal conversion.
+#define STRUSE_POW10_MIN -100
+#define STRUSE_POW10_MAX 100
+static const uint64_t int_pow10_128[STRUSE_POW10_MAX - STRUSE_POW10_MIN + 1][2] = {
+	{0xdff9772470297ebdULL, 0x59787e2b93bc56f7ULL}, {0x8bfbea76c619ef36ULL, 0x57eb4edb3c55b65aULL},
+	{0xaefae51477a06b03ULL, 0xede622920b6b23f1ULL}, {0xdab99e59958885c4ULL, 0xe95fab368e45ecedULL},
+	{0x88b402f7fd75539bULL, 0x11dbcb0218ebb414ULL}, {0xaae103b5fcd2a881ULL, 0xd652bdc29f26a119ULL},
+	{0xd59944a37c0752a2ULL, 0x4be76d3346f0495fULL}, {0x857fcae62d8493a5ULL, 0x6f70a4400c562ddbULL},
+	{0xa6dfbd9fb8e5b88eULL, 0xcb4ccd500f6bb952ULL}, {0xd097ad07a71f26b2ULL, 0x7e2000a41346a7a7ULL},
+	{0x825ecc24c873782fULL, 0x8ed400668c0c28c8ULL}, {0xa2f67f2dfa90563bULL, 0x728900802f0f32faULL},
+	{0xcbb41ef979346bcaULL, 0x4f2b40a03ad2ffb9ULL}, {0xfea126b7d78186bcULL, 0xe2f610c84987bfa8ULL},
+	{0x9f24b832e6b0f436ULL, 0x0dd9ca7d2df4d7c9ULL}, {0xc6ede63fa05d3143ULL, 0x91503d1c79720dbbULL},
+	{0xf8a95fcf88747d94ULL, 0x75a44c6397ce912aULL}, {0x9b69dbe1b548ce7cULL, 0xc986afbe3ee11abaULL},
+	{0xc24452da229b021bULL, 0xfbe85badce996168ULL}, {0xf2d56790ab41c2a2ULL, 0xfae27299423fb9c3ULL},
+	{0x97c560ba6b0919a5ULL, 0xdccd879fc967d41aULL}, {0xbdb6b8e905cb600fULL, 0x5400e987bbc1c920ULL},
+	{0xed246723473e3813ULL, 0x290123e9aab23b68ULL}, {0x9436c0760c86e30bULL, 0xf9a0b6720aaf6521ULL},
+	{0xb94470938fa89bceULL, 0xf808e40e8d5b3e69ULL}, {0xe7958cb87392c2c2ULL, 0xb60b1d1230b20e04ULL},
+	{0x90bd77f3483bb9b9ULL, 0xb1c6f22b5e6f48c2ULL}, {0xb4ecd5f01a4aa828ULL, 0x1e38aeb6360b1af3ULL},
+	{0xe2280b6c20dd5232ULL, 0x25c6da63c38de1b0ULL}, {0x8d590723948a535fULL, 0x579c487e5a38ad0eULL},
+	{0xb0af48ec79ace837ULL, 0x2d835a9df0c6d851ULL}, {0xdcdb1b2798182244ULL, 0xf8e431456cf88e65ULL},
+	{0x8a08f0f8bf0f156bULL, 0x1b8e9ecb641b58ffULL}, {0xac8b2d36eed2dac5ULL, 0xe272467e3d222f3fULL},
+	{0xd7adf884aa879177ULL, 0x5b0ed81dcc6abb0fULL}, {0x86ccbb52ea94baeaULL, 0x98e947129fc2b4e9ULL},
+	{0xa87fea27a539e9a5ULL, 0x3f2398d747b36224ULL}, {0xd29fe4b18e88640eULL, 0x8eec7f0d19a03aadULL},
+	{0x83a3eeeef9153e89ULL, 0x1953cf68300424acULL}, {0xa48ceaaab75a8e2bULL, 0x5fa8c3423c052dd7ULL},
+	{0xcdb02555653131b6ULL, 0x3792f412cb06794dULL}, {0x808e17555f3ebf11ULL, 0xe2bbd88bbee40bd0ULL},
+	{0xa0b19d2ab70e6ed6ULL, 0x5b6aceaeae9d0ec4ULL}, {0xc8de047564d20a8bULL, 0xf245825a5a445275ULL},
+	{0xfb158592be068d2eULL, 0xeed6e2f0f0d56712ULL}, {0x9ced737bb6c4183dULL, 0x55464dd69685606bULL},
+	{0xc428d05aa4751e4cULL, 0xaa97e14c3c26b886ULL}, {0xf53304714d9265dfULL, 0xd53dd99f4b3066a8ULL},
+	{0x993fe2c6d07b7fabULL, 0xe546a8038efe4029ULL}, {0xbf8fdb78849a5f96ULL, 0xde98520472bdd033ULL},
+	{0xef73d256a5c0f77cULL, 0x963e66858f6d4440ULL}, {0x95a8637627989aadULL, 0xdde7001379a44aa8ULL},
+	{0xbb127c53b17ec159ULL, 0x5560c018580d5d52ULL}, {0xe9d71b689dde71afULL, 0xaab8f01e6e10b4a6ULL},
+	{0x9226712162ab070dULL, 0xcab3961304ca70e8ULL}, {0xb6b00d69bb55c8d1ULL, 0x3d607b97c5fd0d22ULL},
+	{0xe45c10c42a2b3b05ULL, 0x8cb89a7db77c506aULL}, {0x8eb98a7a9a5b04e3ULL, 0x77f3608e92adb242ULL},
+	{0xb267ed1940f1c61cULL, 0x55f038b237591ed3ULL}, {0xdf01e85f912e37a3ULL, 0x6b6c46dec52f6688ULL},
+	{0x8b61313bbabce2c6ULL, 0x2323ac4b3b3da015ULL}, {0xae397d8aa96c1b77ULL, 0xabec975e0a0d081aULL},
+	{0xd9c7dced53c72255ULL, 0x96e7bd358c904a21ULL}, {0x881cea14545c7575ULL, 0x7e50d64177da2e54ULL},
+	{0xaa242499697392d2ULL, 0xdde50bd1d5d0b9e9ULL}, {0xd4ad2dbfc3d07787ULL, 0x955e4ec64b44e864ULL},
+	{0x84ec3c97da624ab4ULL, 0xbd5af13bef0b113eULL}, {0xa6274bbdd0fadd61ULL, 0xecb1ad8aeacdd58eULL},
+	{0xcfb11ead453994baULL, 0x67de18eda5814af2ULL}, {0x81ceb32c4b43fcf4ULL, 0x80eacf948770ced7ULL},
+	{0xa2425ff75e14fc31ULL, 0xa1258379a94d028dULL}, {0xcad2f7f5359a3b3eULL, 0x096ee45813a04330ULL},
+	{0xfd87b5f28300ca0dULL, 0x8bca9d6e188853fcULL}, {0x9e74d1b791e07e48ULL, 0x775ea264cf55347dULL},
+	{0xc612062576589ddaULL, 0x95364afe032a819dULL}, {0xf79687aed3eec551ULL, 0x3a83ddbd83f52204ULL},
+	{0x9abe14cd44753b52ULL, 0xc4926a9672793542ULL}, {0xc16d9a0095928a27ULL, 0x75b7053c0f178293ULL},
+	{0xf1c90080baf72cb1ULL, 0x5324c68b12dd6338ULL}, {0x971da05074da7beeULL, 0xd3f6fc16ebca5e03ULL},
+	{0xbce5086492111aeaULL, 0x88f4bb1ca6bcf584ULL}, {0xec1e4a7db69561a5ULL, 0x2b31e9e3d06c32e5ULL},
+	{0x9392ee8e921d5d07ULL, 0x3aff322e62439fcfULL}, {0xb877aa3236a4b449ULL, 0x09befeb9fad487c2ULL},
+	{0xe69594bec44de15bULL, 0x4c2ebe687989a9b3ULL}, {0x901d7cf73ab0acd9ULL, 0x0f9d37014bf60a10ULL},
+	{0xb424dc35095cd80fULL, 0x538484c19ef38c94ULL}, {0xe12e13424bb40e13ULL, 0x2865a5f206b06fb9ULL},
+	{0x8cbccc096f5088cbULL, 0xf93f87b7442e45d3ULL}, {0xafebff0bcb24aafeULL, 0xf78f69a51539d748ULL},
+	{0xdbe6fecebdedd5beULL, 0xb573440e5a884d1bULL}, {0x89705f4136b4a597ULL, 0x31680a88f8953030ULL},
+	{0xabcc77118461cefcULL, 0xfdc20d2b36ba7c3dULL}, {0xd6bf94d5e57a42bcULL, 0x3d32907604691b4cULL},
+	{0x8637bd05af6c69b5ULL, 0xa63f9a49c2c1b10fULL}, {0xa7c5ac471b478423ULL, 0x0fcf80dc33721d53ULL},
+	{0xd1b71758e219652bULL, 0xd3c36113404ea4a8ULL}, {0x83126e978d4fdf3bULL, 0x645a1cac083126e9ULL},
+	{0xa3d70a3d70a3d70aULL, 0x3d70a3d70a3d70a3ULL}, {0xccccccccccccccccULL, 0xccccccccccccccccULL},
+	{0x8000000000000000ULL, 0x0000000000000000ULL}, {0xa000000000000000ULL, 0x0000000000000000ULL},
+	{0xc800000000000000ULL, 0x0000000000000000ULL}, {0xfa00000000000000ULL, 0x0000000000000000ULL},
+	{0x9c40000000000000ULL, 0x0000000000000000ULL}, {0xc350000000000000ULL, 0x0000000000000000ULL},
+	{0xf424000000000000ULL, 0x0000000000000000ULL}, {0x9896800000000000ULL, 0x0000000000000000ULL},
+	{0xbebc200000000000ULL, 0x0000000000000000ULL}, {0xee6b280000000000ULL, 0x0000000000000000ULL},
+	{0x9502f90000000000ULL, 0x0000000000000000ULL}, {0xba43b74000000000ULL, 0x0000000000000000ULL},
+	{0xe8d4a51000000000ULL, 0x0000000000000000ULL}, {0x9184e72a00000000ULL, 0x0000000000000000ULL},
+	{0xb5e620f480000000ULL, 0x0000000000000000ULL}, {0xe35fa931a0000000ULL, 0x0000000000000000ULL},
+	{0x8e1bc9bf04000000ULL, 0x0000000000000000ULL}, {0xb1a2bc2ec5000000ULL, 0x0000000000000000ULL},
+	{0xde0b6b3a76400000ULL, 0x0000000000000000ULL}, {0x8ac7230489e80000ULL, 0x0000000000000000ULL},
+	{0xad78ebc5ac620000ULL, 0x0000000000000000ULL}, {0xd8d726b7177a8000ULL, 0x0000000000000000ULL},
+	{0x878678326eac9000ULL, 0x0000000000000000ULL}, {0xa968163f0a57b400ULL, 0x0000000000000000ULL},
+	{0xd3c21bcecceda100ULL, 0x0000000000000000ULL}, {0x84595161401484a0ULL, 0x0000000000000000ULL},
+	{0xa56fa5b99019a5c8ULL, 0x0000000000000000ULL}, {0xcecb8f27f4200f3aULL, 0x0000000000000000ULL},
+	{0x813f3978f8940984ULL, 0x4000000000000000ULL}, {0xa18f07d736b90be5ULL, 0x5000000000000000ULL},
+	{0xc9f2c9cd04674edeULL, 0xa400000000000000ULL}, {0xfc6f7c4045812296ULL, 0x4d00000000000000ULL},
+	{0x9dc5ada82b70b59dULL, 0xf020000000000000ULL}, {0xc5371912364ce305ULL, 0x6c28000000000000ULL},
+	{0xf684df56c3e01bc6ULL, 0xc732000000000000ULL}, {0x9a130b963a6c115cULL, 0x3c7f400000000000ULL},
+	{0xc097ce7bc90715b3ULL, 0x4b9f100000000000ULL}, {0xf0bdc21abb48db20ULL, 0x1e86d40000000000ULL},
+	{0x96769950b50d88f4ULL, 0x1314448000000000ULL}, {0xbc143fa4e250eb31ULL, 0x17d955a000000000ULL},
+	{0xeb194f8e1ae525fdULL, 0x5dcfab0800000000ULL}, {0x92efd1b8d0cf37beULL, 0x5aa1cae500000000ULL},
+	{0xb7abc627050305adULL, 0xf14a3d9e40000000ULL}, {0xe596b7b0c643c719ULL, 0x6d9ccd05d0000000ULL},
+	{0x8f7e32ce7bea5c6fULL, 0xe4820023a2000000ULL}, {0xb35dbf821ae4f38bULL, 0xdda2802c8a800000ULL},
+	{0xe0352f62a19e306eULL, 0xd50b2037ad200000ULL}, {0x8c213d9da502de45ULL, 0x4526f422cc340000ULL},
+	{0xaf298d050e4395d6ULL, 0x9670b12b7f410000ULL}, {0xdaf3f04651d47b4cULL, 0x3c0cdd765f114000ULL},
+	{0x88d8762bf324cd0fULL, 0xa5880a69fb6ac800ULL}, {0xab0e93b6efee0053ULL, 0x8eea0d047a457a00ULL},
+	{0xd5d238a4abe98068ULL, 0x72a4904598d6d880ULL}, {0x85a36366eb71f041ULL, 0x47a6da2b7f864750ULL},
+	{0xa70c3c40a64e6c51ULL, 0x999090b65f67d924ULL}, {0xd0cf4b50cfe20765ULL, 0xfff4b4e3f741cf6dULL},
+	{0x82818f1281ed449fULL, 0xbff8f10e7a8921a4ULL}, {0xa321f2d7226895c7ULL, 0xaff72d52192b6a0dULL},
+	{0xcbea6f8ceb02bb39ULL, 0x9bf4f8a69f764490ULL}, {0xfee50b7025c36a08ULL, 0x02f236d04753d5b4ULL},
+	{0x9f4f2726179a2245ULL, 0x01d762422c946590ULL}, {0xc722f0ef9d80aad6ULL, 0x424d3ad2b7b97ef5ULL},
+	{0xf8ebad2b84e0d58bULL, 0xd2e0898765a7deb2ULL}, {0x9b934c3b330c8577ULL, 0x63cc55f49f88eb2fULL},
+	{0xc2781f49ffcfa6d5ULL, 0x3cbf6b71c76b25fbULL}, {0xf316271c7fc3908aULL, 0x8bef464e3945ef7aULL},
+	{0x97edd871cfda3a56ULL, 0x97758bf0e3cbb5acULL}, {0xbde94e8e43d0c8ecULL, 0x3d52eeed1cbea317ULL},
+	{0xed63a231d4c4fb27ULL, 0x4ca7aaa863ee4bddULL}, {0x945e455f24fb1cf8ULL, 0x8fe8caa93e74ef6aULL},
+	{0xb975d6b6ee39e436ULL, 0xb3e2fd538e122b44ULL}, {0xe7d34c64a9c85d44ULL, 0x60dbbca87196b616ULL},
+	{0x90e40fbeea1d3a4aULL, 0xbc8955e946fe31cdULL}, {0xb51d13aea4a488ddULL, 0x6babab6398bdbe41ULL},
+	{0xe264589a4dcdab14ULL, 0xc696963c7eed2dd1ULL}, {0x8d7eb76070a08aecULL, 0xfc1e1de5cf543ca2ULL},
+	{0xb0de65388cc8ada8ULL, 0x3b25a55f43294bcbULL}, {0xdd15fe86affad912ULL, 0x49ef0eb713f39ebeULL},
+	{0x8a2dbf142dfcc7abULL, 0x6e3569326c784337ULL}, {0xacb92ed9397bf996ULL, 0x49c2c37f07965404ULL},
+	{0xd7e77a8f87daf7fbULL, 0xdc33745ec97be906ULL}, {0x86f0ac99b4e8dafdULL, 0x69a028bb3ded71a3ULL},
+	{0xa8acd7c0222311bcULL, 0xc40832ea0d68ce0cULL}, {0xd2d80db02aabd62bULL, 0xf50a3fa490c30190ULL},
+	{0x83c7088e1aab65dbULL, 0x792667c6da79e0faULL}, {0xa4b8cab1a1563f52ULL, 0x577001b891185938ULL},
+	{0xcde6fd5e09abcf26ULL, 0xed4c0226b55e6f86ULL}, {0x80b05e5ac60b6178ULL, 0x544f8158315b05b4ULL},
+	{0xa0dc75f1778e39d6ULL, 0x696361ae3db1c721ULL}, {0xc913936dd571c84cULL, 0x03bc3a19cd1e38e9ULL},
+	{0xfb5878494ace3a5fULL, 0x04ab48a04065c723ULL}, {0x9d174b2dcec0e47bULL, 0x62eb0d64283f9c76ULL},
+	{0xc45d1df942711d9aULL, 0x3ba5d0bd324f8394ULL}, {0xf5746577930d6500ULL, 0xca8f44ec7ee36479ULL},
+	{0x9968bf6abbe85f20ULL, 0x7e998b13cf4e1ecbULL}, {0xbfc2ef456ae276e8ULL, 0x9e3fedd8c321a67eULL},
+	{0xefb3ab16c59b14a2ULL, 0xc5cfe94ef3ea101eULL}, {0x95d04aee3b80ece5ULL, 0xbba1f1d158724a12ULL},
+	{0xbb445da9ca61281fULL, 0x2a8a6e45ae8edc97ULL}, {0xea1575143cf97226ULL, 0xf52d09d71a3293bdULL},
+	{0x924d692ca61be758ULL, 0x593c2626705f9c56ULL},
+};
+
+// Eisel-Lemire, man * 10^exp10 as the bits of a float with mant_bits stored mantissa bits
+// and exponent bias. returns false if the result is not certain or is subnormal/infinite.
+static bool int_eisel_lemire(uint64_t man, int64_t exp10, int mant_bits, int bias, uint64_t &bits)
+{
+	if (exp10 < STRUSE_POW10_MIN || exp10 > STRUSE_POW10_MAX)
+		return false;
+	int clz = 63 - int_msb64(man);
+	man <<= clz;
+	uint64_t exp2 = uint64_t(((217706 * exp10) >> 16) + 64 + bias) - clz;
+	const uint64_t *pow10 = int_pow10_128[exp10 - STRUSE_POW10_MIN];
+	const int shift = 61 - mant_bits;
+	const uint64_t mask = (1ULL << shift) - 1;
+	uint64_t hi, lo = int_mul128(man, pow10[0], hi);
+	if ((hi & mask) == mask && (lo + man) < man) {
+		// low bits all set, include the rest of the power of ten
+		uint64_t yhi, ylo = int_mul128(man, pow10[1], yhi);
+		uint64_t mlo = lo + yhi, mhi = hi + (mlo < lo ? 1 : 0);
+		if ((mhi & mask) == mask && (mlo + 1) == 0 && (ylo + man) < man)
+			return false;
+		hi = mhi;
+		lo = mlo;
+	}
+	uint64_t msb = hi >> 63;
+	uint64_t m = hi >> (msb + shift);
+	exp2 -= 1 ^ msb;
+	if (lo == 0 && (hi & mask) == 0 && (m & 3) == 1)
+		return false;	// exactly half way
+	m = (m + (m & 1)) >> 1;
+	if (m >> (mant_bits + 1)) {
+		m >>= 1;
+		exp2++;
+	}
+	if ((exp2 - 1) >= uint64_t(2 * bias))
+		return false;
+	bits = (exp2 << mant_bits) | (m & ((1ULL << mant_bits) - 1));
+	return true;
+}
+
+// exact decimal number for the slow path of float conversion, enough digits
+// to round any double correctly. digits are 0-9, value is 0.d[0]d[1].. * 10^dp
+#define STRUSE_DECIMAL_DIGITS 800
+struct int_decimal {
+	uint8_t d[STRUSE_DECIMAL_DIGITS];
+	int nd, dp;
+	bool trunc;		// non-zero digits were dropped
+};
+
+static void int_decimal_trim(int_decimal &a)
+{
+	while (a.nd && !a.d[a.nd - 1])
+		a.nd--;
+	if (!a.nd)
+		a.dp = 0;
+}
+
+// divide by 2^k, k <= 60
+static void int_decimal_rshift(int_decimal &a, int k)
+{
+	int r = 0, w = 0;
+	uint64_t n = 0;
+	for (; !(n >> k); ++r) {
+		if (r >= a.nd) {
+			if (!n) {
+				a.nd = 0;
+				return;
+			}
+			for (; !(n >> k); ++r)
+				n *= 10;
+			break;
+		}
+		n = n * 10 + a.d[r];
+	}
+	a.dp -= r - 1;
+	const uint64_t mask = (1ULL << k) - 1;
+	for (; r < a.nd; ++r) {
+		a.d[w++] = uint8_t(n >> k);
+		n = (n & mask) * 10 + a.d[r];
+	}
+	while (n) {
+		uint8_t dig = uint8_t(n >> k);
+		n &= mask;
+		if (w < STRUSE_DECIMAL_DIGITS)
+			a.d[w++] = dig;
+		else if (dig)
+			a.trunc = true;
+		n *= 10;
+	}
+	a.nd = w;
+	int_decimal_trim(a);
+}
+
+// multiply by 2^k, k <= 60
+static void int_decimal_lshift(int_decimal &a, int k)
+{
+	uint64_t n = 0;
+	for (int r = a.nd - 1; r >= 0; --r)
+		n = (n + (uint64_t(a.d[r]) << k)) / 10;
+	int delta = 0;	// digits added at the top
+	for (; n; n /= 10)
+		delta++;
+	int w = a.nd + delta;
+	for (int r = a.nd - 1; r >= 0 || n; --r) {
+		if (r >= 0)
+			n += uint64_t(a.d[r]) << k;
+		uint64_t q = n / 10, rem = n - q * 10;
+		if (--w < STRUSE_DECIMAL_DIGITS)
+			a.d[w] = uint8_t(rem);
+		else if (rem)
+			a.trunc = true;
+		n = q;
+	}
+	a.nd += delta;
+	if (a.nd > STRUSE_DECIMAL_DIGITS)
+		a.nd = STRUSE_DECIMAL_DIGITS;
+	a.dp += delta;
+	int_decimal_trim(a);
+}
+
+static void int_decimal_shift(int_decimal &a, int k)
+{
+	for (; k > 60; k -= 60)
+		int_decimal_lshift(a, 60);
+	for (; k < -60; k += 60)
+		int_decimal_rshift(a, 60);
+	if (k > 0)
+		int_decimal_lshift(a, k);
+	else if (k < 0)
+		int_decimal_rshift(a, -k);
+}
+
+// true if digits from nd on round up to nearest even
+static bool int_decimal_round_up(const int_decimal &a, int nd)
+{
+	if (nd < 0 || nd >= a.nd)
+		return false;
+	if (a.d[nd] == 5 && (nd + 1) == a.nd)
+		return a.trunc || (nd > 0 && (a.d[nd - 1] & 1));
+	return a.d[nd] >= 5;
+}
+
+// integer part rounded to nearest even
+static uint64_t int_decimal_round(const int_decimal &a)
+{
+	if (a.dp > 20)
+		return ~0ULL;
+	uint64_t n = 0;
+	int i = 0;
+	for (; i < a.dp && i < a.nd; ++i)
+		n = n * 10 + a.d[i];
+	for (; i < a.dp; ++i)
+		n *= 10;
+	return n + (int_decimal_round_up(a, a.dp) ? 1 : 0);
+}
+
+// float bits without sign from an exact decimal, the decimal is modified
+static uint64_t int_decimal_to_bits(int_decimal &a, int mant_bits, int bias)
+{
+	static const int powtab[9] = { 1, 3, 6, 9, 13, 16, 19, 23, 26 };
+	const uint64_t inf = uint64_t(2 * bias + 1) << mant_bits;
+	if (!a.nd || a.dp < -330)
+		return 0;
+	if (a.dp > 310)
+		return inf;
+	// scale by powers of two into [0.5, 1)
+	int exp = 0;
+	while (a.dp > 0) {
+		int n = a.dp >= 9 ? 27 : powtab[a.dp];
+		int_decimal_shift(a, -n);
+		exp += n;
+	}
+	while (a.dp < 0 || (a.dp == 0 && a.d[0] < 5)) {
+		int n = -a.dp >= 9 ? 27 : powtab[-a.dp];
+		int_decimal_shift(a, n);
+		exp -= n;
+	}
+	exp--;	// [1, 2) range for the float exponent
+	if (exp < (1 - bias)) {	// subnormal
+		int_decimal_shift(a, exp - (1 - bias));
+		exp = 1 - bias;
+	}
+	if ((exp + bias) >= (2 * bias + 1))
+		return inf;
+	int_decimal_shift(a, 1 + mant_bits);
+	uint64_t mant = int_decimal_round(a);
+	if (mant == (2ULL << mant_bits)) {
+		mant >>= 1;
+		if (++exp + bias >= (2 * bias + 1))
+			return inf;
+	}
+	if (!(mant & (1ULL << mant_bits)))
+		exp = -bias;
+	return (uint64_t(exp + bias) << mant_bits) | (mant & ((1ULL << mant_bits) - 1));
+}
+
+// slow path, all digits of the number
+static uint64_t int_decimal_parse(const uint8_t *int_dig, strl_t int_len, const uint8_t *frac_dig, strl_t frac_len,
+	int64_t exp10, int mant_bits, int bias)
+{
+	int_decimal a;
+	a.nd = 0;
+	a.dp = 0;
+	a.trunc = false;
+	const uint8_t *p = int_dig;
+	for (strl_t n = int_len + frac_len; n; --n, ++p) {
+		if (n == frac_len)
+			p = frac_dig;
+		uint8_t c = uint8_t(*p - '0');
+		if (n > frac_len)
+			a.dp++;
+		if (!c && !a.nd) {
+			a.dp--;		// leading zero
+			continue;
+		}
+		if (a.nd < STRUSE_DECIMAL_DIGITS)
+			a.d[a.nd++] = c;
+		else if (c)
+			a.trunc = true;
+	}
+	a.dp += int(exp10);
+	int_decimal_trim(a);
+	return int_decimal_to_bits(a, mant_bits, bias);
+}
+
+// parse a decimal floating point number into the bits of a float or double,
+// returns end of the number or nullptr if there is no number
+static const uint8_t* int_parse_float(const uint8_t *s, const uint8_t *e, int mant_bits, int bias, uint64_t &bits)
+{
+	while (s != e && *s <= 0x20)
+		s++;
+	const uint64_t sign = 1ULL << (mant_bits + 1 + int_msb32(uint32_t(2 * bias + 1)));
+	bool neg = false;
+	if (s != e && (*s == '-' || *s == '+'))
+		neg = *s++ == '-';
+	bits = neg ? sign : 0;
+
+	// integer and fraction digits, first 19 accumulated in man
+	const uint8_t *int_dig = s;
+	uint64_t man = 0, frac = 0;
+	bool overflow = false;
+	s = int_parse_digits(s, e, man, overflow);
+	const uint8_t *frac_dig = s;
+	strl_t int_len = strl_t(s - int_dig), frac_len = 0;
+	if (s != e && *s == '.') {
+		frac_dig = s + 1;
+		const uint8_t *f = int_parse_digits(frac_dig, e, frac, overflow);
+		frac_len = strl_t(f - frac_dig);
+		if (int_len || frac_len)
+			s = f;
+	}
+	if (!int_len && !frac_len) {
+		// infinity or not a number
+		strl_t left = strl_t(e - s);
+		if (left >= 3 && (s[0] | 0x20) == 'i' && (s[1] | 0x20) == 'n' && (s[2] | 0x20) == 'f') {
+			bits |= uint64_t(2 * bias + 1) << mant_bits;
+			int i = 3;
+			while (i < 8 && i < int(left) && (s[i] | 0x20) == "infinity"[i])
+				i++;
+			return s + (i == 8 ? 8 : 3);
+		}
+		if (left >= 3 && (s[0] | 0x20) == 'n' && (s[1] | 0x20) == 'a' && (s[2] | 0x20) == 'n') {
+			bits |= (uint64_t(2 * bias + 1) << mant_bits) | (1ULL << (mant_bits - 1));
+			return s + 3;
+		}
+		bits = 0;
+		return nullptr;
+	}
+
+	// exponent, only if followed by digits
+	int64_t exp = 0;
+	if (s != e && (*s | 0x20) == 'e') {
+		const uint8_t *x = s + 1;
+		bool exp_neg = false;
+		if (x != e && (*x == '-' || *x == '+'))
+			exp_neg = *x++ == '-';
+		if (x != e && uint8_t(*x - '0') <= 9) {
+			for (; x != e && uint8_t(*x - '0') <= 9; ++x) {
+				if (exp < 100000)
+					exp = exp * 10 + (*x - '0');
+			}
+			if (exp_neg)
+				exp = -exp;
+			s = x;
+		}
+	}
+
+	int64_t exp10 = exp - frac_len;
+	bool trunc = false;
+	if ((int_len + frac_len) <= 19)
+		man = man * int_pow10_u64[frac_len] + frac;
+	else {
+		// first 19 significant digits
+		const uint8_t *p = int_dig;
+		strl_t ni = int_len, nf = frac_len;
+		while (ni && *p == '0') {
+			p++;
+			ni--;
+		}
+		if (!ni) {
+			for (p = frac_dig; nf && *p == '0'; ++p)
+				nf--;
+		}
+		int n = 0;
+		for (man = 0; ni && n < 19; --ni, ++n)
+			man = man * 10 + (*p++ - '0');
+		if (ni)
+			exp10 = exp + ni;
+		else {
+			if (p == frac_dig - 1)
+				p = frac_dig;	// step over '.'
+			for (; nf && n < 19; --nf, ++n)
+				man = man * 10 + (*p++ - '0');
+			exp10 = exp - strl_t(p - frac_dig);
+		}
+		trunc = (ni + nf) != 0;
+	}
+
+	uint64_t b, b1;
+	if (!man)
+		return s;
+	if (int_eisel_lemire(man, exp10, mant_bits, bias, b) &&
+		(!trunc || (int_eisel_lemire(man + 1, exp10, mant_bits, bias, b1) && b == b1))) {
+		bits |= b;
+		return s;
+	}
+	bits |= int_decimal_parse(int_dig, int_len, frac_dig, frac_len, exp, mant_bits, bias);
+	return s;
+}
+
+// parse floating point number in place, returns number of characters consumed
+strl_t strref::parse_double(double &value) const
+{
+	uint64_t bits = 0;
+	const uint8_t *end = string ? int_parse_float(get_u(), get_u() + length, 52, 1023, bits) : nullptr;
+	memcpy(&value, &bits, sizeof(value));
+	return end ? strl_t(end - get_u()) : 0;
+}
+
+strl_t strref::parse_float(float &value) const
+{
+	uint64_t bits = 0;
+	const uint8_t *end = string ? int_parse_float(get_u(), get_u() + length, 23, 127, bits) : nullptr;
+	uint32_t bits32 = uint32_t(bits);
+	memcpy(&value, &bits32, sizeof(value));
+	return end ? strl_t(end - get_u()) : 0;
+}
+
 // convert numeric string into floating point value
 float strref::atof() const {
-	if (string[length]==0)
-		return (float)::atof(string);
-	strown<64> num(*this);
-	return (float)::atof(num.c_str());
+	float value;
+	parse_float(value);
+	return value;
 }
 
 // convert numeric string into double precision floating point value
 double strref::atod() const {
-	if (string[length]==0)
-		return ::atof(string);
-	strown<64> num(*this);
-	return ::atof(num.c_str());
+	double value;
+	parse_double(value);
+	return value;
 }
 
 // convert numeric string to integer and move string forward
@@ -1577,20 +3411,94 @@ int strref::atoi_skip()
 	bool neg = false;
 	if (*scan=='-') {
 		neg = true;
-		left--;
-	}
-	int value = 0;
-	while (left) {
-		char c = *scan;
-		if (c<'0' || c>'9')
-			break;
-		left--;
 		scan++;
-		value = c-'0' + value*10;
+		left--;
 	}
+	uint64_t value = 0;
+	bool overflow = false;
+	const char *end = (const char*)int_parse_digits((const uint8_t*)scan, (const uint8_t*)scan + left, value, overflow);
+	left -= strl_t(end - scan);
 	string += length-left;
 	length = left;
-	return neg ? -value : value;
+	return neg ? (int)(0-value) : (int)value;
+}
+
+// hexadecimal digits are classified and converted 8 at a time, first character in the lowest byte.
+// returns the nibble value of each byte, bit 7 of bad is set in each byte that is not a hex digit.
+static inline uint64_t int_hex_swar(uint64_t c, uint64_t &bad)
+{
+	uint64_t u = (c | 0x2020202020202020ULL) ^ 0x6060606060606060ULL;	// a-f, A-F => 1-6
+	uint64_t u7 = u & 0x7f7f7f7f7f7f7f7fULL;
+	uint64_t letter = (u7 + 0x7f7f7f7f7f7f7f7fULL) & ~(u7 + 0x7979797979797979ULL) & ~u & 0x8080808080808080ULL;
+	bad = int_nondigit_swar(c ^ STRUSE_DIGITS_ZERO) & ~letter;
+	return (c & 0x0f0f0f0f0f0f0f0fULL) + (letter >> 7) * 9;
+}
+
+// 8 nibbles (first in lowest byte) packed into a 32 bit value, first nibble most significant
+static inline uint64_t int_nibbles8(uint64_t x)
+{
+	x = ((x << 4) | (x >> 8)) & 0x00ff00ff00ff00ffULL;
+	x = ((x << 8) | (x >> 16)) & 0x0000ffff0000ffffULL;
+	return ((x << 16) | (x >> 32)) & 0xffffffffULL;
+}
+
+static inline int int_hex_value(uint8_t c)
+{
+	if (uint8_t(c - '0') < 10)
+		return c - '0';
+	c = uint8_t((c | 0x20) - 'a');
+	return c < 6 ? (c + 10) : -1;
+}
+
+// value of hex digits at s, returns end of digits. v keeps the low 64 bits of longer numbers.
+static inline const uint8_t* int_parse_hex(const uint8_t *s, const uint8_t *e, uint64_t &v)
+{
+	uint64_t r = 0;
+	for (;;) {
+		if ((e - s) < 8) {
+			for (int h; s != e && (h = int_hex_value(*s)) >= 0; ++s)
+				r = (r << 4) | uint64_t(h);
+			break;
+		}
+		uint64_t bad, nib = int_hex_swar(int_read64(s, false), bad);
+		if (!bad) {
+			r = (r << 32) | int_nibbles8(nib);
+			s += 8;
+			continue;
+		}
+		int n = int_ctz64(bad) >> 3;
+		if (n)
+			r = (r << (n * 4)) | int_nibbles8(nib << ((8 - n) * 8));
+		s += n;
+		break;
+	}
+	v = r;
+	return s;
+}
+
+// value of binary digits at s, returns end of digits. v keeps the low 64 bits of longer numbers.
+static inline const uint8_t* int_parse_binary(const uint8_t *s, const uint8_t *e, uint64_t &v)
+{
+	uint64_t r = 0;
+	for (;;) {
+		if ((e - s) < 8) {
+			for (; s != e && uint8_t(*s - '0') < 2; ++s)
+				r = (r << 1) | uint64_t(*s - '0');
+			break;
+		}
+		uint64_t t = int_read64(s, false) ^ STRUSE_DIGITS_ZERO;
+		uint64_t bad = (((t & 0x7f7f7f7f7f7f7f7fULL) + 0x7e7e7e7e7e7e7e7eULL) | t) & 0x8080808080808080ULL;
+		int n = bad ? (int_ctz64(bad) >> 3) : 8;
+		if (n) {	// gather bit 0 of each byte, first byte to the top bit
+			t = (t << ((8 - n) * 8)) & 0x0101010101010101ULL;
+			r = (r << n) | ((t * 0x8040201008040201ULL) >> 56);
+		}
+		s += n;
+		if (n < 8)
+			break;
+	}
+	v = r;
+	return s;
 }
 
 // convert a hexadecimal string to an unsigned integer
@@ -1608,20 +3516,9 @@ size_t strref::ahextoui() const
 		scan += 2;
 		left -= 2;
 	}
-	strl_t hex = 0;
-	while (left) {
-		char c = *scan++;
-		left--;
-		if (c>='0' && c<='9')
-			hex = (hex<<4) | (c-'0');
-		else if (c>='a' && c<='f')
-			hex = (hex<<4) | (c-'a'+10);
-		else if (c>='A' && c<='F')
-			hex = (hex<<4) | (c-'A'+10);
-		else
-			break;
-	}
-	return hex;
+	uint64_t hex;
+	int_parse_hex((const uint8_t*)scan, (const uint8_t*)scan + left, hex);
+	return strl_t(hex);
 }
 
 // convert a hexadecimal string to an unsigned integer
@@ -1639,19 +3536,8 @@ uint64_t strref::ahextou64() const
 		scan += 2;
 		left -= 2;
 	}
-	uint64_t hex = 0;
-	while (left) {
-		char c = *scan++;
-		left--;
-		if (c>='0' && c<='9')
-			hex = (hex<<4) | (c-'0');
-		else if (c>='a' && c<='f')
-			hex = (hex<<4) | (c-'a'+10);
-		else if (c>='A' && c<='F')
-			hex = (hex<<4) | (c-'A'+10);
-		else
-			break;
-	}
+	uint64_t hex;
+	int_parse_hex((const uint8_t*)scan, (const uint8_t*)scan + left, hex);
 	return hex;
 }
 // convert a hexadecimal string to an unsigned integer
@@ -1669,23 +3555,43 @@ size_t strref::ahextoui_skip()
 		scan += 2;
 		left -= 2;
 	}
-	strl_t hex = 0;
-	while (left) {
-		char c = *scan;
-		if (c>='0' && c<='9')
-			hex = (hex<<4) | (c-'0');
-		else if (c>='a' && c<='f')
-			hex = (hex<<4) | (c-'a'+10);
-		else if (c>='A' && c<='F')
-			hex = (hex<<4) | (c-'A'+10);
-		else
-			break;
-		scan++;
-		left--;
-	}
+	uint64_t hex;
+	scan = (const char*)int_parse_hex((const uint8_t*)scan, (const uint8_t*)scan + left, hex);
 	length -= strl_t(scan-string);
 	string = scan;
-	return hex;
+	return strl_t(hex);
+}
+
+// decode a line of hex bytes, runs of hex digits are converted 8 characters at a time
+strl_t strref::ahextobytes(uint8_t *bytes, strl_t max_bytes) const
+{
+	const uint8_t *s = get_u(), *e = s + length;
+	strl_t n = 0;
+	if (!s)
+		return 0;
+	while (n < max_bytes) {
+		while (s != e && is_ws(*s))
+			s++;
+		if ((e - s) >= 8) {
+			uint64_t bad, nib = int_hex_swar(int_read64(s, false), bad);
+			strl_t pairs = (bad ? strl_t(int_ctz64(bad) >> 3) : 8) >> 1;
+			if (pairs > (max_bytes - n))
+				pairs = max_bytes - n;
+			uint64_t x = ((nib << 4) | (nib >> 8)) & 0x00ff00ff00ff00ffULL;
+			for (strl_t i = 0; i < pairs; ++i)
+				bytes[n++] = uint8_t(x >> (i * 16));
+			if (!pairs)
+				break;
+			s += pairs * 2;
+		} else {
+			int hi, lo;
+			if ((e - s) < 2 || (hi = int_hex_value(s[0])) < 0 || (lo = int_hex_value(s[1])) < 0)
+				break;
+			bytes[n++] = uint8_t((hi << 4) | lo);
+			s += 2;
+		}
+	}
+	return n;
 }
 
 // convert a binary string to an unsigned integer
@@ -1696,18 +3602,11 @@ size_t strref::abinarytoui_skip()
 	strl_t left = length;
 	if (!left)
 		return 0;
-	strl_t bin = 0;
-	while (left) {
-		uint8_t c = (uint8_t)*scan;
-		if (c<'0' || c>'1')
-			break;
-		scan++;
-		left--;
-		bin = (bin<<1) | (c-'0');
-	}
+	uint64_t bin;
+	scan = (const char*)int_parse_binary((const uint8_t*)scan, (const uint8_t*)scan + left, bin);
 	length -= strl_t(scan-string);
 	string = scan;
-	return bin;
+	return strl_t(bin);
 }
 // convert a hexadecimal string to a signed integer
 int strref::ahextoi() const
@@ -1729,19 +3628,8 @@ int strref::ahextoi() const
 		scan += 2;
 		left -= 2;
 	}
-	strl_t hex = 0;
-	while (left) {
-		char c = *scan++;
-		left--;
-		if (c>='0' && c<='9')
-			hex = (hex<<4) | (c-'0');
-		else if (c>='a' && c<='f')
-			hex = (hex<<4) | (c-'a'+10);
-		else if (c>='A' && c<='F')
-			hex = (hex<<4) | (c-'A'+10);
-		else
-			break;
-	}
+	uint64_t hex;
+	int_parse_hex((const uint8_t*)scan, (const uint8_t*)scan + left, hex);
 	return neg ? -(int)hex : (int)hex;
 }
 
@@ -1759,8 +3647,8 @@ int strref::count_char(char c) const
 	return count;
 }
 
-// find a character in a string
-static int int_find_char(char c, const char *scan, strl_t length)
+// find a character in a string, byte by byte
+static int int_find_char_bytes(char c, const char *scan, strl_t length)
 {
 	strl_t left = length;
 	while (left) {
@@ -1771,6 +3659,92 @@ static int int_find_char(char c, const char *scan, strl_t length)
 	return -1;
 }
 
+#ifndef STRUSE_V16
+// find a character in a string 8 bytes at a time (zero byte test on c xor text)
+static int int_find_char_swar(char c, const char *scan, strl_t length)
+{
+	const uint64_t ones = 0x0101010101010101ULL;
+	const uint64_t splat = ones * (uint8_t)c;
+	strl_t o = 0;
+	for (; (o+8)<=length; o += 8) {
+		uint64_t w;
+		memcpy(&w, scan + o, 8);
+		w ^= splat;
+		if ((w - ones) & ~w & (ones<<7))
+			return int(o) + int_find_char_bytes(c, scan + o, 8);
+	}
+	int f = int_find_char_bytes(c, scan + o, length - o);
+	return f<0 ? -1 : int(o + strl_t(f));
+}
+#endif
+
+#ifdef STRUSE_V16
+// find a character in a string 16 bytes at a time
+static int int_find_char_v16(char c, const char *scan, strl_t length)
+{
+	const uint8_t *s = (const uint8_t*)scan;
+	int_v16 m = int_v16_set1((uint8_t)c);
+	strl_t o = 0;
+	for (; (o+16)<=length; o += 16) {
+		if (uint32_t bits = int_v16_mask(int_v16_eq(int_v16_load(s + o), m)))
+			return int(o) + int_ctz32(bits);
+	}
+	int f = int_find_char_bytes(c, scan + o, length - o);
+	return f<0 ? -1 : int(o + strl_t(f));
+}
+#endif
+
+#ifdef STRUSE_AVX2
+// find a character in a string 32 bytes at a time
+static int int_find_char_avx2(char c, const char *scan, strl_t length)
+{
+	__m256i m = _mm256_set1_epi8(c);
+	strl_t o = 0;
+	for (; (o+32)<=length; o += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)(scan + o));
+		if (uint32_t bits = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, m)))
+			return int(o) + int_ctz32(bits);
+	}
+	int f = int_find_char_v16(c, scan + o, length - o);
+	return f<0 ? -1 : int(o + strl_t(f));
+}
+#endif
+
+// find a character in a string with the widest available search
+static int int_find_char(char c, const char *scan, strl_t length)
+{
+	if (length<16)
+		return int_find_char_bytes(c, scan, length);
+#if defined(STRUSE_AVX2)
+	return int_find_char_avx2(c, scan, length);
+#elif defined(STRUSE_V16)
+	return int_find_char_v16(c, scan, length);
+#else
+	return int_find_char_swar(c, scan, length);
+#endif
+}
+
+// find either of two characters in a string
+static int int_find_char2(char c, char d, const char *scan, strl_t length)
+{
+	strl_t o = 0;
+#ifdef STRUSE_V16
+	const uint8_t *s = (const uint8_t*)scan;
+	int_v16 mc = int_v16_set1((uint8_t)c), md = int_v16_set1((uint8_t)d);
+	for (; (o+16)<=length; o += 16) {
+		int_v16 v = int_v16_load(s + o);
+		if (uint32_t bits = int_v16_mask(int_v16_or(int_v16_eq(v, mc), int_v16_eq(v, md))))
+			return int(o) + int_ctz32(bits);
+	}
+#endif
+	for (; o<length; ++o) {
+		char n = scan[o];
+		if (n == c || n == d)
+			return int(o);
+	}
+	return -1;
+}
+
 // find a character in a string after pos
 int strref::find(char c) const
 {
@@ -1779,6 +3753,54 @@ int strref::find(char c) const
 	return int_find_char(c, string, length);
 }
 
+// find the last instance of a character in a string
+static int int_find_last_char(char c, const char *scan, strl_t length)
+{
+	strl_t o = length;
+#ifdef STRUSE_AVX2
+	__m256i m32 = _mm256_set1_epi8(c);
+	for (; o>=32; o -= 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)(scan + o - 32));
+		if (uint32_t bits = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, m32)))
+			return int(o - 32) + int_msb32(bits);
+	}
+#endif
+#ifdef STRUSE_V16
+	const uint8_t *s = (const uint8_t*)scan;
+	int_v16 m = int_v16_set1((uint8_t)c);
+	for (; o>=16; o -= 16) {
+		if (uint32_t bits = int_v16_mask(int_v16_eq(int_v16_load(s + o - 16), m)))
+			return int(o - 16) + int_msb32(bits);
+	}
+#endif
+	while (o) {
+		if (scan[--o] == c)
+			return int(o);
+	}
+	return -1;
+}
+
+// find the last instance of either of two characters in a string
+static int int_find_last_char2(char c, char d, const char *scan, strl_t length)
+{
+	strl_t o = length;
+#ifdef STRUSE_V16
+	const uint8_t *s = (const uint8_t*)scan;
+	int_v16 mc = int_v16_set1((uint8_t)c), md = int_v16_set1((uint8_t)d);
+	for (; o>=16; o -= 16) {
+		int_v16 v = int_v16_load(s + o - 16);
+		if (uint32_t bits = int_v16_mask(int_v16_or(int_v16_eq(v, mc), int_v16_eq(v, md))))
+			return int(o - 16) + int_msb32(bits);
+	}
+#endif
+	while (o) {
+		char n = scan[--o];
+		if (n == c || n == d)
+			return int(o);
+	}
+	return -1;
+}
+
 // find an instance of a char after pos
 int strref::find_after(char c, strl_t pos) const
 {
@@ -1839,46 +3861,25 @@ strl_t strref::find_or_full_esc(char c, strl_t pos) const
 // find last position of character c
 int strref::find_last(char c) const
 {
-	if (length && string) {
-		strl_t left = length;
-		const char *scan = string + left;
-		while (left) {
-			if (*--scan == c)
-				return int(left - 1);
-			left--;
-		}
-	}
+	if (length && string)
+		return int_find_last_char(c, string, length);
 	return -1;
 }
 
 // find first position of either c or d
 int strref::find(char c, char d) const
 {
-	strl_t left = length;
-	if (const char *scan = string) {
-		while (left) {
-			char n = *scan++;
-			if (n == c || n == d)
-				return int(length - left);
-			left--;
-		}
-	}
-	return -1;
+	if (!string)
+		return -1;
+	return int_find_char2(c, d, string, length);
 }
 
 // find last instance of either character c or d
+//	(the last character of the string is not checked)
 int strref::find_last(char c, char d) const
 {
-	if (length && string) {
-		strl_t left = length - 1;
-		const char *scan = string + left;
-		while (left) {
-			char n = *--scan;
-			if (n == c || n == d)
-				return int(left - 1);
-			left--;
-		}
-	}
+	if (length && string)
+		return int_find_last_char2(c, d, string, length - 1);
 	return -1;
 }
 
@@ -1922,6 +3923,142 @@ static bool int_compare_substr(const uint8_t *scan, strl_t length, const uint8_t
     return true;
 }
 
+// bit that ascii7 letters differ by between upper and lower case, or 0 for other characters
+static inline uint8_t int_fold_bit(uint8_t c)
+{
+	uint8_t l = c | 0x20;
+	return (l>='a' && l<='z') ? 0x20 : 0;
+}
+
+#ifdef STRUSE_V16
+// ascii7 lowercase 16 characters
+static inline int_v16 int_v16_tolower(int_v16 v)
+{
+	int_v16 t = int_v16_sub(v, int_v16_set1('A'));
+	int_v16 upper = int_v16_eq(int_v16_min(t, int_v16_set1('Z'-'A')), t);
+	return int_v16_or(v, int_v16_and(upper, int_v16_set1(0x20)));
+}
+#endif
+
+// compare len characters, ascii7 case ignored if fold
+static bool int_same_substr(const uint8_t *a, const uint8_t *b, strl_t len, bool fold)
+{
+#ifdef STRUSE_V16
+	for (; len>=16; len -= 16, a += 16, b += 16) {
+		int_v16 va = int_v16_load(a), vb = int_v16_load(b);
+		if (fold) {
+			va = int_v16_tolower(va);
+			vb = int_v16_tolower(vb);
+		}
+		if (int_v16_mask(int_v16_eq(va, vb))!=0xffff)
+			return false;
+	}
+#endif
+	if (!fold)
+		return memcmp(a, b, len)==0;
+	while (len--) {
+		if (int_tolower_ascii7(*a++)!=int_tolower_ascii7(*b++))
+			return false;
+	}
+	return true;
+}
+
+// find a substring, ascii7 case ignored if fold. Positions where both the first and
+// last character match are found a vector at a time and then compared in full.
+static int int_find_substr(const uint8_t *text, strl_t length, const uint8_t *sub, strl_t sub_len, bool fold)
+{
+	if (!sub_len || length<sub_len)
+		return -1;
+	strl_t last = sub_len-1;
+	strl_t mid = sub_len>2 ? sub_len-2 : 0;
+	uint8_t fm = fold ? int_fold_bit(sub[0]) : 0, lm = fold ? int_fold_bit(sub[last]) : 0;
+	uint8_t f = sub[0] | fm, l = sub[last] | lm;
+	strl_t end = length - last;	// number of positions to check
+	strl_t o = 0;
+#ifdef STRUSE_AVX2
+	__m256i f32 = _mm256_set1_epi8((char)f), l32 = _mm256_set1_epi8((char)l);
+	__m256i fm32 = _mm256_set1_epi8((char)fm), lm32 = _mm256_set1_epi8((char)lm);
+	for (; (o+32)<=end; o += 32) {
+		__m256i vf = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(text + o)), fm32);
+		__m256i vl = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(text + o + last)), lm32);
+		uint32_t bits = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(vf, f32), _mm256_cmpeq_epi8(vl, l32)));
+		for (; bits; bits &= bits-1) {
+			strl_t k = o + (strl_t)int_ctz32(bits);
+			if (int_same_substr(text + k + 1, sub + 1, mid, fold))
+				return int(k);
+		}
+	}
+#endif
+#ifdef STRUSE_V16
+	int_v16 f16 = int_v16_set1(f), l16 = int_v16_set1(l);
+	int_v16 fm16 = int_v16_set1(fm), lm16 = int_v16_set1(lm);
+	for (; (o+16)<=end; o += 16) {
+		int_v16 vf = int_v16_or(int_v16_load(text + o), fm16);
+		int_v16 vl = int_v16_or(int_v16_load(text + o + last), lm16);
+		for (uint32_t bits = int_v16_mask(int_v16_and(int_v16_eq(vf, f16), int_v16_eq(vl, l16))); bits; bits &= bits-1) {
+			strl_t k = o + (strl_t)int_ctz32(bits);
+			if (int_same_substr(text + k + 1, sub + 1, mid, fold))
+				return int(k);
+		}
+	}
+#endif
+	for (; o<end; ++o) {
+		if ((((text[o] | fm)==f) & ((text[o + last] | lm)==l)) && int_same_substr(text + o + 1, sub + 1, mid, fold))
+			return int(o);
+	}
+	return -1;
+}
+
+// find the last instance of a substring, ascii7 case ignored if fold
+static int int_find_last_substr(const uint8_t *text, strl_t length, const uint8_t *sub, strl_t sub_len, bool fold)
+{
+	if (!sub_len || length<sub_len)
+		return -1;
+	strl_t last = sub_len-1;
+	strl_t mid = sub_len>2 ? sub_len-2 : 0;
+	uint8_t fm = fold ? int_fold_bit(sub[0]) : 0, lm = fold ? int_fold_bit(sub[last]) : 0;
+	uint8_t f = sub[0] | fm, l = sub[last] | lm;
+	strl_t o = length - last;	// positions left to check
+#ifdef STRUSE_AVX2
+	__m256i f32 = _mm256_set1_epi8((char)f), l32 = _mm256_set1_epi8((char)l);
+	__m256i fm32 = _mm256_set1_epi8((char)fm), lm32 = _mm256_set1_epi8((char)lm);
+	for (; o>=32; o -= 32) {
+		__m256i vf = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(text + o - 32)), fm32);
+		__m256i vl = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(text + o - 32 + last)), lm32);
+		uint32_t bits = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(vf, f32), _mm256_cmpeq_epi8(vl, l32)));
+		while (bits) {
+			int b = int_msb32(bits);
+			strl_t k = o - 32 + (strl_t)b;
+			if (int_same_substr(text + k + 1, sub + 1, mid, fold))
+				return int(k);
+			bits ^= 1u<<b;
+		}
+	}
+#endif
+#ifdef STRUSE_V16
+	int_v16 f16 = int_v16_set1(f), l16 = int_v16_set1(l);
+	int_v16 fm16 = int_v16_set1(fm), lm16 = int_v16_set1(lm);
+	for (; o>=16; o -= 16) {
+		int_v16 vf = int_v16_or(int_v16_load(text + o - 16), fm16);
+		int_v16 vl = int_v16_or(int_v16_load(text + o - 16 + last), lm16);
+		uint32_t bits = int_v16_mask(int_v16_and(int_v16_eq(vf, f16), int_v16_eq(vl, l16)));
+		while (bits) {
+			int b = int_msb32(bits);
+			strl_t k = o - 16 + (strl_t)b;
+			if (int_same_substr(text + k + 1, sub + 1, mid, fold))
+				return int(k);
+			bits ^= 1u<<b;
+		}
+	}
+#endif
+	while (o) {
+		--o;
+		if ((((text[o] | fm)==f) & ((text[o + last] | lm)==l)) && int_same_substr(text + o + 1, sub + 1, mid, fold))
+			return int(o);
+	}
+	return -1;
+}
+
 // case sensitive rolling hash find substring
 int _find_rh_case(const char *text, strl_t length, const char *comp, strl_t comp_length)
 {
@@ -1960,8 +4097,10 @@ int _find_rh_case(const char *text, strl_t length, const char *comp, strl_t comp
 }
 
 // case ignore rolling hash find substring
-int _find_rh(const uint8_t *text, strl_t length, const uint8_t *comp, strl_t comp_length)
+int _find_rh(const char *text_str, strl_t length, const char *comp_str, strl_t comp_length)
 {
+	const uint8_t *text = (const uint8_t*)text_str;
+	const uint8_t *comp = (const uint8_t*)comp_str;
 	if (length < comp_length)
 		return -1;
 
@@ -1986,7 +4125,7 @@ int _find_rh(const uint8_t *text, strl_t length, const uint8_t *comp, strl_t com
 		if (roll_hash == hash) {
 			// compare!
 			if (int_compare_substr(text - comp_length, left + comp_length, comp, comp_length))
-				return int(left - length + comp_length);
+				return int(length - comp_length - left);
 		}
 		if (!left)
 			break;
@@ -2069,6 +4208,85 @@ bool strref::same_str(const strref str) const
 	return true;
 }
 
+#ifdef STRUSE_V16
+// number of bytes from the start of two strings that are the same apart from ascii case,
+// up to n and cut back to a utf8 character start. Both strings must have more than n bytes.
+static strl_t int_utf8_same_ascii_case(const uint8_t *a, const uint8_t *b, strl_t n)
+{
+	strl_t o = 0;
+	for (; (o+16)<=n; o += 16) {
+		uint32_t same = int_v16_mask(int_v16_eq(int_v16_tolower(int_v16_load(a + o)), int_v16_tolower(int_v16_load(b + o))));
+		if (same!=0xffff) {
+			o += int_ctz32(~same);
+			break;
+		}
+	}
+	if (o>n)
+		o = n;
+	for (strl_t back = 0; o && back<3 && ((a[o] & 0xc0)==0x80 || (b[o] & 0xc0)==0x80); back++)
+		o--;
+	return o;
+}
+#endif
+
+// compare two utf8 strings with unicode simple case folding
+bool strref::same_str_utf8(const strref str) const
+{
+	if (!length || !str.length)
+		return length==str.length;
+	const uint8_t *a = get_u(), *ae = a + length, *b = str.get_u(), *be = b + str.length;
+	while (a<ae && b<be) {
+#ifdef STRUSE_V16
+		strl_t n = strl_t((ae-a)<(be-b) ? (ae-a) : (be-b));
+		if (n>16) {
+			strl_t same = int_utf8_same_ascii_case(a, b, n-1);
+			a += same;
+			b += same;
+		}
+#endif
+		if (int_utf8_fold_next(a, ae)!=int_utf8_fold_next(b, be))
+			return false;
+	}
+	return a==ae && b==be;
+}
+
+// find utf8 with unicode simple case folding
+int strref::find_utf8(const strref str, strl_t pos) const
+{
+	if (!str.length || pos>=length)
+		return -1;
+	const uint8_t *t = get_u(), *e = t + length, *n = str.get_u(), *ne = n + str.length;
+	const uint8_t *next = n;
+	size_t first = int_utf8_fold_next(next, ne);
+
+	// characters that can start a match, the first character in either ascii case or any
+	// byte from 0x80 as characters like the kelvin sign fold to ascii
+	uint8_t c1 = first<0x80 ? uint8_t(first) : 0x80, c2 = int_toupper_ascii7(c1);
+	strl_t o = pos;
+#ifdef STRUSE_V16
+	int_v16 v1 = int_v16_set1(c1), v2 = int_v16_set1(c2), ascii = int_v16_set1(0x7f);
+#endif
+	while (o<length) {
+#ifdef STRUSE_V16
+		for (; (o+16)<=length; o += 16) {
+			int_v16 v = int_v16_load(t + o);
+			int_v16 high = int_v16_eq(int_v16_min(v, ascii), v);
+			if (uint32_t m = int_v16_mask(int_v16_or(int_v16_eq(v, v1), int_v16_eq(v, v2))) | (int_v16_mask(high) ^ 0xffff)) {
+				o += int_ctz32(m);
+				break;
+			}
+		}
+		if (o>=length)
+			break;
+#endif
+		uint8_t c = t[o];
+		if ((c==c1 || c==c2 || c>=0x80) && int_utf8_fold_prefix(t + o, e, n, ne))
+			return int(o);
+		o++;
+	}
+	return -1;
+}
+
 // mid string compare
 bool strref::same_substr(const strref str, strl_t pos) const {
 	if ((str.length+pos) > length)
@@ -2083,6 +4301,7 @@ bool strref::same_substr_esc(const strref str, strl_t pos) const {
 		return false;
 
 	const uint8_t *scan = get_u() + pos;
+	strl_t scan_left = length - pos;
 	const uint8_t *compare = str.get_u();
 	strl_t compare_left = str.length;
 	while (compare_left) {
@@ -2093,8 +4312,9 @@ bool strref::same_substr_esc(const strref str, strl_t pos) const {
 			compare += skip;
 			compare_left -= skip;
 		}
-		if (int_tolower_ascii7(*scan++) != int_tolower_ascii7(c))
+		if (!scan_left || int_tolower_ascii7(*scan++) != int_tolower_ascii7(c))
 			return false;
+		scan_left--;
 	}
 	return true;
 }
@@ -2113,6 +4333,7 @@ bool strref::same_substr_case_esc(const strref str, strl_t pos) const {
 		return false;
 
 	const uint8_t *scan = get_u() + pos;
+	strl_t scan_left = length - pos;
 	const uint8_t *compare = str.get_u();
 	strl_t compare_left = str.length;
 	while (compare_left) {
@@ -2123,8 +4344,9 @@ bool strref::same_substr_case_esc(const strref str, strl_t pos) const {
 			compare += skip;
 			compare_left -= skip;
 		}
-		if (*scan++ != c)
+		if (!scan_left || *scan++ != c)
 			return false;
+		scan_left--;
 	}
 	return true;
 }
@@ -2420,34 +4642,18 @@ strl_t strref::suffix_len_case(const strref str) const
 	while (left) {
 		if (*(--scan)!=*(--compare))
 			break;
-		count++;
-		left--;
-	}
-	return count;
-}
-
-// find a substring within a string case ignored
-int strref::find(const strref str) const
-{
-	if (!str.valid() || !valid() || length<str.length)
-		return -1;
-
-	const uint8_t *scan = get_u();
-	strl_t left = length;
-
-	const uint8_t *compare = str.get_u();
-	strl_t find_len = str.length;
-
-	uint8_t c = int_tolower_ascii7(*compare++);
-
-	while (left>=find_len) {
-		if (int_tolower_ascii7(*scan++)==c) {
-			if (int_compare_substr(scan, left - 1, compare, find_len - 1))
-				return int(length-left);
-		}
+		count++;
 		left--;
 	}
-	return -1;
+	return count;
+}
+
+// find a substring within a string case ignored
+int strref::find(const strref str) const
+{
+	if (!str.valid() || !valid())
+		return -1;
+	return int_find_substr(get_u(), length, str.get_u(), str.length, true);
 }
 
 // find a substring within a string case ignored
@@ -2456,6 +4662,8 @@ int strref::find_bookend(const strref str, const strref bookend) const
 	if (!str.valid() || !valid() || length<str.length)
 		return -1;
 
+	strrange book(bookend);
+
 	const uint8_t *scan = get_u();
 	strl_t left = length;
 
@@ -2467,8 +4675,8 @@ int strref::find_bookend(const strref str, const strref bookend) const
 
 	while (left >= find_len) {
 		uint8_t d = int_tolower_ascii7(*scan++);
-		if (d == c && (left == length || bookend.char_matches_ranges(p)) &&
-			(left == find_len || bookend.char_matches_ranges(int_tolower_ascii7(scan[find_len-1])))) {
+		if (d == c && (left == length || book.has(p)) &&
+			(left == find_len || book.has(int_tolower_ascii7(scan[find_len-1])))) {
 			if (int_compare_substr(scan, left - 1, compare, find_len - 1))
 				return int(length - left);
 		}
@@ -2480,25 +4688,10 @@ int strref::find_bookend(const strref str, const strref bookend) const
 // find a substring within a string case ignored starting at pos
 int strref::find(const strref str, strl_t pos) const
 {
-	if (!str.valid() || !valid() || length<str.length)
+	if (!str.valid() || !valid() || pos>=length)
 		return -1;
-
-	const uint8_t *scan = get_u() + pos;
-	strl_t left = length - pos;
-
-	const uint8_t *compare = str.get_u();
-	strl_t find_len = str.length;
-
-	uint8_t c = int_tolower_ascii7(*compare++);
-	while (left >= find_len) {
-		if (int_tolower_ascii7(*scan++) == c) {
-			if (int_compare_substr(scan, left - 1, compare, find_len - 1))
-				return int(length - left);
-		}
-		left--;
-	}
-
-	return -1;
+	int o = int_find_substr(get_u() + pos, length - pos, str.get_u(), str.length, true);
+	return o<0 ? -1 : int(o + pos);
 }
 
 // find case sensitive allow escape codes (\x => x) in search string
@@ -2523,21 +4716,22 @@ int strref::find_esc(const strref str, strl_t pos) const
 		compare += skip;
 		compare_left -= skip;
 	}
+	c = int_tolower_ascii7(c);
 
 	// sweep the scan buffer for the matching string
 	while (scan_left) {
-		if (*scan++ == c) {
+		if (int_tolower_ascii7(*scan++) == c) {
 			const uint8_t *chk_scan = scan;
 			const uint8_t *chk_compare = compare;
-			strl_t chk_scan_left = scan_left;
+			strl_t chk_scan_left = scan_left - 1;
 			strl_t chk_compare_left = compare_left;
 			while (chk_compare_left) {
 				uint8_t d = *chk_compare++;
 				chk_compare_left--;
-				if (d=='\\' && compare_left) {
-					strl_t skip = int_get_esc_code(compare, compare_left, d);
-					compare += skip;
-					compare_left -= skip;
+				if (d=='\\' && chk_compare_left) {
+					strl_t skip = int_get_esc_code(chk_compare, chk_compare_left, d);
+					chk_compare += skip;
+					chk_compare_left -= skip;
 				}
 				if (!chk_scan_left || int_tolower_ascii7(*chk_scan++)!=int_tolower_ascii7(d)) {
 					chk_compare_left = 1;
@@ -2558,63 +4752,18 @@ int strref::find(const char *str, strl_t pos) const
 {
 	if (!str || !valid() || pos>=length)
 		return -1;
-
-	const uint8_t *stru = (const uint8_t*)str;
-	uint8_t c = int_tolower_ascii7(*stru++);
-	if (!c)
+	if (!*str)
 		return 0;
-
-	const uint8_t *scan = get_u() + pos;
-	const uint8_t *compare = stru;
-
-	strl_t l = length - pos;
-	while (l) {
-		if (int_tolower_ascii7(*scan++)==c) {
-			bool equal = true;
-			const uint8_t *scan_chk = scan;
-			while (uint8_t c2 = *compare++) {
-				if (int_tolower_ascii7(*scan_chk++)!=int_tolower_ascii7(c2)) {
-					compare = stru;
-					equal = false;
-					break;
-				}
-			}
-			if (equal)
-				return int(length-l);
-		}
-		l--;
-	}
-	return -1;
+	return find(strref(str), pos);
 }
 
 // find a substring within a string case sensitive
 int strref::find_case(const strref str, strl_t pos) const
 {
-	if (!str.valid() || !valid() || length<str.length || pos>=length)
+	if (!str.valid() || !valid() || pos>=length)
 		return -1;
-
-	const char *scan = string + pos;
-	const char *compare = str.string, *compare_chk = compare;
-	strl_t left2 = str.length - pos;
-
-	strl_t left = length;
-	while (left>=left2) {
-		if (*scan++==*compare_chk) {
-			const char *scan_chk = scan;
-			compare_chk++;
-			while (--left2) {
-				if (*scan_chk++!=*compare_chk++) {
-					compare_chk = compare;
-					left2 = str.length;
-					break;
-				}
-			}
-			if (!left2)
-				return int(length-left);
-		}
-		left--;
-	}
-	return -1;
+	int o = int_find_substr(get_u() + pos, length - pos, str.get_u(), str.length, false);
+	return o<0 ? -1 : int(o + pos);
 }
 
 // find case sensitive allow escape codes (\x => x) in search string
@@ -2645,7 +4794,7 @@ int strref::find_case_esc(const strref str, strl_t pos) const
 		if (*scan++ == c) {
 			const uint8_t *chk_scan = scan;
 			const uint8_t *chk_compare = compare;
-			strl_t chk_scan_left = scan_left;
+			strl_t chk_scan_left = scan_left - 1;
 			strl_t chk_compare_left = compare_left;
 			while (chk_compare_left) {
 				uint8_t d = *chk_compare++;
@@ -2721,13 +4870,40 @@ static bool int_char_match_range_case(uint8_t c, const uint8_t *rng_chk, strl_t
 	return match;
 }
 
-// checks if character c matches range
-static bool int_char_match_range(uint8_t c, const uint8_t *rng_chk, strl_t rng_lft)
+// vector tests available for a strrange
+enum STRRANGE_TEST {
+	SRT_NIBBLE = 0x01,		// nib_lo/nib_hi lookup matches range
+	SRT_NIBBLE_NOT = 0x02,	// nib_lo/nib_hi lookup matches characters not in range
+	SRT_SPANS = 0x04,		// spans matches range
+	SRT_SPANS_NOT = 0x08,	// spans matches characters not in range
+};
+
+#ifdef STRUSE_V16_LOOKUP
+#define SRT_VECTOR (SRT_NIBBLE | SRT_NIBBLE_NOT | SRT_SPANS | SRT_SPANS_NOT)
+#else
+#define SRT_VECTOR (SRT_SPANS | SRT_SPANS_NOT)
+#endif
+
+// set bits for a range of characters
+static void int_range_set_bits(uint32_t *bits, int first, int last)
 {
-	// no match yet, check skipped character against allowed range
-	bool match = false;
+	for (int c = first; c<=last; ++c)
+		bits[c>>5] |= 1U<<(c&31);
+}
+
+// build a character range from a range string
+void strrange::set(const strref range, bool case_sensitive)
+{
+	memset(bits, 0, sizeof(bits));
+
+	// check if range is inclusive or exclusive
+	bool include;
+	strref rng = int_check_exclude(range, include);
+
+	const uint8_t *rng_chk = rng.get_u();
+	strl_t rng_lft = rng.get_len();
 	while (rng_lft) {
-		uint8_t m = (uint8_t)*rng_chk++;
+		uint8_t m = *rng_chk++;
 		rng_lft--;
 		// escape code?
 		if (m == '\\' && rng_lft) {
@@ -2735,11 +4911,12 @@ static bool int_char_match_range(uint8_t c, const uint8_t *rng_chk, strl_t rng_l
 			rng_chk += skip;
 			rng_lft -= skip;
 		}
+		uint8_t n = m;
 		// range?
 		if (rng_lft>1 && *rng_chk == '-') {
 			rng_chk++;
 			rng_lft--;
-			uint8_t n = (uint8_t)*rng_chk++;
+			n = *rng_chk++;
 			rng_lft--;
 			// escape code for range end?
 			if (n == '\\' && rng_lft) {
@@ -2747,17 +4924,429 @@ static bool int_char_match_range(uint8_t c, const uint8_t *rng_chk, strl_t rng_l
 				rng_chk += skip;
 				rng_lft -= skip;
 			}
-			if (c >= int_tolower_ascii7(m) && c <= int_tolower_ascii7(n)) {
-				match = true;
-				break;
+		}
+		if (!case_sensitive) {
+			m = int_tolower_ascii7(m);
+			n = int_tolower_ascii7(n);
+		}
+		int_range_set_bits(bits, m, n);
+	}
+
+	// case insensitive: uppercase matches if the lowercase is in range
+	if (!case_sensitive) {
+		for (uint8_t c = 'A'; c<='Z'; ++c) {
+			bits[c>>5] &= ~(1U<<(c&31));
+			if (has(uint8_t(c+'a'-'A')))
+				bits[c>>5] |= 1U<<(c&31);
+		}
+	}
+	if (!include) {
+		for (int i = 0; i<8; ++i)
+			bits[i] = ~bits[i];
+	}
+	compile();
+}
+
+// build a character range from individual characters
+void strrange::set_chars(const strref chars)
+{
+	memset(bits, 0, sizeof(bits));
+	const uint8_t *scan = chars.get_u();
+	for (strl_t left = chars.get_len(); left; --left, ++scan)
+		bits[*scan>>5] |= 1U<<(*scan&31);
+	compile();
+}
+
+void strrange::clear()
+{
+	memset(bits, 0, sizeof(bits));
+	compile();
+}
+
+void strrange::add(uint8_t first, uint8_t last)
+{
+	int_range_set_bits(bits, first, last);
+	compile();
+}
+
+void strrange::add(const strrange &range)
+{
+	for (int i = 0; i<8; ++i)
+		bits[i] |= range.bits[i];
+	compile();
+}
+
+void strrange::invert()
+{
+	for (int i = 0; i<8; ++i)
+		bits[i] = ~bits[i];
+	compile();
+}
+
+// prepare vector tests for the current set of characters
+void strrange::compile()
+{
+	flags = 0;
+	spans = 0;
+
+#ifdef STRUSE_V16
+	// characters where the range switches between in and out, even edges start a span
+	uint8_t edge[9];
+	int edges = 0;
+	uint32_t prev = 0;
+	for (int i = 0; i<8 && edges<=9; ++i) {
+		uint32_t w = bits[i];
+		for (uint32_t t = w ^ ((w<<1) | prev); t && edges<=9; t &= t-1) {
+			if (edges<9)
+				edge[edges] = (uint8_t)(i*32 + int_ctz32(t));
+			edges++;
+		}
+		prev = w>>31;
+	}
+
+	// up to 4 spans of characters in range or not in range can be tested by range compare
+	int first = -1;
+	if (edges<=8) {
+		flags = SRT_SPANS;
+		first = 0;
+	} else if (edges==9 && !edge[0]) {
+		flags = SRT_SPANS_NOT;
+		first = 1;
+	}
+	if (first>=0) {
+		int count = 0;
+		for (int k = first; k<edges; k += 2, ++count) {
+			span_first[count] = edge[k];
+			span_size[count] = (uint8_t)(((k+1)<edges ? edge[k+1] : 256) - 1 - edge[k]);
+		}
+		spans = (uint8_t)count;
+	}
+
+#endif
+
+#ifdef STRUSE_V16_LOOKUP
+	// characters from up to 8 high nibble groups can be tested by two table lookups
+	uint32_t half[16];
+	int count_in = 0, count_out = 0;
+	for (int h = 0; h<16; ++h) {
+		half[h] = (bits[h>>1]>>((h&1)*16)) & 0xffff;
+		count_in += half[h] ? 1 : 0;
+		count_out += half[h]!=0xffff ? 1 : 0;
+	}
+	if (count_in<=8 || count_out<=8) {
+		uint32_t flip = count_in<=8 ? 0 : 0xffff;
+		uint8_t lo[16] = { 0 }, hi[16] = { 0 };
+		uint8_t bit = 1;
+		for (int h = 0; h<16; ++h) {
+			uint32_t m = half[h] ^ flip;
+			if (m) {
+				hi[h] = bit;
+				for (; m; m &= m-1)
+					lo[int_ctz32(m)] |= bit;
+				bit <<= 1;
 			}
 		}
-		else if (c == int_tolower_ascii7(m)) {
-			match = true;
-			break;
+		memcpy(nib_lo, lo, sizeof(nib_lo));
+		memcpy(nib_hi, hi, sizeof(nib_hi));
+		flags |= flip ? SRT_NIBBLE_NOT : SRT_NIBBLE;
+	}
+#endif
+}
+
+#ifdef STRUSE_V16
+#ifdef STRUSE_V16_LOOKUP
+// shuffle that moves the characters of 8 with a zero bit in the index to the front
+static const uint8_t _aCompact_Shuffle[256][8] = {
+	{ 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 }, { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x80 },
+	{ 0x00, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x80 }, { 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x03, 0x04, 0x05, 0x06, 0x07, 0x80 }, { 0x01, 0x03, 0x04, 0x05, 0x06, 0x07, 0x80, 0x80 },
+	{ 0x00, 0x03, 0x04, 0x05, 0x06, 0x07, 0x80, 0x80 }, { 0x03, 0x04, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x04, 0x05, 0x06, 0x07, 0x80 }, { 0x01, 0x02, 0x04, 0x05, 0x06, 0x07, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x04, 0x05, 0x06, 0x07, 0x80, 0x80 }, { 0x02, 0x04, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x04, 0x05, 0x06, 0x07, 0x80, 0x80 }, { 0x01, 0x04, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x04, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80 }, { 0x04, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x03, 0x05, 0x06, 0x07, 0x80 }, { 0x01, 0x02, 0x03, 0x05, 0x06, 0x07, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x03, 0x05, 0x06, 0x07, 0x80, 0x80 }, { 0x02, 0x03, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x03, 0x05, 0x06, 0x07, 0x80, 0x80 }, { 0x01, 0x03, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x03, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80 }, { 0x03, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x05, 0x06, 0x07, 0x80, 0x80 }, { 0x01, 0x02, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80 }, { 0x02, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80 }, { 0x01, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80 }, { 0x05, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x03, 0x04, 0x06, 0x07, 0x80 }, { 0x01, 0x02, 0x03, 0x04, 0x06, 0x07, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x03, 0x04, 0x06, 0x07, 0x80, 0x80 }, { 0x02, 0x03, 0x04, 0x06, 0x07, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x03, 0x04, 0x06, 0x07, 0x80, 0x80 }, { 0x01, 0x03, 0x04, 0x06, 0x07, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x03, 0x04, 0x06, 0x07, 0x80, 0x80, 0x80 }, { 0x03, 0x04, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x04, 0x06, 0x07, 0x80, 0x80 }, { 0x01, 0x02, 0x04, 0x06, 0x07, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x04, 0x06, 0x07, 0x80, 0x80, 0x80 }, { 0x02, 0x04, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x04, 0x06, 0x07, 0x80, 0x80, 0x80 }, { 0x01, 0x04, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x04, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80 }, { 0x04, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x03, 0x06, 0x07, 0x80, 0x80 }, { 0x01, 0x02, 0x03, 0x06, 0x07, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x03, 0x06, 0x07, 0x80, 0x80, 0x80 }, { 0x02, 0x03, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x03, 0x06, 0x07, 0x80, 0x80, 0x80 }, { 0x01, 0x03, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x03, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80 }, { 0x03, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x06, 0x07, 0x80, 0x80, 0x80 }, { 0x01, 0x02, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80 }, { 0x02, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x07, 0x80 }, { 0x01, 0x02, 0x03, 0x04, 0x05, 0x07, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x03, 0x04, 0x05, 0x07, 0x80, 0x80 }, { 0x02, 0x03, 0x04, 0x05, 0x07, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x03, 0x04, 0x05, 0x07, 0x80, 0x80 }, { 0x01, 0x03, 0x04, 0x05, 0x07, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x03, 0x04, 0x05, 0x07, 0x80, 0x80, 0x80 }, { 0x03, 0x04, 0x05, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x04, 0x05, 0x07, 0x80, 0x80 }, { 0x01, 0x02, 0x04, 0x05, 0x07, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x04, 0x05, 0x07, 0x80, 0x80, 0x80 }, { 0x02, 0x04, 0x05, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x04, 0x05, 0x07, 0x80, 0x80, 0x80 }, { 0x01, 0x04, 0x05, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x04, 0x05, 0x07, 0x80, 0x80, 0x80, 0x80 }, { 0x04, 0x05, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x03, 0x05, 0x07, 0x80, 0x80 }, { 0x01, 0x02, 0x03, 0x05, 0x07, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x03, 0x05, 0x07, 0x80, 0x80, 0x80 }, { 0x02, 0x03, 0x05, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x03, 0x05, 0x07, 0x80, 0x80, 0x80 }, { 0x01, 0x03, 0x05, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x03, 0x05, 0x07, 0x80, 0x80, 0x80, 0x80 }, { 0x03, 0x05, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x05, 0x07, 0x80, 0x80, 0x80 }, { 0x01, 0x02, 0x05, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x05, 0x07, 0x80, 0x80, 0x80, 0x80 }, { 0x02, 0x05, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x05, 0x07, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x05, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x05, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x05, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x03, 0x04, 0x07, 0x80, 0x80 }, { 0x01, 0x02, 0x03, 0x04, 0x07, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x03, 0x04, 0x07, 0x80, 0x80, 0x80 }, { 0x02, 0x03, 0x04, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x03, 0x04, 0x07, 0x80, 0x80, 0x80 }, { 0x01, 0x03, 0x04, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x03, 0x04, 0x07, 0x80, 0x80, 0x80, 0x80 }, { 0x03, 0x04, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x04, 0x07, 0x80, 0x80, 0x80 }, { 0x01, 0x02, 0x04, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x04, 0x07, 0x80, 0x80, 0x80, 0x80 }, { 0x02, 0x04, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x04, 0x07, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x04, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x04, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x04, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x03, 0x07, 0x80, 0x80, 0x80 }, { 0x01, 0x02, 0x03, 0x07, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x03, 0x07, 0x80, 0x80, 0x80, 0x80 }, { 0x02, 0x03, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x03, 0x07, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x03, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x03, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x03, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x07, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x02, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x02, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x07, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x80 }, { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x03, 0x04, 0x05, 0x06, 0x80, 0x80 }, { 0x02, 0x03, 0x04, 0x05, 0x06, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x03, 0x04, 0x05, 0x06, 0x80, 0x80 }, { 0x01, 0x03, 0x04, 0x05, 0x06, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x03, 0x04, 0x05, 0x06, 0x80, 0x80, 0x80 }, { 0x03, 0x04, 0x05, 0x06, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x04, 0x05, 0x06, 0x80, 0x80 }, { 0x01, 0x02, 0x04, 0x05, 0x06, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x04, 0x05, 0x06, 0x80, 0x80, 0x80 }, { 0x02, 0x04, 0x05, 0x06, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x04, 0x05, 0x06, 0x80, 0x80, 0x80 }, { 0x01, 0x04, 0x05, 0x06, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x04, 0x05, 0x06, 0x80, 0x80, 0x80, 0x80 }, { 0x04, 0x05, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x03, 0x05, 0x06, 0x80, 0x80 }, { 0x01, 0x02, 0x03, 0x05, 0x06, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x03, 0x05, 0x06, 0x80, 0x80, 0x80 }, { 0x02, 0x03, 0x05, 0x06, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x03, 0x05, 0x06, 0x80, 0x80, 0x80 }, { 0x01, 0x03, 0x05, 0x06, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x03, 0x05, 0x06, 0x80, 0x80, 0x80, 0x80 }, { 0x03, 0x05, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x05, 0x06, 0x80, 0x80, 0x80 }, { 0x01, 0x02, 0x05, 0x06, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x05, 0x06, 0x80, 0x80, 0x80, 0x80 }, { 0x02, 0x05, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x05, 0x06, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x05, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x05, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x05, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x03, 0x04, 0x06, 0x80, 0x80 }, { 0x01, 0x02, 0x03, 0x04, 0x06, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x03, 0x04, 0x06, 0x80, 0x80, 0x80 }, { 0x02, 0x03, 0x04, 0x06, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x03, 0x04, 0x06, 0x80, 0x80, 0x80 }, { 0x01, 0x03, 0x04, 0x06, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x03, 0x04, 0x06, 0x80, 0x80, 0x80, 0x80 }, { 0x03, 0x04, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x04, 0x06, 0x80, 0x80, 0x80 }, { 0x01, 0x02, 0x04, 0x06, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x04, 0x06, 0x80, 0x80, 0x80, 0x80 }, { 0x02, 0x04, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x04, 0x06, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x04, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x04, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x04, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x03, 0x06, 0x80, 0x80, 0x80 }, { 0x01, 0x02, 0x03, 0x06, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x03, 0x06, 0x80, 0x80, 0x80, 0x80 }, { 0x02, 0x03, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x03, 0x06, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x03, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x03, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x03, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x06, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x02, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x02, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x06, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x06, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x80, 0x80 }, { 0x01, 0x02, 0x03, 0x04, 0x05, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x03, 0x04, 0x05, 0x80, 0x80, 0x80 }, { 0x02, 0x03, 0x04, 0x05, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x03, 0x04, 0x05, 0x80, 0x80, 0x80 }, { 0x01, 0x03, 0x04, 0x05, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x03, 0x04, 0x05, 0x80, 0x80, 0x80, 0x80 }, { 0x03, 0x04, 0x05, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x04, 0x05, 0x80, 0x80, 0x80 }, { 0x01, 0x02, 0x04, 0x05, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x04, 0x05, 0x80, 0x80, 0x80, 0x80 }, { 0x02, 0x04, 0x05, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x04, 0x05, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x04, 0x05, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x04, 0x05, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x04, 0x05, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x03, 0x05, 0x80, 0x80, 0x80 }, { 0x01, 0x02, 0x03, 0x05, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x03, 0x05, 0x80, 0x80, 0x80, 0x80 }, { 0x02, 0x03, 0x05, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x03, 0x05, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x03, 0x05, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x03, 0x05, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x03, 0x05, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x05, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x02, 0x05, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x05, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x02, 0x05, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x05, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x05, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x05, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x05, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x03, 0x04, 0x80, 0x80, 0x80 }, { 0x01, 0x02, 0x03, 0x04, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x03, 0x04, 0x80, 0x80, 0x80, 0x80 }, { 0x02, 0x03, 0x04, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x03, 0x04, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x03, 0x04, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x03, 0x04, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x03, 0x04, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x04, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x02, 0x04, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x04, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x02, 0x04, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x04, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x04, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x04, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x04, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x03, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x02, 0x03, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x03, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x02, 0x03, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x03, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x03, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x03, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x03, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x02, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x02, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x02, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x02, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x01, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x01, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0x00, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }
+};
+#endif
+
+// write the characters of v that do not have a bit set in drop to w, returns the number
+// written. Up to 16 characters are stored so w must have room up to where v was read from
+static inline strl_t int_v16_compact(uint8_t *w, int_v16 v, uint32_t drop)
+{
+	if (!drop) {
+		int_v16_store(w, v);
+		return 16;
+	}
+#ifdef STRUSE_V16_LOOKUP
+	// the second half reads from 8 characters further in
+	uint8_t idx[16], out[16];
+	uint64_t hi;
+	memcpy(idx, _aCompact_Shuffle[drop & 0xff], 8);
+	memcpy(&hi, _aCompact_Shuffle[(drop>>8) & 0xff], 8);
+	hi += 0x0808080808080808ULL;
+	memcpy(idx + 8, &hi, 8);
+	int_v16_store(out, int_v16_lookup(v, int_v16_load(idx)));
+	strl_t lo = strl_t(8 - int_popcount32(drop & 0xff));
+	memcpy(w, out, 8);
+	memcpy(w + lo, out + 8, 8);
+	return lo + strl_t(8 - int_popcount32((drop>>8) & 0xff));
+#else
+	// one character at a time without a branch on the dropped characters
+	uint8_t b[16];
+	int_v16_store(b, v);
+	strl_t n = 0;
+	for (int i = 0; i<16; ++i) {
+		w[n] = b[i];
+		n += ((drop>>i) & 1) ^ 1;
+	}
+	return n;
+#endif
+}
+#endif
+
+// offset to first character that is (match) or isn't (!match) in range, or len if none
+strl_t strrange::scan(const uint8_t *s, strl_t len, bool match) const
+{
+	strl_t o = 0;
+#ifdef STRUSE_V16
+	if (len>=16 && (flags & SRT_VECTOR)) {
+		// the last block overlaps already checked characters
+		strl_t last = len - 16;
+#ifdef STRUSE_V16_LOOKUP
+		if (flags & (SRT_NIBBLE | SRT_NIBBLE_NOT)) {
+			// zero lookup result means the nibble tables do not match
+			uint32_t flip = ((flags & SRT_NIBBLE)!=0)==match ? 0xffff : 0;
+			int_v16 lo = int_v16_load(nib_lo), hi = int_v16_load(nib_hi), zero = int_v16_set1(0);
+			for (;;) {
+				int_v16 v = int_v16_load(s + o);
+				int_v16 t = int_v16_and(int_v16_lookup(lo, int_v16_lo_nibble(v)), int_v16_lookup(hi, int_v16_hi_nibble(v)));
+				if (uint32_t m = int_v16_mask(int_v16_eq(t, zero)) ^ flip)
+					return o + (strl_t)int_ctz32(m);
+				if (o==last)
+					return len;
+				o = (o+16)<last ? (o+16) : last;
+			}
+		}
+#endif
+		uint32_t flip = ((flags & SRT_SPANS)!=0)==match ? 0 : 0xffff;
+		int_v16 first[4], size[4];
+		for (int i = 0; i<spans; ++i) {
+			first[i] = int_v16_set1(span_first[i]);
+			size[i] = int_v16_set1(span_size[i]);
+		}
+		for (;;) {
+			int_v16 v = int_v16_load(s + o);
+			int_v16 in = int_v16_set1(0);
+			for (int i = 0; i<spans; ++i) {
+				int_v16 x = int_v16_sub(v, first[i]);
+				in = int_v16_or(in, int_v16_eq(int_v16_min(x, size[i]), x));
+			}
+			if (uint32_t m = int_v16_mask(in) ^ flip)
+				return o + (strl_t)int_ctz32(m);
+			if (o==last)
+				return len;
+			o = (o+16)<last ? (o+16) : last;
 		}
 	}
-	return match;
+#endif
+	for (; o<len; ++o) {
+		if (has(s[o])==match)
+			return o;
+	}
+	return len;
+}
+
+// remove characters that are (match) or aren't (!match) in range, returns the new length
+strl_t strrange::remove(uint8_t *s, strl_t len, bool match) const
+{
+	strl_t o = scan(s, len, match);
+	if (o>=len)
+		return len;
+	uint8_t *w = s + o;
+	const uint8_t *r = w, *e = s + len;
+#ifdef STRUSE_V16
+	if (flags & SRT_VECTOR) {
+#ifdef STRUSE_V16_LOOKUP
+		if (flags & (SRT_NIBBLE | SRT_NIBBLE_NOT)) {
+			// zero lookup result means the nibble tables do not match
+			uint32_t flip = ((flags & SRT_NIBBLE)!=0)==match ? 0xffff : 0;
+			int_v16 lo = int_v16_load(nib_lo), hi = int_v16_load(nib_hi), zero = int_v16_set1(0);
+			for (; (e - r)>=16; r += 16) {
+				int_v16 v = int_v16_load(r);
+				int_v16 t = int_v16_and(int_v16_lookup(lo, int_v16_lo_nibble(v)), int_v16_lookup(hi, int_v16_hi_nibble(v)));
+				w += int_v16_compact(w, v, int_v16_mask(int_v16_eq(t, zero)) ^ flip);
+			}
+		} else
+#endif
+		{
+			uint32_t flip = ((flags & SRT_SPANS)!=0)==match ? 0 : 0xffff;
+			int_v16 first[4], size[4];
+			for (int i = 0; i<spans; ++i) {
+				first[i] = int_v16_set1(span_first[i]);
+				size[i] = int_v16_set1(span_size[i]);
+			}
+			for (; (e - r)>=16; r += 16) {
+				int_v16 v = int_v16_load(r);
+				int_v16 in = int_v16_set1(0);
+				for (int i = 0; i<spans; ++i) {
+					int_v16 x = int_v16_sub(v, first[i]);
+					in = int_v16_or(in, int_v16_eq(int_v16_min(x, size[i]), x));
+				}
+				w += int_v16_compact(w, v, int_v16_mask(in) ^ flip);
+			}
+		}
+	}
+#endif
+	for (; r<e; ++r) {
+		*w = *r;
+		w += has(*r)!=match;
+	}
+	return strl_t(w - s);
+}
+
+// find first character in range at pos or after
+int strrange::find(const strref str, strl_t pos) const
+{
+	if (pos>=str.get_len())
+		return -1;
+	strl_t o = scan(str.get_u() + pos, str.get_len() - pos, true);
+	return (pos + o)<str.get_len() ? int(pos + o) : -1;
+}
+
+// find first character not in range at pos or after
+int strrange::find_not(const strref str, strl_t pos) const
+{
+	if (pos>=str.get_len())
+		return -1;
+	strl_t o = scan(str.get_u() + pos, str.get_len() - pos, false);
+	return (pos + o)<str.get_len() ? int(pos + o) : -1;
+}
+
+// number of characters in range from pos
+strl_t strrange::len(const strref str, strl_t pos) const
+{
+	if (pos>=str.get_len())
+		return 0;
+	return scan(str.get_u() + pos, str.get_len() - pos, false);
 }
 
 // find case sensitive allow escape codes (\x => x) in search string
@@ -2766,6 +5355,14 @@ int strref::find_case_esc_range(const strref str, const strref range, strl_t pos
 	if (!str.valid() || !valid() || pos>=get_len() || !range.get_len())
 		return -1;
 
+	return find_case_esc_range(str, strrange(range), pos);
+}
+
+int strref::find_case_esc_range(const strref str, const strrange &allowed, strl_t pos) const
+{
+	if (!str.valid() || !valid() || pos>=get_len())
+		return -1;
+
 	// start scan buffer pointers
 	const uint8_t *scan = get_u() + pos;
 	const uint8_t *compare = str.get_u();
@@ -2783,10 +5380,6 @@ int strref::find_case_esc_range(const strref str, const strref range, strl_t pos
 		compare_left -= skip;
 	}
 
-	// check if range is inclusive or exclusive
-	bool include;
-	strref rng = int_check_exclude(range, include);
-
 	// sweep the scan buffer for the matching string
 	while (scan_left) {
 		uint8_t b = (uint8_t)*scan++;
@@ -2794,31 +5387,28 @@ int strref::find_case_esc_range(const strref str, const strref range, strl_t pos
 		if (b == c) {
 			const uint8_t *chk_scan = scan;
 			const uint8_t *chk_compare = compare;
-			strl_t chk_scan_left = scan_left;
+			strl_t chk_scan_left = scan_left - 1;
 			strl_t chk_compare_left = compare_left;
 			while (chk_compare_left) {
 				uint8_t d = *chk_compare++;
 				chk_compare_left--;
-				uint8_t e = *chk_scan++;
-				chk_scan_left--;
-				if (d=='\\' && compare_left) {
-					strl_t skip = int_get_esc_code(compare, compare_left, d);
-					compare += skip;
-					compare_left -= skip;
+				if (d=='\\' && chk_compare_left) {
+					strl_t skip = int_get_esc_code(chk_compare, chk_compare_left, d);
+					chk_compare += skip;
+					chk_compare_left -= skip;
 				}
-				if (e!=d) {
+				if (!chk_scan_left || *chk_scan++!=d) {
 					chk_compare_left = 1;
 					break;
 				}
+				chk_scan_left--;
 			}
 			if (!chk_compare_left)
 				return int(length - scan_left);
 		}
 
-		// no match yet, check character against range
-		// check if character is allowed
-		bool match = int_char_match_range_case(b, rng.get_u(), rng.get_len());
-		if ((match && !include) || (!match && include))
+		// no match yet, check if character is allowed
+		if (!allowed.has(b))
 			return -1;
 
 		scan_left--;
@@ -2832,6 +5422,14 @@ int strref::find_esc_range(const strref str, const strref range, strl_t pos) con
 	if (!str.valid() || !valid() || pos>=get_len() || !range.get_len())
 		return -1;
 
+	return find_esc_range(str, strrange(range, false), pos);
+}
+
+int strref::find_esc_range(const strref str, const strrange &allowed, strl_t pos) const
+{
+	if (!str.valid() || !valid() || pos>=get_len())
+		return -1;
+
 	// start scan buffer pointers
 	const uint8_t *scan = get_u() + pos;
 	const uint8_t *compare = str.get_u();
@@ -2848,10 +5446,7 @@ int strref::find_esc_range(const strref str, const strref range, strl_t pos) con
 		compare += skip;
 		compare_left -= skip;
 	}
-
-	// check if range is inclusive or exclusive
-	bool include;
-	strref rng = int_check_exclude(range, include);
+	c = int_tolower_ascii7(c);
 
 	// sweep the scan buffer for the matching string
 	while (scan_left) {
@@ -2860,32 +5455,28 @@ int strref::find_esc_range(const strref str, const strref range, strl_t pos) con
 		if (b == c) {
 			const uint8_t *chk_scan = scan;
 			const uint8_t *chk_compare = compare;
-			strl_t chk_scan_left = scan_left;
+			strl_t chk_scan_left = scan_left - 1;
 			strl_t chk_compare_left = compare_left;
 			while (chk_compare_left) {
-				uint8_t d = int_tolower_ascii7(*chk_compare++);
+				uint8_t d = *chk_compare++;
 				chk_compare_left--;
-				uint8_t e = int_tolower_ascii7(*chk_scan++);
-				chk_scan_left--;
-				if (d=='\\' && compare_left) {
-					strl_t skip = int_get_esc_code(compare, compare_left, d);
-					compare += skip;
-					compare_left -= skip;
+				if (d=='\\' && chk_compare_left) {
+					strl_t skip = int_get_esc_code(chk_compare, chk_compare_left, d);
+					chk_compare += skip;
+					chk_compare_left -= skip;
 				}
-				if (e!=d) {
+				if (!chk_scan_left || int_tolower_ascii7(*chk_scan++)!=int_tolower_ascii7(d)) {
 					chk_compare_left = 1;
 					break;
 				}
+				chk_scan_left--;
 			}
 			if (!chk_compare_left)
 				return int(length - scan_left);
 		}
 
-		// no match yet, check character against range
-		bool match = int_char_match_range(b, rng.get_u(), rng.get_len());
-
-		// check if character is allowed
-		if ((match && !include) || (!match && include))
+		// no match yet, check if character is allowed
+		if (!allowed.has(b))
 			return -1;
 
 		scan_left--;
@@ -2898,63 +5489,17 @@ int strref::find_case(const char *str) const
 {
 	if (!str || !valid())
 		return -1;
-
-	char c = *str++;
-	if (!c)
+	if (!*str)
 		return 0;
-
-	const char *scan = string;
-	const char *compare = str;
-
-	strl_t left = length;
-	while (left) {
-		if (*scan++==c) {
-			bool equal = true;
-			const char *pb = scan;
-			while (char c2 = *compare++) {
-				if (*pb++!=c2) {
-					compare = str;
-					equal = false;
-					break;
-				}
-			}
-			if (equal)
-				return int(length-left);
-		}
-		left--;
-	}
-	return -1;
+	return int_find_substr(get_u(), length, (const uint8_t*)str, (strl_t)strlen(str), false);
 }
 
 // find last matching substring within a string case ignored
 int strref::find_last(const strref str) const
 {
-	if (!str.valid() || !valid() || length<str.length)
+	if (!str.valid() || !valid())
 		return -1;
-
-	const uint8_t *scan = get_u() + length;
-	const uint8_t *compare = str.get_u() + str.length;
-
-	uint8_t c = int_tolower_ascii7(*--compare);
-
-	int left = (int)length;
-	while (left>0) {
-		left--;
-		if (int_tolower_ascii7(*--scan)==c) {
-			const uint8_t *scan_chk = scan;
-			const uint8_t *cmp_chk = compare;
-			strl_t left_check = str.length;
-			while (--left_check) {
-				if (int_tolower_ascii7(*--scan_chk)!=int_tolower_ascii7(*--cmp_chk)) {
-					left_check = 1;
-					break;
-				}
-			}
-			if (!left_check)
-				return left-(int)str.length+1;
-		}
-	}
-	return -1;
+	return int_find_last_substr(get_u(), length, str.get_u(), str.length, true);
 }
 
 // find last matching substring within a string case ignored
@@ -2963,6 +5508,8 @@ int strref::find_last_bookend(const strref str, const strref bookend) const
 	if (!str.valid() || !valid() || length<str.length)
 		return -1;
 
+	strrange book(bookend);
+
 	const uint8_t *scan = get_u() + length;
 	const uint8_t *compare = str.get_u() + str.length;
 
@@ -2972,7 +5519,7 @@ int strref::find_last_bookend(const strref str, const strref bookend) const
 	while (left>0) {
 		left--;
 		uint8_t d = int_tolower_ascii7(*--scan);
-		if (d == c && (left==length || bookend.char_matches_ranges(p))) {
+		if (d == c && (left==length || book.has(p))) {
 			const uint8_t *scan_chk = scan;
 			const uint8_t *cmp_chk = compare;
 			strl_t left_check = str.length;
@@ -2983,7 +5530,7 @@ int strref::find_last_bookend(const strref str, const strref bookend) const
 				}
 			}
 			if (!left_check) {
-				if (get_u() == scan_chk || bookend.char_matches_ranges(int_tolower_ascii7(*--scan_chk)))
+				if (get_u() == scan_chk || book.has(int_tolower_ascii7(*--scan_chk)))
 					return int(left - str.length + 1);
 			}
 		}
@@ -2997,87 +5544,38 @@ int strref::find_last(const char *str) const
 {
 	if (!str || !*str || !valid())
 		return -1;
-
-	const uint8_t *scan = get_u()+length;
-	const uint8_t *compare = (const uint8_t*)str + strlen(str);
-	uint8_t c = int_tolower_ascii7(*--compare);
-	int l = (int)length;
-	while (l>=0) {
-		l--;
-		if (int_tolower_ascii7(*--scan)==c) {
-			const uint8_t *scan_chk = scan;
-			const uint8_t *cmp_chk = compare;
-			while (cmp_chk>(const uint8_t*)str) {
-				if (int_tolower_ascii7(*--scan_chk)!=int_tolower_ascii7(*--cmp_chk)) {
-					cmp_chk = compare;
-					break;
-				}
-			}
-			if (cmp_chk==(const uint8_t*)str)
-				return int(scan_chk-(const uint8_t*)string);
-		}
-	}
-	return -1;
+	return int_find_last_substr(get_u(), length, (const uint8_t*)str, (strl_t)strlen(str), true);
 }
 
 // find last matching substring within a string case sensitive
 int strref::find_last_case(const strref str) const
 {
-	if (!str.valid() || !valid() || length<str.length)
+	if (!str.valid() || !valid())
 		return -1;
-
-	const char *scan = string+length-str.length;
-	const char *compare = str.string+str.length-1,
-		*compare_chk = compare;
-	strl_t left_chk = str.length;
-
-	int left = int(length-left_chk);
-	while (left>=0) {
-		if (*--scan==*compare_chk) {
-			const char *scan_chk = scan;
-			while (--left_chk) {
-				if (*--scan_chk!=*--compare_chk) {
-					compare_chk = compare;
-					left_chk = str.length;
-					break;
-				}
-			}
-			if (!left_chk)
-				return int(length-left);
-		}
-		left--;
-	}
-	return -1;
+	return int_find_last_substr(get_u(), length, str.get_u(), str.length, false);
 }
 
 // count number of matching substrings in string
 int strref::substr_count(const strref str) const
 {
-	if (!str.valid() || !valid() || length<str.length)
+	if (!str.valid() || !valid())
 		return 0;
 
-	int count = 0;
-	const uint8_t *scan = get_u();
-	strl_t left = length;
-	strl_t substrlen = str.length;
-	uint8_t c = int_tolower_ascii7((uint8_t)str.get_first());
-
-	while (left>=substrlen) {
-		while (left && int_tolower_ascii7(*scan++)!=c)
-			left--;
-		if (left && left>=substrlen) {
-			// first character matches and enough characters remain for a potential match
-			const uint8_t *compare = str.get_u()+1;
-			strl_t sr = substrlen-1;
-			const uint8_t *scan_chk = scan;
-			while (sr && int_tolower_ascii7(*compare++)==int_tolower_ascii7(*scan_chk++))
-				sr--;
-			if (sr==0) {
-				scan = scan_chk;
-				left -= substrlen-1;
-				count++;
-			}
-		}
+	int count = 0;
+	if (str.length==1) {
+		uint8_t fm = int_fold_bit(str.get_u()[0]), f = str.get_u()[0] | fm;
+		const uint8_t *scan = get_u();
+		for (strl_t o = 0; o<length; ++o)
+			count += (scan[o] | fm)==f;
+		return count;
+	}
+	strl_t pos = 0;
+	while (pos<length) {
+		int o = int_find_substr(get_u() + pos, length - pos, str.get_u(), str.length, true);
+		if (o<0)
+			break;
+		pos += (strl_t)o + str.length;
+		count++;
 	}
 	return count;
 }
@@ -3088,6 +5586,8 @@ int strref::substr_count_bookend(const strref str, const strref bookend) const
 	if (!str.valid() || !valid() || length<str.length)
 		return 0;
 
+	strrange book(bookend);
+
 	int count = 0;
 	const uint8_t *scan = get_u();
 	strl_t left = length;
@@ -3099,7 +5599,7 @@ int strref::substr_count_bookend(const strref str, const strref bookend) const
 
 		while (left) {
 			uint8_t d = int_tolower_ascii7(*scan++);
-			if (d == c && bookend.char_matches_ranges(p))
+			if (d == c && book.has(p))
 				break;
 			p = d;
 			left--;
@@ -3111,7 +5611,7 @@ int strref::substr_count_bookend(const strref str, const strref bookend) const
 			const uint8_t *scan_chk = scan;
 			while (sr && int_tolower_ascii7(*compare++) == int_tolower_ascii7(*scan_chk++))
 				sr--;
-			if (sr == 0 && (scan_chk == (get_u() + length) || bookend.char_matches_ranges(int_tolower_ascii7(*scan_chk++)))) {
+			if (sr == 0 && (scan_chk == (get_u() + length) || book.has(int_tolower_ascii7(*scan_chk++)))) {
 				scan = scan_chk;
 				left -= substrlen - 1;
 				count++;
@@ -3286,24 +5786,28 @@ int strref::find_any_char_of(const strref range, strl_t pos) const {
 	if (pos>=length)
 		return -1;
 
-	const char *scan = get() + pos;
-	strl_t left = length-pos;
-
-	const char *rng = range.get();
-	strl_t count = range.get_len();
-
-	while (left) {
-		char c = *scan++;
-		const char *rng_chk = rng;
-		for (strl_t n = count; n; --n) {
-			if (c == *rng_chk++)
-				return int(length-left);
+	int o;
+	switch (range.get_len()) {
+		case 0:
+			return -1;
+		case 1:
+			o = int_find_char(range.get_first(), string + pos, length - pos);
+			break;
+		case 2:
+			o = int_find_char2(range.get_first(), range.get_last(), string + pos, length - pos);
+			break;
+		default: {
+			strrange chars;
+			chars.set_chars(range);
+			return chars.find(*this, pos);
 		}
-		left--;
 	}
-	return -1;
+	return o<0 ? -1 : int(o + pos);
 }
 
+// strings shorter than this are checked without compiling a strrange
+#define STRRANGE_MIN_COMPILE 16
+
 static int int_find_range(const char *scan, strl_t left, strl_t length, strref rng, bool include)
 {
 	while (left) {
@@ -3322,10 +5826,16 @@ int strref::find_any_char_or_range(const strref range, strl_t pos) const {
 	if (pos>=length)
 		return -1;
 
-	bool include;
-	strref rng = int_check_exclude(range, include);
+	if ((length-pos)<STRRANGE_MIN_COMPILE) {
+		bool include;
+		strref rng = int_check_exclude(range, include);
+		return int_find_range(string+pos, length-pos, length, rng, include);
+	}
+	return strrange(range).find(*this, pos);
+}
 
-	return int_find_range(string+pos, length-pos, length, rng, include);
+int strref::find_any_char_or_range(const strrange &range, strl_t pos) const {
+	return range.find(*this, pos);
 }
 
 // find a word made out of characters in the given range
@@ -3334,23 +5844,36 @@ strref strref::get_range_word(const strref range, strl_t pos) const
 	if (pos >= length)
 		return strref();
 
-	bool include;
-	strref rng = int_check_exclude(range, include);
+	if ((length-pos)<STRRANGE_MIN_COMPILE) {
+		bool include;
+		strref rng = int_check_exclude(range, include);
+		return get_substr(0, (strl_t)int_find_range(string + pos, length - pos, length, rng, !include));
+	}
+	return get_range_word(strrange(range), pos);
+}
+
+strref strref::get_range_word(const strrange &range, strl_t pos) const
+{
+	if (pos >= length)
+		return strref();
 
-	return get_substr(0, (strl_t)int_find_range(string + pos, length - pos, length, rng, !include));
+	return get_substr(0, (strl_t)range.find_not(*this, pos));
 }
 
 int strref::find_any_not_in_range(const strref range, strl_t pos) const {
 	if (pos>=length)
 		return -1;
-	
-	if (pos>=length)
-		return -1;
-	
-	bool include;
-	strref rng = int_check_exclude(range, include);
-	
-	return int_find_range(string+pos, length-pos, length, rng, !include);
+
+	if ((length-pos)<STRRANGE_MIN_COMPILE) {
+		bool include;
+		strref rng = int_check_exclude(range, include);
+		return int_find_range(string+pos, length-pos, length, rng, !include);
+	}
+	return strrange(range).find_not(*this, pos);
+}
+
+int strref::find_any_not_in_range(const strrange &range, strl_t pos) const {
+	return range.find_not(*this, pos);
 }
 
 // search of a character in a given range while also checking that
@@ -3359,31 +5882,17 @@ int strref::find_range_char_within_range(const strref range_find, const strref r
 	if (pos>=length)
 		return -1;
 
-	const char *scan = get() + pos;
-	strl_t l = length-pos;
-
-	// check if range is inclusive or exclusive
-	bool include_find;
-	strref rng_f = int_check_exclude(range_find, include_find);
-
-	bool include_within;
-	strref rng_w = int_check_exclude(range_within, include_within);
-
-	while (l) {
-		uint8_t c = (uint8_t)*scan++;
-		bool match_find = int_char_match_range_case(c, rng_f.get_u(), rng_f.get_len());
-		if ((match_find && include_find) || (!match_find && !include_find))
-			return int(length - l);
+	return find_range_char_within_range(strrange(range_find), strrange(range_within), pos);
+}
 
-		// no match yet, check skipped character against allowed range
-		bool match = int_char_match_range_case(c, rng_w.get_u(), rng_w.get_len());
+int strref::find_range_char_within_range(const strrange &range_find, const strrange &range_within, strl_t pos) const {
+	if (pos>=length)
+		return -1;
 
-		// check if character is allowed
-		if ((match && !include_within) || (!match && include_within))
-			return -1;
-		l--;
-	}
-	return -1;
+	// search up to and including the first character not within range
+	int w = range_within.find_not(*this, pos);
+	strl_t end = w<0 ? length : strl_t(w + 1);
+	return range_find.find(strref(string, end), pos);
 }
 
 // check if character matches a given range (this)
@@ -3399,31 +5908,15 @@ bool strref::char_matches_ranges(uint8_t c) const {
 // as it is terminated by a given character or empty
 strl_t strref::match_chars_str(const strref match, const strref term)
 {
-	bool include_match, include_term;
-	strref rng = int_check_exclude(match, include_match);
-	strref trm = int_check_exclude(term, include_term);
-	strl_t ret = 0;
-	const uint8_t *str = get_u();
-	strl_t left = length;
-	while (left) {
-		uint8_t c = *str++;
-		if (include_match == int_char_match_range_case(c, rng.get_u(), rng.get_len())) {
-			ret++;
-		} else if (!term || include_term == int_char_match_range_case(c, trm.get_u(), trm.get_len())) {
-			return ret;
-		} else
-			return 0;
-		left--;
-	}
+	strl_t ret = strrange(match).len(*this);
+	if (ret<length && term && !strrange(term).has(string[ret]))
+		return 0;
 	return ret;
 }
 
 
 // wildcard search
 
-#define MAX_WILDCARD_SEGMENTS 64
-#define MAX_WILDCARD_STEPS 48
-#define MAX_WILDCARD_SEARCH_STACK 32
 enum WILDCARD_SEGMENT_TYPE {
 	WCST_END,
 	WCST_FIND_SUBSTR,
@@ -3505,6 +5998,14 @@ static int _build_wildcard_steps(const strref wild, strref *segs, char *type, in
 			range.clear();
 			break;
 		}
+		// a control character after an odd number of backslashes is part of the substring
+		int esc = next_pos;
+		while (esc > last && wild.get_at(strl_t(esc-1))=='\\')
+			esc--;
+		if ((next_pos - esc) & 1) {
+			pos = next_pos+1;
+			continue;
+		}
 		switch (wild.get_at((strl_t)next_pos)) {
 			case '*':	// * => any substring with optional filter
 				if (next_pos > last) {
@@ -3587,6 +6088,8 @@ static int _build_wildcard_steps(const strref wild, strref *segs, char *type, in
 					search = false;
 					range.clear();
 				}
+				if (search && range)
+					segs[numSeg++] = range;
 				type[numType++] = (char)(search ? (range ? WCST_FIND_LINE_START_RANGED : WCST_FIND_LINE_START) : WCST_NEXT_LINE_START);
 				search = false;
 				range.clear();
@@ -3611,21 +6114,18 @@ static int _build_wildcard_steps(const strref wild, strref *segs, char *type, in
 				break;
 
 			case '?':	// ? = any character
-				// any character is redundant if currently searching
-				if (!search) {
-					if (next_pos > last) {
-						segs[numSeg++] = wild.get_substr(last, next_pos-last);
-						if (search && range)
-							segs[numSeg++] = range;
-						type[numType++] = (char)(search ? (range ? WCST_FIND_SUBSTR_RANGE : WCST_FIND_SUBSTR) : WCST_NEXT_SUBSTR);
-					}
-					range.clear();
-					type[numType++] = (char)WCST_NEXT_ANY_CHAR;
+				if (next_pos > last) {
+					segs[numSeg++] = wild.get_substr(last, next_pos-last);
+					if (search && range)
+						segs[numSeg++] = range;
+					type[numType++] = (char)(search ? (range ? WCST_FIND_SUBSTR_RANGE : WCST_FIND_SUBSTR) : WCST_NEXT_SUBSTR);
 					search = false;
 					range.clear();
-					pos = last = next_pos+1;
-				} else
-					last = ++pos;
+				}
+				// any character is redundant if currently searching
+				if (!search)
+					type[numType++] = (char)WCST_NEXT_ANY_CHAR;
+				pos = last = next_pos+1;
 				break;
 
 			case '#':	// # = any number (hard coded range)
@@ -3672,13 +6172,321 @@ static int _build_wildcard_steps(const strref wild, strref *segs, char *type, in
 // search for a substring with wildcard rules
 strref strref::find_wildcard(const strref wild, strl_t start, bool case_sensitive) const
 {
-	// collection of sub segments from wildcard
-	strref segs[MAX_WILDCARD_SEGMENTS];
-	char type[MAX_WILDCARD_STEPS];
+	return strwild(wild, case_sensitive).find(*this, start);
+}
+
+strref strref::find_wildcard(const strwild &wild, strl_t start) const
+{
+	return wild.find(*this, start);
+}
+
+// compile a range string for wildcard steps, reusing an identical range if possible
+static int int_wildcard_range(strrange *ranges, strref *sources, bool *cases, int &count, const strref range, bool case_sensitive)
+{
+	for (int i = 0; i<count; ++i) {
+		if (cases[i]==case_sensitive && sources[i].get()==range.get() && sources[i].get_len()==range.get_len())
+			return i;
+	}
+	if (count>=MAX_WILDCARD_RANGES)
+		return -1;
+	ranges[count].set(range, case_sensitive);
+	sources[count] = range;
+	cases[count] = case_sensitive;
+	return count++;
+}
+
+// split a wildcard into steps and compile the ranges used by the steps
+void strwild::set(const strref pattern, bool case_sens, STRWILD_ENGINE eng)
+{
+	case_sensitive = case_sens;
+	engine = SWE_BACKTRACK;
 	int numSeg = 0;
+	steps = _build_wildcard_steps(pattern, segs, type, numSeg);
+
+	strref sources[MAX_WILDCARD_RANGES];
+	bool cases[MAX_WILDCARD_RANGES];
+	int count = 0, seg = 0;
+	for (int step = 0; step<steps; ++step) {
+		int r = 0, w = 0;
+		switch (type[step]) {
+			case WCST_FIND_SUBSTR:
+			case WCST_NEXT_SUBSTR:
+				seg++;
+				break;
+
+			case WCST_FIND_SUBSTR_RANGE:
+				// range is compared with lowercase characters if not case sensitive
+				r = int_wildcard_range(ranges, sources, cases, count, segs[seg + 1], case_sensitive);
+				seg += 2;
+				break;
+
+			case WCST_FIND_RANGE_CHAR_RANGED:
+				// range to find followed by range within
+				r = int_wildcard_range(ranges, sources, cases, count, segs[seg], true);
+				w = int_wildcard_range(ranges, sources, cases, count, segs[seg + 1], true);
+				seg += 2;
+				break;
+
+			case WCST_SUBSTR_MATCH_RANGE:
+			case WCST_FIND_RANGE_CHAR:
+			case WCST_NEXT_RANGE_CHAR:
+			case WCST_FIND_WORD_START_RANGED:
+			case WCST_FIND_WORD_END_RANGED:
+			case WCST_FIND_LINE_START_RANGED:
+			case WCST_FIND_LINE_END_RANGED:
+				r = int_wildcard_range(ranges, sources, cases, count, segs[seg++], true);
+				break;
+		}
+		if (r<0 || w<0) {
+			steps = 0;	// too many ranges
+			break;
+		}
+		step_range[step] = (uint8_t)r;
+		step_within[step] = (uint8_t)w;
+	}
+
+	if (eng==SWE_AUTOMATON && steps && build_automaton())
+		engine = SWE_AUTOMATON;
+}
+
+// automaton pattern states
+enum WILDCARD_STATE_TYPE {
+	WCSS_CHAR,			// one character
+	WCSS_REPEAT,		// zero or more characters
+};
+
+// characters accepted by an automaton state
+enum WILDCARD_STATE_TEST {
+	WCSS_ANY,			// any character
+	WCSS_CHARS,			// one of two characters
+	WCSS_RANGE,			// compiled range
+};
+
+struct strwild_state {
+	uint8_t type;		// WILDCARD_STATE_TYPE
+	uint8_t test;		// WILDCARD_STATE_TEST
+	uint8_t a, b;		// characters or range index
+};
+
+static bool int_wild_state(strwild_state *st, int &n, uint8_t type, uint8_t test = WCSS_ANY, uint8_t a = 0, uint8_t b = 0)
+{
+	if (n>=MAX_WILDCARD_STATES)
+		return false;
+	st[n].type = type;
+	st[n].test = test;
+	st[n].a = a;
+	st[n].b = b;
+	n++;
+	return true;
+}
+
+// one state per character of a substring
+static bool int_wild_substr(strwild_state *st, int &n, const strref seg, bool case_sensitive)
+{
+	const uint8_t *scan = seg.get_u();
+	strl_t left = seg.get_len();
+	while (left) {
+		uint8_t c = *scan++;
+		left--;
+		if (c=='\\' && left) {
+			strl_t skip = int_get_esc_code(scan, left, c);
+			scan += skip;
+			left -= skip;
+		}
+		uint8_t a = case_sensitive ? c : int_tolower_ascii7(c);
+		uint8_t b = case_sensitive ? c : int_toupper_ascii7(c);
+		if (!int_wild_state(st, n, WCSS_CHAR, WCSS_CHARS, a, b))
+			return false;
+	}
+	return true;
+}
+
+// convert the search steps to a sequence of states, fails if there are too many states
+bool strwild::build_automaton()
+{
+	strwild_state st[MAX_WILDCARD_STATES];
+	int n = 0, seg = 0;
+	bool ok = true;
+	tail = -1;
+	for (int step = 0; ok && type[step]!=WCST_END; ++step) {
+		uint8_t r = step_range[step];
+		// the first search is covered by starting at any position
+		bool search = step > 0;
+		switch (type[step]) {
+			case WCST_FIND_SUBSTR:
+				ok = (!search || int_wild_state(st, n, WCSS_REPEAT)) && int_wild_substr(st, n, segs[seg++], case_sensitive);
+				break;
+			case WCST_FIND_SUBSTR_RANGE:
+				ok = (!search || int_wild_state(st, n, WCSS_REPEAT, WCSS_RANGE, r)) && int_wild_substr(st, n, segs[seg], case_sensitive);
+				seg += 2;
+				break;
+			case WCST_NEXT_SUBSTR:
+				ok = int_wild_substr(st, n, segs[seg++], case_sensitive);
+				break;
+			case WCST_SUBSTR_MATCH_RANGE:
+				// one or more characters, the last state of the pattern is extended after a match
+				ok = int_wild_state(st, n, WCSS_CHAR, WCSS_RANGE, r);
+				if (type[step+1]==WCST_END)
+					tail = r;
+				else
+					ok = ok && int_wild_state(st, n, WCSS_REPEAT, WCSS_RANGE, r);
+				seg++;
+				break;
+			case WCST_FIND_RANGE_CHAR:
+				ok = (!search || int_wild_state(st, n, WCSS_REPEAT)) && int_wild_state(st, n, WCSS_CHAR, WCSS_RANGE, r);
+				seg++;
+				break;
+			case WCST_FIND_RANGE_CHAR_RANGED:
+				ok = (!search || int_wild_state(st, n, WCSS_REPEAT, WCSS_RANGE, step_within[step])) &&
+					int_wild_state(st, n, WCSS_CHAR, WCSS_RANGE, r);
+				seg += 2;
+				break;
+			case WCST_NEXT_ANY_CHAR:
+				ok = int_wild_state(st, n, WCSS_CHAR);
+				break;
+			case WCST_NEXT_RANGE_CHAR:
+				ok = int_wild_state(st, n, WCSS_CHAR, WCSS_RANGE, r);
+				seg++;
+				break;
+			default:
+				// word and line anchors are left to the backtracking search
+				ok = false;
+				break;
+		}
+	}
+	if (!ok || !n)
+		return false;
+
+	// group characters that move between the same states
+	uint8_t first_chars[256];
+	int num_first = 0, classes = 0;
+	for (int c = 0; c<256; ++c) {
+		uint64_t next = 0, loop = 0;
+		for (int k = 0; k<n; ++k) {
+			bool in = st[k].test==WCSS_ANY || (st[k].test==WCSS_CHARS ? (c==st[k].a || c==st[k].b) : ranges[st[k].a].has((uint8_t)c));
+			if (in && st[k].type==WCSS_CHAR)
+				next |= 2ULL<<k;
+			else if (in && st[k].type==WCSS_REPEAT)
+				loop |= 1ULL<<k;
+		}
+		int cl = 0;
+		while (cl<classes && (class_next[cl]!=next || class_loop[cl]!=loop))
+			cl++;
+		if (cl==classes) {
+			if (classes==MAX_WILDCARD_CLASSES)
+				return false;
+			class_next[cl] = next;
+			class_loop[cl] = loop;
+			classes++;
+		}
+		char_class[c] = (uint8_t)cl;
+		if (next & 2)
+			first_chars[num_first++] = (uint8_t)c;
+	}
+
+	repeat = 0;
+	for (int k = 0; k<n; ++k) {
+		if (st[k].type==WCSS_REPEAT)
+			repeat |= 1ULL<<k;
+	}
+
+	// matches can only start on a character that leaves the first state
+	skip_first = st[0].type==WCSS_CHAR;
+	first.set_chars(strref((const char*)first_chars, num_first));
+	states = n;
+	return true;
+}
+
+// find the leftmost match, and from there the shortest, by tracking all partial
+// matches at once. start holds the first character of the leftmost partial match
+// in each state.
+strref strwild::find_automaton(const strref str, strl_t pos) const
+{
+	const uint8_t *text = str.get_u();
+	strl_t length = str.get_len();
+	if (pos>=length)
+		return strref();
+
+	uint64_t accept = 1ULL<<states;
+	uint64_t active = 0;
+	strl_t start[MAX_WILDCARD_STATES+1];
+	strl_t best_start = 0, best_end = 0;
+	bool found = false;
+	for (strl_t i = pos;; ++i) {
+		if (!found) {
+			if (!active && skip_first) {
+				int f = first.find(str, i);
+				if (f<0)
+					break;
+				i = (strl_t)f;
+			}
+			if (!(active & 1)) {
+				active |= 1;
+				start[0] = i;
+			}
+		}
+
+		// repeats also match zero characters
+		for (uint64_t x = active & repeat; x; x &= x-1) {
+			int k = int_ctz64(x);
+			uint64_t b = 2ULL<<k;
+			if (!(active & b) || start[k]<start[k+1]) {
+				active |= b;
+				start[k+1] = start[k];
+				if (repeat & b)
+					x |= b;
+			}
+		}
+
+		if (active & accept) {
+			if (!found || start[states]<best_start) {
+				best_start = start[states];
+				best_end = i;
+				found = true;
+			}
+			active &= ~accept;
+		}
+
+		// done when no partial match started before the best match
+		if (found) {
+			uint64_t x = active;
+			while (x && start[int_ctz64(x)]>=best_start)
+				x &= x-1;
+			if (!x)
+				break;
+		}
+		if (i>=length)
+			break;
+
+		// step all states over the next character, highest first to read the previous starts
+		uint8_t cl = char_class[text[i]];
+		uint64_t next = (active<<1) & class_next[cl];
+		uint64_t loop = active & class_loop[cl];
+		active = next | loop;
+		for (uint64_t x = active; x;) {
+			int k = int_msb64(x);
+			x ^= 1ULL<<k;
+			if (!((next>>k) & 1) || (((loop>>k) & 1) && start[k]<start[k-1]))
+				continue;
+			start[k] = start[k-1];
+		}
+	}
+	if (!found)
+		return strref();
+	if (tail>=0)
+		best_end += ranges[tail].len(str, best_end);
+	return strref(str.get() + best_start, best_end - best_start);
+}
+
+// search for the compiled wildcard in str
+strref strwild::find(const strref str, strl_t start) const
+{
+	if (engine==SWE_AUTOMATON)
+		return find_automaton(str, start);
 
-	// Convert the wildcard to a set of sequential searches and matches
-	int numType = _build_wildcard_steps(wild, segs, type, numSeg);
+	const char *string = str.get();
+	strl_t length = str.get_len();
+	int numType = steps;
 
 	// start going through the steps to find a match
 	int pos = (int)start;
@@ -3701,7 +6509,7 @@ strref strref::find_wildcard(const strref wild, strl_t start, bool case_sensitiv
 
 				case WCST_FIND_SUBSTR:
 					find = true;
-					pos = case_sensitive ? find_case_esc(segs[seg], (strl_t)pos) : find_esc(segs[seg], (strl_t)pos);
+					pos = case_sensitive ? str.find_case_esc(segs[seg], (strl_t)pos) : str.find_esc(segs[seg], (strl_t)pos);
 					if (pos<0) {
 						valid = false;
 						break;
@@ -3712,28 +6520,30 @@ strref strref::find_wildcard(const strref wild, strl_t start, bool case_sensitiv
 
 				case WCST_FIND_SUBSTR_RANGE:
 					find = true;
-					pos = case_sensitive ? find_case_esc_range(segs[seg], segs[seg + 1], (strl_t)pos) : find_esc_range(segs[seg], segs[seg + 1], (strl_t)pos);
+					pos = case_sensitive ? str.find_case_esc_range(segs[seg], ranges[step_range[step]], (strl_t)pos) : str.find_esc_range(segs[seg], ranges[step_range[step]], (strl_t)pos);
 					if (pos<0) {
 						valid = false;
 						break;
 					}
 					found_pos = (strl_t)pos;
-					pos += (int)segs[seg].length;
+					pos += (int)segs[seg].len_esc();
 					seg += 2;
 					break;
 
 				case WCST_SUBSTR_MATCH_RANGE:
-					valid = false;
-					while ((strl_t)pos < length && segs[seg].char_matches_ranges((uint8_t)get_at(pos))) {
-						pos++;
-						valid = true;
-					}
+					if ((strl_t)pos < length) {
+						strl_t skip = ranges[step_range[step]].len(str, (strl_t)pos);
+						valid = skip>0;
+						pos += (int)skip;
+					} else
+						valid = false;
 					seg++;
 					break;
 
 				case WCST_FIND_RANGE_CHAR:
 					find = true;
-					pos = find_any_char_or_range(segs[seg++], (strl_t)pos);
+					pos = ranges[step_range[step]].find(str, (strl_t)pos);
+					seg++;
 					if (pos<0) {
 						valid = false;
 						break;
@@ -3744,7 +6554,7 @@ strref strref::find_wildcard(const strref wild, strl_t start, bool case_sensitiv
 
 				case WCST_FIND_RANGE_CHAR_RANGED:
 					find = true;
-					pos = find_range_char_within_range(segs[seg], segs[seg + 1], (strl_t)pos);
+					pos = str.find_range_char_within_range(ranges[step_range[step]], ranges[step_within[step]], (strl_t)pos);
 					if (pos<0) {
 						valid = false;
 						break;
@@ -3762,39 +6572,40 @@ strref strref::find_wildcard(const strref wild, strl_t start, bool case_sensitiv
 					break;
 
 				case WCST_NEXT_RANGE_CHAR:
-					valid = !(pos == (int)length || !segs[seg++].char_matches_ranges(get_at(pos)));
+					valid = !(pos == (int)length || !ranges[step_range[step]].has(string[pos]));
+					seg++;
 					if (!valid)
 						break;
 					pos++;
 					break;
 
 				case WCST_NEXT_SUBSTR:
-					valid = same_substr_case_esc(segs[seg], pos);
+					valid = case_sensitive ? str.same_substr_case_esc(segs[seg], (strl_t)pos) : str.same_substr_esc(segs[seg], (strl_t)pos);
 					if (!valid)
 						break;
-					pos += (int)segs[seg++].length;
+					pos += (int)segs[seg++].len_esc();
 					break;
 
 				case WCST_NEXT_WORD_START:
-					valid = !(is_ws(string[pos]) || (pos && !is_ws(string[pos - 1])));
+					valid = strl_t(pos)<length && !(strref::is_ws(string[pos]) || (pos && !strref::is_ws(string[pos - 1])));
 					if (!valid)
 						break;
 					pos++;
 					break;
 
 				case WCST_NEXT_WORD_END:
-					valid = (pos==(int)length || is_ws(string[pos])) && pos && !is_ws(string[pos-1]);
+					valid = (pos==(int)length || strref::is_ws(string[pos])) && pos && !strref::is_ws(string[pos-1]);
 					break;
 
 				case WCST_FIND_WORD_START:
 					find = true;
 					// current position may be ok if first pos or prev=whitespace/separator
 					// skip if: current = separator or previous is not separator
-					if ((strl_t(pos)<length && is_sep_ws(string[pos])) || (pos && !is_sep_ws(string[pos-1]))) {
-						if (strl_t(pos)<length && !is_sep_ws(string[pos]))
-							pos += (int)len_non_sep_ws(pos);
-						if (strl_t(pos)<length && is_sep_ws(string[pos]))
-							pos += (int)len_sep_ws(pos);
+					if ((strl_t(pos)<length && strref::is_sep_ws(string[pos])) || (pos && !strref::is_sep_ws(string[pos-1]))) {
+						if (strl_t(pos)<length && !strref::is_sep_ws(string[pos]))
+							pos += (int)str.len_non_sep_ws((strl_t)pos);
+						if (strl_t(pos)<length && strref::is_sep_ws(string[pos]))
+							pos += (int)str.len_sep_ws((strl_t)pos);
 					}
 					valid = strl_t(pos) < length;
 					found_pos = (strl_t)pos;
@@ -3804,15 +6615,15 @@ strref strref::find_wildcard(const strref wild, strl_t start, bool case_sensitiv
 					find = true;
 					// current position may be ok if first pos or prev=whitespace/separator
 					// skip if: current = separator or previous is not separator
-					if (is_sep_ws(string[pos]) || (pos && !is_sep_ws(string[pos-1]))) {
-						while (strl_t(pos)<length && !is_sep_ws(string[pos])) {
-							valid = segs[seg].char_matches_ranges(string[pos]);
+					if ((strl_t(pos)<length && strref::is_sep_ws(string[pos])) || (pos && !strref::is_sep_ws(string[pos-1]))) {
+						while (strl_t(pos)<length && !strref::is_sep_ws(string[pos])) {
+							valid = ranges[step_range[step]].has(string[pos]);
 							if (!valid)
 								break;
 							pos++;
 						}
-						while (strl_t(pos)<length && is_sep_ws(string[pos])) {
-							valid = segs[seg].char_matches_ranges(string[pos]);
+						while (strl_t(pos)<length && strref::is_sep_ws(string[pos])) {
+							valid = ranges[step_range[step]].has(string[pos]);
 							if (!valid)
 								break;
 							pos++;
@@ -3827,15 +6638,15 @@ strref strref::find_wildcard(const strref wild, strl_t start, bool case_sensitiv
 					find = true;
 					// current position may be ok if first pos or prev=whitespace/separator
 					// skip if: current = separator or previous is not separator
-					if (!is_sep_ws(string[pos]) || (pos && is_sep_ws(string[pos-1]))) {
+					if ((strl_t(pos)<length && !strref::is_sep_ws(string[pos])) || (pos && strref::is_sep_ws(string[pos-1]))) {
 						valid = pos != (int)length;
 						if (!valid)
 							break;
 						else {
-							if (is_sep_ws(string[pos]))
-								pos += (int)len_sep_ws(pos);
-							if (!is_sep_ws(string[pos]))
-								pos += (int)len_non_sep_ws(pos);
+							if (strl_t(pos)<length && strref::is_sep_ws(string[pos]))
+								pos += (int)str.len_sep_ws((strl_t)pos);
+							if (strl_t(pos)<length && !strref::is_sep_ws(string[pos]))
+								pos += (int)str.len_non_sep_ws((strl_t)pos);
 						}
 					}
 					found_pos = (strl_t)pos;
@@ -3845,19 +6656,19 @@ strref strref::find_wildcard(const strref wild, strl_t start, bool case_sensitiv
 					find = true;
 					// current position may be ok if first pos or prev=whitespace/separator
 					// skip if: current = separator or previous is not separator
-					if (!is_sep_ws(string[pos]) || (pos && is_sep_ws(string[pos-1]))) {
+					if ((strl_t(pos)<length && !strref::is_sep_ws(string[pos])) || (pos && strref::is_sep_ws(string[pos-1]))) {
 						valid = pos != (int)length;
 						if (!valid)
 							break;
 						else {
-							while (strl_t(pos)<length && is_sep_ws(string[pos])) {
-								valid = segs[seg].char_matches_ranges(string[pos]);
+							while (strl_t(pos)<length && strref::is_sep_ws(string[pos])) {
+								valid = ranges[step_range[step]].has(string[pos]);
 								if (!valid)
 									break;
 								pos++;
 							}
-							while (strl_t(pos)<length && !is_sep_ws(string[pos])) {
-								valid = segs[seg].char_matches_ranges(string[pos]);
+							while (strl_t(pos)<length && !strref::is_sep_ws(string[pos])) {
+								valid = ranges[step_range[step]].has(string[pos]);
 								if (!valid)
 									break;
 								pos++;
@@ -3901,7 +6712,7 @@ strref strref::find_wildcard(const strref wild, strl_t start, bool case_sensitiv
 					// skip if: current = separator or previous is not separator
 					if (pos && string[pos-1]!=0xa && string[pos-1]!=0x0d) {
 						while (strl_t(pos)<length && string[pos]!=0x0a && string[pos]!=0x0d) {
-							if (!segs[seg].char_matches_ranges(string[pos])) {
+							if (!ranges[step_range[step]].has(string[pos])) {
 								valid = false;
 								break;
 							}
@@ -3935,7 +6746,7 @@ strref strref::find_wildcard(const strref wild, strl_t start, bool case_sensitiv
 					// skip if: current = separator or previous is not separator
 					while (strl_t(pos)<length && string[pos]!=0x0a && string[pos]!=0x0d)
 						pos++;
-					found_pos = true;
+					found_pos = (strl_t)pos;
 					break;
 				case WCST_FIND_LINE_END_RANGED:
 					find = true;
@@ -3943,7 +6754,7 @@ strref strref::find_wildcard(const strref wild, strl_t start, bool case_sensitiv
 					// skip if: current = separator or previous is not separator
 					// note: end of string is also a valid end of line so make a custom step
 					while (strl_t(pos)<length && string[pos]!=0x0a && string[pos]!=0x0d) {
-						if (!segs[seg].char_matches_ranges(string[pos])) {
+						if (!ranges[step_range[step]].has(string[pos])) {
 							valid = false;
 							break;
 						}
@@ -3956,14 +6767,30 @@ strref strref::find_wildcard(const strref wild, strl_t start, bool case_sensitiv
 
 			// if current step is not valid go to the next character and try again
 			if (!valid) {
-				if (last_valid_stack) {
+				while (last_valid_stack && !valid) {
 					last_valid_stack--;	// step back one level and try again
 					step = last_valid_search_step[last_valid_stack];
 					seg = last_valid_search_seg[last_valid_stack];
-					pos = (int)last_valid_search_pos[last_valid_stack] + 1;
-					valid = true;
+					strl_t resume = last_valid_search_pos[last_valid_stack];
+					pos = (int)resume + 1;
+					valid = strl_t(pos) <= length;
+					// a search limited to a range can only step over characters in range
+					if (valid && resume<length) {
+						switch (type[step]) {
+							case WCST_FIND_SUBSTR_RANGE:
+							case WCST_FIND_WORD_START_RANGED:
+							case WCST_FIND_WORD_END_RANGED:
+							case WCST_FIND_LINE_START_RANGED:
+							case WCST_FIND_LINE_END_RANGED:
+								valid = ranges[step_range[step]].has(string[resume]);
+								break;
+							case WCST_FIND_RANGE_CHAR_RANGED:
+								valid = ranges[step_within[step]].has(string[resume]);
+								break;
+						}
+					}
 				}
-				else {
+				if (!valid) {
 					pos = first_pos + 1;
 					break;
 				}
@@ -3982,7 +6809,239 @@ strref strref::find_wildcard(const strref wild, strl_t start, bool case_sensitiv
 			}
 		}
 	}
-	return strref();
+	return strref();
+}
+
+strmulti::strmulti(strmulti_node *node_array, int node_count, bool case_sens)
+{
+	nodes = node_array;
+	capacity = node_count;
+	case_sensitive = case_sens;
+	clear();
+}
+
+void strmulti::clear()
+{
+	num_nodes = 0;
+	num_patterns = 0;
+	if (capacity) {
+		memset(nodes, 0, sizeof(strmulti_node));
+		nodes[0].pattern = -1;
+		num_nodes = 1;
+	}
+	memset(root, 0, sizeof(root));
+	first.clear();
+}
+
+// node following node on character c or 0
+int strmulti::child(int node, uint8_t c) const
+{
+	for (int k = nodes[node].child; k; k = nodes[k].sibling) {
+		if (nodes[k].c==c)
+			return k;
+	}
+	return 0;
+}
+
+int strmulti::add(const strref pattern)
+{
+	strl_t len = pattern.get_len();
+	if (!len || !num_nodes)
+		return -1;
+
+	// check that all new nodes fit before changing the tree
+	const uint8_t *p = pattern.get_u();
+	int node = 0;
+	strl_t n = 0;
+	while (n<len) {
+		int k = child(node, case_sensitive ? p[n] : int_tolower_ascii7(p[n]));
+		if (!k)
+			break;
+		node = k;
+		n++;
+	}
+	if ((strl_t)(capacity-num_nodes) < len-n)
+		return -1;
+
+	for (; n<len; ++n) {
+		strmulti_node &k = nodes[num_nodes];
+		k.child = 0;
+		k.sibling = nodes[node].child;
+		k.fail = 0;
+		k.out = 0;
+		k.pattern = -1;
+		k.depth = n+1;
+		k.c = case_sensitive ? p[n] : int_tolower_ascii7(p[n]);
+		nodes[node].child = num_nodes;
+		node = num_nodes++;
+	}
+	if (nodes[node].pattern<0)
+		nodes[node].pattern = num_patterns;
+	return num_patterns++;
+}
+
+bool strmulti::add(const strref *patterns, int count)
+{
+	bool ok = true;
+	for (int i = 0; i<count; ++i)
+		ok = add(patterns[i])>=0 && ok;
+	return ok;
+}
+
+// breadth first so fail nodes are done before the nodes that refer to them,
+// the queue is linked through out until each node is visited.
+void strmulti::build()
+{
+	if (!num_nodes)
+		return;
+	memset(root, 0, sizeof(root));
+	uint8_t starts[256];
+	int num_starts = 0;
+	int head = 0, tail = 0;
+	for (int k = nodes[0].child; k; k = nodes[k].sibling) {
+		root[nodes[k].c] = k;
+		starts[num_starts++] = nodes[k].c;
+		if (!case_sensitive && nodes[k].c!=int_toupper_ascii7(nodes[k].c)) {
+			root[int_toupper_ascii7(nodes[k].c)] = k;
+			starts[num_starts++] = int_toupper_ascii7(nodes[k].c);
+		}
+		nodes[k].fail = 0;
+		nodes[k].out = 0;
+		if (tail)
+			nodes[tail].out = k;
+		else
+			head = k;
+		tail = k;
+	}
+	first.set_chars(strref((const char*)starts, (strl_t)num_starts));
+
+	while (head) {
+		int node = head;
+		head = nodes[node].out;
+		int f = nodes[node].fail;
+		nodes[node].out = nodes[f].pattern>=0 ? f : nodes[f].out;
+		for (int k = nodes[node].child; k; k = nodes[k].sibling) {
+			uint8_t c = nodes[k].c;
+			int fk = f;
+			while (fk && !child(fk, c))
+				fk = nodes[fk].fail;
+			nodes[k].fail = fk ? child(fk, c) : root[c];
+			nodes[k].out = 0;
+			if (head)
+				nodes[tail].out = k;
+			else
+				head = k;
+			tail = k;
+		}
+	}
+}
+
+bool strmulti::next(const strref text, strmulti_hit &hit) const
+{
+	// more patterns ending at the same position
+	int match = hit.out;
+	if (!match) {
+		const uint8_t *t = text.get_u();
+		strl_t length = text.get_len();
+		strl_t i = hit.scan;
+		int node = hit.node;
+		while (!match && i<length) {
+			if (!node && !first.has(t[i])) {
+				int f = first.find(text, i);
+				if (f<0) {
+					i = length;
+					break;
+				}
+				i = (strl_t)f;
+			}
+			uint8_t c = t[i++];
+			if (!case_sensitive)
+				c = int_tolower_ascii7(c);
+			int k = 0;
+			while (node && !(k = child(node, c)))
+				node = nodes[node].fail;
+			node = node ? k : root[c];
+			match = nodes[node].pattern>=0 ? node : nodes[node].out;
+		}
+		hit.scan = i;
+		hit.node = node;
+		if (!match) {
+			hit.out = 0;
+			hit.pattern = -1;
+			return false;
+		}
+	}
+	hit.out = nodes[match].out;
+	hit.pattern = nodes[match].pattern;
+	hit.len = nodes[match].depth;
+	hit.pos = hit.scan - hit.len;
+	return true;
+}
+
+int strmulti::find(const strref text, strl_t pos, int *pattern) const
+{
+	strmulti_hit hit(pos);
+	if (!next(text, hit))
+		return -1;
+	if (pattern)
+		*pattern = hit.pattern;
+	return (int)hit.pos;
+}
+
+// needle length from which the skip table is faster than the vector search
+#ifndef STRREF_SEARCHER_SKIP_LEN
+#if defined(STRUSE_AVX2)
+#define STRREF_SEARCHER_SKIP_LEN 24
+#elif defined(STRUSE_V16)
+#define STRREF_SEARCHER_SKIP_LEN 16
+#else
+#define STRREF_SEARCHER_SKIP_LEN 4
+#endif
+#endif
+
+void strref_searcher::set(const strref str, bool case_sens)
+{
+	needle = str;
+	case_sensitive = case_sens;
+	strl_t len = str.get_len();
+	use_skip = len>=STRREF_SEARCHER_SKIP_LEN;
+	last = last_fold = 0;
+	if (!len)
+		return;
+	const uint8_t *n = str.get_u();
+	last_fold = case_sensitive ? 0 : int_fold_bit(n[len-1]);
+	last = n[len-1] | last_fold;
+	if (use_skip) {
+		for (int c = 0; c<256; ++c)
+			skip[c] = len;
+		for (strl_t i = 0; i<(len-1); ++i) {
+			skip[n[i]] = len - 1 - i;
+			if (!case_sensitive && int_fold_bit(n[i]))
+				skip[n[i] ^ 0x20] = len - 1 - i;
+		}
+	}
+}
+
+int strref_searcher::find(const strref text, strl_t pos) const
+{
+	strl_t len = needle.get_len();
+	if (!len || !text.valid() || pos>=text.get_len())
+		return -1;
+	const uint8_t *t = text.get_u() + pos;
+	strl_t length = text.get_len() - pos;
+	if (!use_skip) {
+		int o = int_find_substr(t, length, needle.get_u(), len, !case_sensitive);
+		return o<0 ? -1 : int(o + pos);
+	}
+
+	// shift the window by how far the last character of it is from the end of the needle
+	const uint8_t *n = needle.get_u();
+	strl_t end = len - 1;
+	for (strl_t o = 0; (o + len)<=length; o += skip[t[o + end]]) {
+		if ((t[o + end] | last_fold)==last && int_same_substr(t + o, n, end, !case_sensitive))
+			return int(o + pos);
+	}
+	return -1;
 }
 
 // read one utf8 from the start of a string
@@ -4041,6 +7100,491 @@ bool strref::valid_ascii7() const
 	return true;
 }
 
+#ifdef STRUSE_V16_LOOKUP
+// utf8 errors found from a byte and the one before it, see "Validating UTF-8 In Less Than
+// One Instruction Per Byte" by Keiser and Lemire
+enum UTF8_ERROR {
+	U8E_TOO_SHORT = 0x01,		// lead byte not followed by a continuation
+	U8E_TOO_LONG = 0x02,		// continuation after ascii
+	U8E_OVERLONG_3 = 0x04,		// 3 byte code below 0x800
+	U8E_TOO_LARGE = 0x08,		// code past 0x10ffff
+	U8E_SURROGATE = 0x10,		// code in 0xd800-0xdfff
+	U8E_OVERLONG_2 = 0x20,		// 2 byte code below 0x80
+	U8E_TOO_LARGE_1000 = 0x40,	// code past 0x10ffff from a lead byte past 0xf4
+	U8E_OVERLONG_4 = 0x40,		// 4 byte code below 0x10000
+	U8E_TWO_CONTS = 0x80,		// two continuations, valid only for third or fourth byte
+	U8E_CARRY = U8E_TOO_SHORT | U8E_TOO_LONG | U8E_TWO_CONTS,
+};
+
+// error flags indexed by the high nibble of the previous byte
+static const uint8_t _aUTF8_Prev_Hi[16] = {
+	U8E_TOO_LONG, U8E_TOO_LONG, U8E_TOO_LONG, U8E_TOO_LONG,
+	U8E_TOO_LONG, U8E_TOO_LONG, U8E_TOO_LONG, U8E_TOO_LONG,
+	U8E_TWO_CONTS, U8E_TWO_CONTS, U8E_TWO_CONTS, U8E_TWO_CONTS,
+	U8E_TOO_SHORT | U8E_OVERLONG_2,
+	U8E_TOO_SHORT,
+	U8E_TOO_SHORT | U8E_OVERLONG_3 | U8E_SURROGATE,
+	U8E_TOO_SHORT | U8E_TOO_LARGE | U8E_TOO_LARGE_1000 | U8E_OVERLONG_4
+};
+
+// error flags indexed by the low nibble of the previous byte
+static const uint8_t _aUTF8_Prev_Lo[16] = {
+	U8E_CARRY | U8E_OVERLONG_3 | U8E_OVERLONG_2 | U8E_OVERLONG_4,
+	U8E_CARRY | U8E_OVERLONG_2,
+	U8E_CARRY,
+	U8E_CARRY,
+	U8E_CARRY | U8E_TOO_LARGE,
+	U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000,
+	U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000,
+	U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000,
+	U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000,
+	U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000,
+	U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000,
+	U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000,
+	U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000,
+	U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000 | U8E_SURROGATE,
+	U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000,
+	U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000
+};
+
+// error flags indexed by the high nibble of the current byte
+static const uint8_t _aUTF8_Curr_Hi[16] = {
+	U8E_TOO_SHORT, U8E_TOO_SHORT, U8E_TOO_SHORT, U8E_TOO_SHORT,
+	U8E_TOO_SHORT, U8E_TOO_SHORT, U8E_TOO_SHORT, U8E_TOO_SHORT,
+	U8E_TOO_LONG | U8E_OVERLONG_2 | U8E_TWO_CONTS | U8E_OVERLONG_3 | U8E_TOO_LARGE_1000 | U8E_OVERLONG_4,
+	U8E_TOO_LONG | U8E_OVERLONG_2 | U8E_TWO_CONTS | U8E_OVERLONG_3 | U8E_TOO_LARGE,
+	U8E_TOO_LONG | U8E_OVERLONG_2 | U8E_TWO_CONTS | U8E_SURROGATE | U8E_TOO_LARGE,
+	U8E_TOO_LONG | U8E_OVERLONG_2 | U8E_TWO_CONTS | U8E_SURROGATE | U8E_TOO_LARGE,
+	U8E_TOO_SHORT, U8E_TOO_SHORT, U8E_TOO_SHORT, U8E_TOO_SHORT
+};
+
+// highest last bytes of a block that do not need a continuation in the next block
+static const uint8_t _aUTF8_Complete[16] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xef, 0xdf, 0xbf
+};
+
+// non-zero bytes where 16 bytes of utf8 following prev are not well formed
+static inline int_v16 int_utf8_errors_v16(int_v16 v, int_v16 prev)
+{
+	int_v16 prev1 = int_v16_prev1(v, prev);
+	int_v16 err = int_v16_and(int_v16_lookup(int_v16_load(_aUTF8_Prev_Hi), int_v16_hi_nibble(prev1)),
+		int_v16_lookup(int_v16_load(_aUTF8_Prev_Lo), int_v16_lo_nibble(prev1)));
+	err = int_v16_and(err, int_v16_lookup(int_v16_load(_aUTF8_Curr_Hi), int_v16_hi_nibble(v)));
+	int_v16 third = int_v16_subs(int_v16_prev2(v, prev), int_v16_set1(0xe0-0x80));
+	int_v16 fourth = int_v16_subs(int_v16_prev3(v, prev), int_v16_set1(0xf0-0x80));
+	return int_v16_xor(err, int_v16_and(int_v16_or(third, fourth), int_v16_set1(0x80)));
+}
+#else
+// utf8 byte classes and state transitions, see "Flexible and Economical UTF-8 Decoder"
+// by Bjoern Hoehrmann. State 0 is between characters and 12 is an error.
+#define STRUSE_UTF8_REJECT 12
+static const uint8_t _aUTF8_Class[0x100] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9,
+	7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+	7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+	8, 8, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	10, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 4, 3, 3,
+	11, 6, 6, 6, 5, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8
+};
+
+static const uint8_t _aUTF8_State[108] = {
+	0, 12, 24, 36, 60, 96, 84, 12, 12, 12, 48, 72,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 0, 12, 12, 12, 12, 12, 0, 12, 0, 12, 12,
+	12, 24, 12, 12, 12, 12, 12, 24, 12, 24, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 24, 12, 12, 12, 12,
+	12, 24, 12, 12, 12, 12, 12, 12, 12, 24, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 36, 12, 36, 12, 12,
+	12, 36, 12, 12, 12, 12, 12, 36, 12, 36, 12, 12,
+	12, 36, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12
+};
+#endif
+
+// check that the string is well formed utf8, no overlong codes, surrogates or codes past 0x10ffff
+bool strref::valid_utf8() const
+{
+	const uint8_t *s = get_u();
+	strl_t o = 0;
+#ifdef STRUSE_V16_LOOKUP
+	int_v16 zero = int_v16_set1(0), ascii = int_v16_set1(0x7f), complete = int_v16_load(_aUTF8_Complete);
+	int_v16 prev = zero, err = zero, incomplete = zero;
+	while (o<length) {
+		int_v16 v;
+		// skip ascii 64 bytes at a time
+		while ((o+64)<=length) {
+			v = int_v16_or(int_v16_or(int_v16_load(s + o), int_v16_load(s + o + 16)),
+				int_v16_or(int_v16_load(s + o + 32), int_v16_load(s + o + 48)));
+			if (int_v16_mask(int_v16_eq(int_v16_min(v, ascii), v))!=0xffff)
+				break;
+			err = int_v16_or(err, incomplete);
+			incomplete = prev = zero;
+			o += 64;
+		}
+		if (o>=length)
+			break;
+		if ((o+16)<=length)
+			v = int_v16_load(s + o);
+		else {
+			// zero padding after the end shows up as a missing continuation
+			uint8_t tail[16] = {};
+			memcpy(tail, s + o, length - o);
+			v = int_v16_load(tail);
+		}
+		if (int_v16_mask(int_v16_eq(int_v16_min(v, ascii), v))==0xffff)
+			err = int_v16_or(err, incomplete);
+		else
+			err = int_v16_or(err, int_utf8_errors_v16(v, prev));
+		incomplete = int_v16_subs(v, complete);
+		prev = v;
+		o += 16;
+		// stop early on errors every 1KB
+		if (!(o & 0x3ff) && int_v16_mask(int_v16_eq(err, zero))!=0xffff)
+			return false;
+	}
+	err = int_v16_or(err, incomplete);
+	return int_v16_mask(int_v16_eq(err, zero))==0xffff;
+#else
+	uint8_t state = 0;
+	while (o<length) {
+		// skip ascii 8 bytes at a time between characters
+		while (!state && (o+8)<=length && !(int_read64(s + o, false) & 0x8080808080808080ULL))
+			o += 8;
+		for (strl_t e = (o+64)<length ? (o+64) : length; o<e; o++)
+			state = _aUTF8_State[state + _aUTF8_Class[s[o]]];
+		if (state==STRUSE_UTF8_REJECT)
+			return false;
+	}
+	return !state;
+#endif
+}
+
+// number of bytes that continue a utf8 character in 8 bytes, the flag bits are added
+// up in the top byte by a multiply
+static inline strl_t int_utf8_conts64(uint64_t x)
+{
+	uint64_t conts = (x & ~(x<<1) & 0x8080808080808080ULL)>>7;
+	return strl_t((conts * 0x0101010101010101ULL)>>56);
+}
+
+// number of bytes that continue a utf8 character
+static strl_t int_utf8_conts(const uint8_t *s, strl_t length)
+{
+	strl_t o = 0, conts = 0;
+#ifdef STRUSE_V16
+	// count continuations per lane for up to 255 blocks before adding up the lanes
+	int_v16 c0 = int_v16_set1(0x80), c1 = int_v16_set1(0x3f);
+	while ((o+16)<=length) {
+		int_v16 acc = int_v16_set1(0);
+		for (int b = 0; b<255 && (o+16)<=length; b++, o += 16) {
+			int_v16 t = int_v16_sub(int_v16_load(s + o), c0);
+			acc = int_v16_sub(acc, int_v16_eq(int_v16_min(t, c1), t));
+		}
+		conts += strl_t(int_v16_sum(acc));
+	}
+#endif
+	for (; (o+8)<=length; o += 8)
+		conts += int_utf8_conts64(int_read64(s + o, false));
+	for (; o<length; o++)
+		conts += (s[o] & 0xc0)==0x80 ? 1 : 0;
+	return conts;
+}
+
+// number of utf8 characters, each byte that does not continue a character counts as one
+strl_t strref::count_utf8_chars() const
+{
+	return length - int_utf8_conts(get_u(), length);
+}
+
+// byte position of utf8 character n, the length if there are exactly n characters or -1 if fewer
+int strref::utf8_offset_of(strl_t n) const
+{
+	const uint8_t *s = get_u();
+	strl_t o = 0;
+	// skip chunks with no more character starts than are left to skip
+	for (; (o+256)<=length; o += 256) {
+		strl_t starts = 256 - int_utf8_conts(s + o, 256);
+		if (starts>n)
+			break;
+		n -= starts;
+	}
+	for (; (o+8)<=length; o += 8) {
+		strl_t starts = 8 - int_utf8_conts64(int_read64(s + o, false));
+		if (starts>n)
+			break;
+		n -= starts;
+	}
+	for (; o<length; o++) {
+		if ((s[o] & 0xc0)!=0x80) {
+			if (!n)
+				return int(o);
+			n--;
+		}
+	}
+	return n ? -1 : int(length);
+}
+
+// number of utf16 units needed for well formed utf8, one per character and one more past 0xffff
+strl_t strref::utf16_len() const
+{
+	const uint8_t *s = get_u();
+	strl_t o = 0, n = 0;
+	for (; (o+8)<=length; o += 8) {
+		uint64_t x = int_read64(s + o, false);
+		uint64_t starts = ~(x & ~(x<<1)) & 0x8080808080808080ULL;
+		uint64_t four = x & (x<<1) & (x<<2) & (x<<3) & 0x8080808080808080ULL;
+		n += strl_t((((starts>>7) + (four>>7)) * 0x0101010101010101ULL)>>56);
+	}
+	for (; o<length; o++)
+		n += ((s[o] & 0xc0)!=0x80 ? 1 : 0) + (s[o]>=0xf0 ? 1 : 0);
+	return n;
+}
+
+// decode a well formed utf8 character from a lead byte at 0x80 or above and return its
+// length, or return 0 if it is not well formed
+static inline strl_t int_utf8_decode(const uint8_t *s, const uint8_t *e, size_t &c)
+{
+	uint8_t a = s[0];
+	strl_t left = strl_t(e - s);
+	if (a<0xe0) {
+		if (a<0xc2 || left<2 || (s[1] & 0xc0)!=0x80)
+			return 0;
+		c = (size_t(a & 0x1f)<<6) | (s[1] & 0x3f);
+		return 2;
+	}
+	if (a<0xf0) {
+		if (left<3 || ((s[1] & 0xc0) | ((s[2] & 0xc0)<<8))!=0x8080)
+			return 0;
+		size_t d = (size_t(a & 0x0f)<<12) | (size_t(s[1] & 0x3f)<<6) | (s[2] & 0x3f);
+		if (d<0x800 || (d>=0xd800 && d<0xe000))
+			return 0;
+		c = d;
+		return 3;
+	}
+	if (a>=0xf5 || left<4 || ((s[1] & 0xc0) | ((s[2] & 0xc0)<<8) | ((s[3] & 0xc0)<<16))!=0x808080)
+		return 0;
+	size_t d = (size_t(a & 0x07)<<18) | (size_t(s[1] & 0x3f)<<12) | (size_t(s[2] & 0x3f)<<6) | (s[3] & 0x3f);
+	if (d<0x10000 || d>=0x110000)
+		return 0;
+	c = d;
+	return 4;
+}
+
+// encode a code from 0x80 up to 0x10ffff as utf8 and return its length
+static inline strl_t int_utf8_encode(uint8_t *p, size_t c)
+{
+	if (c<0x800) {
+		p[0] = uint8_t(0xc0 | (c>>6));
+		p[1] = uint8_t(0x80 | (c & 0x3f));
+		return 2;
+	}
+	if (c<0x10000) {
+		p[0] = uint8_t(0xe0 | (c>>12));
+		p[1] = uint8_t(0x80 | ((c>>6) & 0x3f));
+		p[2] = uint8_t(0x80 | (c & 0x3f));
+		return 3;
+	}
+	p[0] = uint8_t(0xf0 | (c>>18));
+	p[1] = uint8_t(0x80 | ((c>>12) & 0x3f));
+	p[2] = uint8_t(0x80 | ((c>>6) & 0x3f));
+	p[3] = uint8_t(0x80 | (c & 0x3f));
+	return 4;
+}
+
+// decode up to 4 two byte characters from 8 readable bytes into 16 bit lanes and return
+// how many of them start at s
+static inline strl_t int_utf8_decode_2x4(const uint8_t *s, uint64_t &codes)
+{
+	const uint64_t lanes = 0x0001000100010001ULL;
+	uint64_t x = int_read64(s, false);
+	uint64_t bad = ((x & (0xc0e0*lanes)) ^ (0x80c0*lanes)) | (~((x & (0x1e*lanes)) + 0x7ffe*lanes) & (0x8000*lanes));
+	codes = ((x & (0x1f*lanes))<<6) | ((x>>8) & (0x3f*lanes));
+	return bad ? strl_t(int_ctz64(bad)>>4) : 4;
+}
+
+// decode 2 three byte characters from 8 readable bytes, false if they are not
+static inline bool int_utf8_decode_3x2(const uint8_t *s, uint32_t &c0, uint32_t &c1)
+{
+	uint64_t x = int_read64(s, false);
+	if ((x & 0xc0c0f0c0c0f0ULL)!=0x8080e08080e0ULL)
+		return false;
+	c0 = uint32_t(((x & 0x0f)<<12) | ((x>>2) & 0xfc0) | ((x>>16) & 0x3f));
+	x >>= 24;
+	c1 = uint32_t(((x & 0x0f)<<12) | ((x>>2) & 0xfc0) | ((x>>16) & 0x3f));
+	return c0>=0x800 && c1>=0x800 && (c0 & 0xf800)!=0xd800 && (c1 & 0xf800)!=0xd800;
+}
+
+// encode 4 codes below 0x800 in 16 bit lanes as 1 or 2 bytes each into 8 writable bytes
+static inline strl_t int_utf8_encode_2x4(uint8_t *p, uint64_t x)
+{
+	const uint64_t lanes = 0x0001000100010001ULL;
+	uint64_t two = ((x + 0x7f80*lanes)>>15) & lanes;
+	uint64_t enc = ((x>>6) & (0x1f*lanes)) | (0xc0*lanes) | (((x & (0x3f*lanes)) | (0x80*lanes))<<8);
+	enc = (enc & (two*0xffff)) | (x & ~(two*0xffff));
+	strl_t n = 0;
+	for (int i = 0; i<4; ++i) {
+		p[n] = uint8_t(enc>>(16*i));
+		p[n+1] = uint8_t(enc>>(16*i+8));
+		n += 1 + strl_t((two>>(16*i)) & 1);
+	}
+	return n;
+}
+
+// encode 2 codes from 0x800 to 0xffff that are not surrogates as 6 bytes into 8 writable bytes
+static inline void int_utf8_encode_3x2(uint8_t *p, uint64_t c0, uint64_t c1)
+{
+	uint64_t e0 = 0xe0 | (c0>>12) | ((0x80 | ((c0>>6) & 0x3f))<<8) | ((0x80 | (c0 & 0x3f))<<16);
+	uint64_t e1 = 0xe0 | (c1>>12) | ((0x80 | ((c1>>6) & 0x3f))<<8) | ((0x80 | (c1 & 0x3f))<<16);
+	int_write64(p, e0 | (e1<<24));
+}
+
+// convert utf8 to utf16 or utf32 units, ascii a vector at a time, two and three byte
+// characters a few at a time and other characters one at a time
+template <class U> static strl_t int_utf8_to_units(U *out, strl_t cap, const uint8_t *s, strl_t length, strl_t &read)
+{
+	strl_t r = 0, w = 0;
+#ifdef STRUSE_V16
+	int_v16 ascii = int_v16_set1(0x7f);
+#endif
+	while (r<length && w<cap) {
+		uint8_t a = s[r];
+		if (a<0x80) {
+			// all the characters are widened and the ascii ones at the start are kept
+#ifdef STRUSE_V16
+			if ((r+16)<=length && (w+16)<=cap) {
+				int_v16 v = int_v16_load(s + r);
+				uint32_t other = ~int_v16_mask(int_v16_eq(int_v16_min(v, ascii), v));
+				int_v16_widen(out + w, v);
+				strl_t k = strl_t(int_ctz32(other | 0x10000));
+				r += k;
+				w += k;
+				continue;
+			}
+#else
+			if ((r+8)<=length && (w+8)<=cap && !(int_read64(s + r, false) & 0x8080808080808080ULL)) {
+				for (strl_t i = 0; i<8; i++)
+					out[w+i] = s[r+i];
+				r += 8;
+				w += 8;
+				continue;
+			}
+#endif
+			out[w++] = a;
+			r++;
+			continue;
+		}
+		if ((r+8)<=length && (w+4)<=cap) {
+			if (a<0xe0) {
+				uint64_t codes;
+				strl_t k;
+				if ((s[r+2] & 0xc0)==0xc0 && (k = int_utf8_decode_2x4(s + r, codes))) {
+					for (int i = 0; i<4; ++i)
+						out[w+i] = U(uint16_t(codes>>(16*i)));
+					r += 2*k;
+					w += k;
+					continue;
+				}
+			} else if (a<0xf0) {
+				uint32_t c0, c1;
+				if (int_utf8_decode_3x2(s + r, c0, c1)) {
+					out[w] = U(c0);
+					out[w+1] = U(c1);
+					r += 6;
+					w += 2;
+					continue;
+				}
+			}
+		}
+		size_t c = 0xfffd;
+		strl_t n = int_utf8_decode(s + r, s + length, c);
+		if (sizeof(U)==2 && n==4) {
+			if ((w+2)>cap)
+				break;
+			c -= 0x10000;
+			out[w++] = U(0xd800 + (c>>10));
+			out[w++] = U(0xdc00 + (c & 0x3ff));
+		} else
+			out[w++] = U(c);
+		r += n ? n : 1;
+	}
+	read = r;
+	return w;
+}
+
+// convert utf16 or utf32 units to utf8, ascii a vector at a time, codes below 0x800 four
+// at a time, other codes below 0x10000 two at a time and the rest one at a time
+template <class U> static strl_t int_units_to_utf8(uint8_t *out, strl_t cap, const U *s, strl_t count, strl_t &read)
+{
+	strl_t r = 0, w = 0;
+	while (r<count && w<cap) {
+		size_t c = s[r];
+#ifdef STRUSE_V16
+		if (c<0x80 && (r+16)<=count && (w+16)<=cap && int_v16_narrow(out + w, s + r)) {
+			r += 16;
+			w += 16;
+			continue;
+		}
+#endif
+		if ((r+4)<=count && (w+8)<=cap) {
+			if ((c | s[r+1] | s[r+2] | s[r+3])<0x800) {
+				w += int_utf8_encode_2x4(out + w, uint64_t(c) | (uint64_t(s[r+1])<<16) |
+					(uint64_t(s[r+2])<<32) | (uint64_t(s[r+3])<<48));
+				r += 4;
+				continue;
+			}
+			size_t d = s[r+1];
+			if (c>=0x800 && c<0x10000 && (c & 0xf800)!=0xd800 && d>=0x800 && d<0x10000 && (d & 0xf800)!=0xd800) {
+				int_utf8_encode_3x2(out + w, c, d);
+				r += 2;
+				w += 6;
+				continue;
+			}
+		}
+		if (c<0x80) {
+			out[w++] = uint8_t(c);
+			r++;
+			continue;
+		}
+		strl_t n = 1;
+		if (sizeof(U)==2 && (c & 0xfc00)==0xd800 && (r+1)<count && (s[r+1] & 0xfc00)==0xdc00) {
+			c = 0x10000 + ((c - 0xd800)<<10) + (s[r+1] - 0xdc00);
+			n = 2;
+		} else if ((c>=0xd800 && c<0xe000) || c>0x10ffff)
+			c = 0xfffd;
+		if ((w+4)>cap && (w+int_utf8_size(c))>cap)
+			break;
+		w += int_utf8_encode(out + w, c);
+		r += n;
+	}
+	read = r;
+	return w;
+}
+
+strl_t strref::to_utf16(uint16_t *out, strl_t cap, strl_t *read) const
+{
+	strl_t r = 0, w = out ? int_utf8_to_units(out, cap, get_u(), length, r) : 0;
+	if (read)
+		*read = r;
+	return w;
+}
+
+strl_t strref::to_utf32(uint32_t *out, strl_t cap, strl_t *read) const
+{
+	strl_t r = 0, w = out ? int_utf8_to_units(out, cap, get_u(), length, r) : 0;
+	if (read)
+		*read = r;
+	return w;
+}
+
 // find the character d outside of quoted xml text
 int strref::find_quoted_xml(char d) const
 {
@@ -4232,6 +7776,11 @@ strref strref::split_token_any_trim( const strref chars )
 }
 
 strref strref::split_range( const strref range, strl_t pos )
+{
+	return split_range( strrange( range ), pos );
+}
+
+strref strref::split_range( const strrange &range, strl_t pos )
 {
 	int t = find_any_char_or_range( range, pos );
 	if ( t < 0 ) t = ( int )length;
@@ -4239,7 +7788,13 @@ strref strref::split_range( const strref range, strl_t pos )
 	*this += t;
 	return r;
 }
+
 strref strref::split_range_trim( const strref range, strl_t pos )
+{
+	return split_range_trim( strrange( range ), pos );
+}
+
+strref strref::split_range_trim( const strrange &range, strl_t pos )
 {
 	int t = find_any_char_or_range( range, pos );
 	if ( t < 0 ) t = ( int )length;
@@ -4529,7 +8084,19 @@ strl_t strref::len_float_number() const
 // count number of valid hexadecimal characters, leading 0x not valid
 strl_t strref::len_hex() const
 {
-	for (strl_t i = 0; i < length; i++) {
+	strl_t i = 0;
+	for (; i < length && i < 8; i++) {
+		if (!is_hex((uint8_t)string[i]))
+			return i;
+	}
+	// longer runs 8 at a time
+	for (; (i + 8) <= length; i += 8) {
+		uint64_t bad;
+		int_hex_swar(int_read64(get_u() + i, false), bad);
+		if (bad)
+			return i + (int_ctz64(bad) >> 3);
+	}
+	for (; i < length; i++) {
 		if (!is_hex((uint8_t)string[i]))
 			return i;
 	}
@@ -4539,11 +8106,8 @@ strl_t strref::len_hex() const
 // insert a substring into a string
 strl_t _strmod_insert(char *string, strl_t length, strl_t cap, const strref sub, strl_t pos)
 {
-	if (pos>length)
-		return 0;
-
-	if (sub.get_len()==0)
-		return 0;
+	if (pos>length || sub.get_len()==0)
+		return length;
 
 	strl_t ins = sub.get_len();
 	strl_t end = length;
@@ -4636,88 +8200,610 @@ strl_t _strmod_insert_esc(char *string, strl_t length, strl_t cap, const strref
 	return ins + length;
 }
 
-// insert substrings by {n} notation
-strl_t _strmod_format_insert(char *string, strl_t length, strl_t cap, strl_t pos,
-							 strref format, const strref *args) {
-	// insert many things..
-
-	// can't insert at a position that is beyond the current size.
-	if (pos > length)
-		return length;
+// insert substrings by {n} notation
+strl_t _strmod_format_insert(char *string, strl_t length, strl_t cap, strl_t pos,
+							 strref format, const strref *args) {
+	// insert many things..
+
+	// can't insert at a position that is beyond the current size.
+	if (pos > length)
+		return length;
+
+	while (format) {
+		// scan for '{'
+		strl_t ins = format.find_or_full_esc('{', 0);
+		int close = format.find_after('}', ins);
+		if (close<0) {
+			ins = format.get_len();
+		}
+
+		// insert block before '{'
+		if (ins > 0) {
+			strl_t prev = length;
+			length = _strmod_insert_esc(string, length, cap, format.get_clipped(ins), pos);
+			pos += length - prev;
+			format += ins;
+		}
+
+		// if there was a {} process that..
+		if (format.get_first()=='{' && close>0) {
+			int64_t which = format.get_substr(1, close-ins).atoi();
+			strl_t prev = length;
+			length = _strmod_insert(string, length, cap, args[which], pos);
+			pos += length - prev;
+			format += close-ins+1;
+		}
+	}
+	return length;
+}
+
+// two digit decimal table
+static const char int_dec_pairs[201] =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+// number of decimal digits in v
+static inline strl_t int_dec_digits(uint64_t v)
+{
+	strl_t t = strl_t(((int_msb64(v | 1) + 1) * 1233) >> 12);
+	return t + ((v >= int_pow10_u64[t] || !v) ? 1 : 0);
+}
+
+// write decimal digits of v backwards ending at end, two at a time
+static inline void int_write_dec(char *end, uint64_t v)
+{
+	while (v >= 100) {
+		uint64_t q = v / 100;
+		memcpy(end -= 2, int_dec_pairs + (v - q * 100) * 2, 2);
+		v = q;
+	}
+	if (v >= 10)
+		memcpy(end - 2, int_dec_pairs + v * 2, 2);
+	else
+		end[-1] = char('0' + v);
+}
+
+// copy a formatted number, truncated if it doesn't fit
+static inline strl_t int_append_buf(char *str, strl_t left, const char *buf, strl_t len)
+{
+	if (len > left)
+		len = left;
+	memcpy(str, buf, len);
+	return len;
+}
+
+strl_t _strmod_append_num( char* str, strl_t left, uint32_t num, strl_t size, uint32_t radix )
+{
+	// digits right to left, if size is set the lowest size digits zero padded
+	char buf[32], *p = buf + sizeof(buf);
+	if (radix == 10) {
+		p -= int_dec_digits(num);
+		int_write_dec(buf + sizeof(buf), num);
+	} else {
+		do {
+			uint32_t v = num % radix;
+			*--p = char(v < 10 ? ('0' + v) : ('a' + v - 10));
+			num /= radix;
+		} while (num);
+	}
+	strl_t digits = strl_t(buf + sizeof(buf) - p);
+	if (!size)
+		size = digits;
+	strl_t added = 0;
+	for (; size > digits && added < left; --size)
+		str[added++] = '0';
+	if (size <= digits)
+		added += int_append_buf(str + added, left - added, buf + sizeof(buf) - size, size);
+	return added;
+}
+
+strl_t _strmod_append_uint64(char* str, strl_t left, uint64_t num)
+{
+	strl_t digits = int_dec_digits(num);
+	if (digits <= left) {
+		int_write_dec(str + digits, num);
+		return digits;
+	}
+	char buf[20];
+	int_write_dec(buf + digits, num);
+	return int_append_buf(str, left, buf, digits);
+}
+
+strl_t _strmod_append_int64(char* str, strl_t left, int64_t num)
+{
+	if (num >= 0)
+		return _strmod_append_uint64(str, left, uint64_t(num));
+	if (!left)
+		return 0;
+	*str = '-';
+	return 1 + _strmod_append_uint64(str + 1, left - 1, 0 - uint64_t(num));
+}
+
+// 8 hex characters of 32 bit x, most significant first in the lowest byte
+static inline uint64_t int_hex_chars8(uint64_t x, bool upper)
+{
+	x = (x >> 16) | ((x & 0xffff) << 32);	// spread nibbles to one per byte
+	x = ((x >> 8) & 0x000000ff000000ffULL) | ((x & 0x000000ff000000ffULL) << 16);
+	x = ((x >> 4) & 0x000f000f000f000fULL) | ((x & 0x000f000f000f000fULL) << 8);
+	uint64_t letter = ((x + 0x0606060606060606ULL) >> 4) & 0x0101010101010101ULL;
+	return x + 0x3030303030303030ULL + letter * (upper ? 7 : 39);
+}
+
+strl_t _strmod_append_hex(char* str, strl_t left, uint64_t num, strl_t digits, bool upper)
+{
+	uint8_t buf[16];
+	int_write64(buf, int_hex_chars8(num >> 32, upper));
+	int_write64(buf + 8, int_hex_chars8(num & 0xffffffff, upper));
+	if (!digits)
+		digits = num ? strl_t(int_msb64(num) / 4 + 1) : 1;
+	strl_t added = 0;
+	for (; digits > 16 && added < left; --digits)
+		str[added++] = '0';
+	if (digits <= 16)
+		added += int_append_buf(str + added, left - added, (const char*)buf + 16 - digits, digits);
+	return added;
+}
+
+// round to odd of the top 64 bits of g * cp, g is a 128 bit power of ten
+static inline uint64_t int_round_to_odd(uint64_t g1, uint64_t g0, uint64_t cp)
+{
+	uint64_t x1, y1, y0 = int_mul128(g1, cp, y1);
+	int_mul128(g0, cp, x1);
+	uint64_t z = y0 + x1;
+	y1 += z < y0 ? 1 : 0;
+	return y1 | (z > 1 ? 1 : 0);
+}
+
+// shortest s * 10^k that reads back as the double with the given mantissa and exponent bits,
+// Schubfach with the powers of ten from the parsing table. false if outside the table.
+static bool int_shortest_double(uint64_t m, int e, uint64_t &s, int &k)
+{
+	const uint64_t c = e ? (m | (1ULL << 52)) : m;
+	const int q = (e ? e : 1) - 1075;
+	const bool even = !(c & 1), closer = !m && e > 1;
+	const uint64_t cbl = 4 * c - 2 + (closer ? 1 : 0), cb = 4 * c, cbr = 4 * c + 2;
+	k = (q * 1262611 - (closer ? 524031 : 0)) >> 22;
+	if (-k < STRUSE_POW10_MIN || -k > STRUSE_POW10_MAX)
+		return false;
+	const int h = q + ((-k * 1741647) >> 19) + 1;
+	const uint64_t *pow10 = int_pow10_128[-k - STRUSE_POW10_MIN];
+	uint64_t g1 = pow10[0], g0 = pow10[1];
+	if (-k < 0 || -k > 55) {	// table is rounded down, round up unless exact
+		if (!++g0)
+			++g1;
+	}
+	const uint64_t vbl = int_round_to_odd(g1, g0, cbl << h);
+	const uint64_t vb = int_round_to_odd(g1, g0, cb << h);
+	const uint64_t vbr = int_round_to_odd(g1, g0, cbr << h);
+	const uint64_t lower = vbl + (even ? 0 : 1), upper = vbr - (even ? 0 : 1);
+	s = vb / 4;
+	if (s >= 10) {
+		uint64_t sp = s / 10;
+		bool up_inside = lower <= (40 * sp), wp_inside = (40 * sp + 40) <= upper;
+		if (up_inside != wp_inside) {
+			s = sp + (wp_inside ? 1 : 0);
+			k++;
+			return true;
+		}
+	}
+	bool u_inside = lower <= (4 * s), w_inside = (4 * s + 4) <= upper;
+	if (u_inside != w_inside) {
+		s += w_inside ? 1 : 0;
+		return true;
+	}
+	uint64_t mid = 4 * s + 2;
+	s += (vb > mid || (vb == mid && (s & 1))) ? 1 : 0;
+	return true;
+}
+
+static void int_decimal_assign(int_decimal &a, uint64_t v)
+{
+	char buf[20];
+	strl_t n = int_dec_digits(v);
+	int_write_dec(buf + n, v);
+	for (a.nd = 0; a.nd < int(n); ++a.nd)
+		a.d[a.nd] = uint8_t(buf[a.nd] - '0');
+	a.dp = a.nd;
+	a.trunc = false;
+	int_decimal_trim(a);
+}
+
+static void int_decimal_round_at(int_decimal &a, int nd, bool up)
+{
+	if (nd < 0 || nd >= a.nd)
+		return;
+	if (!up) {
+		a.nd = nd;
+		int_decimal_trim(a);
+		return;
+	}
+	for (int i = nd - 1; i >= 0; --i) {
+		if (a.d[i] < 9) {
+			a.d[i]++;
+			a.nd = i + 1;
+			return;
+		}
+	}
+	a.d[0] = 1;	// all nines
+	a.nd = 1;
+	a.dp++;
+}
+
+// shortest decimal for doubles outside the table, exact decimal of the value
+// and both rounding boundaries compared digit by digit
+static void int_shortest_double_slow(uint64_t m, int e, uint64_t &s, int &k)
+{
+	const int minexp = -1022;
+	uint64_t mant = e ? (m | (1ULL << 52)) : m;
+	int exp = e ? (e - 1023) : minexp;
+	int_decimal d, upper, lower;
+	int_decimal_assign(d, mant);
+	int_decimal_shift(d, exp - 52);
+	if (exp <= minexp || 332 * (d.dp - d.nd) < 100 * (exp - 52)) {
+		int_decimal_assign(upper, mant * 2 + 1);
+		int_decimal_shift(upper, exp - 52 - 1);
+		bool lo_half = mant > (1ULL << 52) || exp == minexp;
+		int_decimal_assign(lower, lo_half ? (mant * 2 - 1) : (mant * 4 - 1));
+		int_decimal_shift(lower, (lo_half ? exp : (exp - 1)) - 52 - 1);
+		const bool inclusive = !(mant & 1);
+		int upperdelta = 0;
+		for (int ui = 0; ; ++ui) {
+			int mi = ui - upper.dp + d.dp;
+			if (mi >= d.nd)
+				break;
+			int li = ui - upper.dp + lower.dp;
+			uint8_t l = (li >= 0 && li < lower.nd) ? lower.d[li] : 0;
+			uint8_t md = mi >= 0 ? d.d[mi] : 0;
+			uint8_t u = ui < upper.nd ? upper.d[ui] : 0;
+			bool okdown = l != md || (inclusive && (li + 1) == lower.nd);
+			if (!upperdelta && (md + 1) < u)
+				upperdelta = 2;
+			else if (!upperdelta && md != u)
+				upperdelta = 1;
+			else if (upperdelta == 1 && (md != 9 || u != 0))
+				upperdelta = 2;
+			bool okup = upperdelta && (inclusive || upperdelta > 1 || (ui + 1) < upper.nd);
+			if (okdown || okup) {
+				int_decimal_round_at(d, mi + 1, okdown && okup ? int_decimal_round_up(d, mi + 1) : okup);
+				break;
+			}
+		}
+	}
+	s = 0;
+	for (int i = 0; i < d.nd; ++i)
+		s = s * 10 + d.d[i];
+	k = d.dp - d.nd;
+}
+
+// write the decimal s * 10^k, integers and moderate exponents are written without exponent
+static strl_t int_write_shortest(char *o, uint64_t s, int k)
+{
+	char *start = o;
+	while (s >= 10 && !(s % 10)) {
+		s /= 10;
+		k++;
+	}
+	char dig[20];
+	const int n = int(int_dec_digits(s));
+	int_write_dec(dig + n, s);
+	const int dp = n + k;	// position of decimal point relative to first digit
+	if (dp >= n && dp <= 21) {
+		memcpy(o, dig, n);
+		memset(o + n, '0', dp - n);
+		o += dp;
+	} else if (dp > 0 && dp <= 21) {
+		memcpy(o, dig, dp);
+		o[dp] = '.';
+		memcpy(o + dp + 1, dig + dp, n - dp);
+		o += n + 1;
+	} else if (dp > -6 && dp <= 0) {
+		*o++ = '0';
+		*o++ = '.';
+		memset(o, '0', -dp);
+		memcpy(o - dp, dig, n);
+		o += n - dp;
+	} else {
+		*o++ = dig[0];
+		if (n > 1) {
+			*o++ = '.';
+			memcpy(o, dig + 1, n - 1);
+			o += n - 1;
+		}
+		int x = dp - 1;
+		*o++ = 'e';
+		*o++ = x < 0 ? '-' : '+';
+		x = x < 0 ? -x : x;
+		char xd[4];
+		strl_t xn = int_dec_digits(uint64_t(x));
+		int_write_dec(xd + xn, uint64_t(x));
+		memcpy(o, xd, xn);
+		o += xn;
+	}
+	return strl_t(o - start);
+}
+
+// shortest round trip double, integers and moderate exponents are written without exponent
+strl_t _strmod_append_double(char* str, strl_t left, double num)
+{
+	uint64_t bits;
+	memcpy(&bits, &num, sizeof(bits));
+	char buf[32], *o = buf;
+	if (bits >> 63)
+		*o++ = '-';
+	const uint64_t m = bits & ((1ULL << 52) - 1);
+	const int e = int(bits >> 52) & 0x7ff;
+	if (e == 0x7ff) {
+		memcpy(m ? buf : o, m ? "nan" : "inf", 3);
+		return int_append_buf(str, left, buf, strl_t((m ? buf : o) - buf) + 3);
+	}
+	if (!e && !m) {
+		*o++ = '0';
+		return int_append_buf(str, left, buf, strl_t(o - buf));
+	}
+	uint64_t s;
+	int k;
+	if (!int_shortest_double(m, e, s, k))
+		int_shortest_double_slow(m, e, s, k);
+	o += int_write_shortest(o, s, k);
+	return int_append_buf(str, left, buf, strl_t(o - buf));
+}
+
+// shortest round trip float, the exact value is rounded to more digits until it reads back the same
+strl_t _strmod_append_float(char* str, strl_t left, float num)
+{
+	double d = num;
+	uint64_t bits;
+	memcpy(&bits, &d, sizeof(bits));
+	const uint64_t m = bits & ((1ULL << 52) - 1);
+	const int e = int(bits >> 52) & 0x7ff;
+	if (e == 0x7ff || (!e && !m))
+		return _strmod_append_double(str, left, d);
+	char buf[32], *o = buf;
+	if (bits >> 63)
+		*o++ = '-';
+
+	// floats are normal doubles, 9 digits always read back the same
+	int_decimal x, r;
+	int_decimal_assign(x, m | (1ULL << 52));
+	int_decimal_shift(x, e - 1023 - 52);
+	float mag = num < 0 ? -num : num, back;
+	strl_t n = 0;
+	for (int nd = 1; nd <= 9; ++nd) {
+		r = x;
+		int_decimal_round_at(r, nd, int_decimal_round_up(r, nd));
+		uint64_t s = 0;
+		for (int i = 0; i < r.nd; ++i)
+			s = s * 10 + r.d[i];
+		n = int_write_shortest(o, s, r.dp - r.nd);
+		if (nd == 9 || nd >= x.nd || (strref(o, n).parse_float(back) == n && back == mag))
+			break;
+	}
+	return int_append_buf(str, left, buf, strl_t(o - buf) + n);
+}
+
+// parse the inside of {n:spec}, an argument index optionally followed by [x|X][0][width]
+static void int_format_spec(const uint8_t *f, const uint8_t *close, strformat_seg &seg)
+{
+	uint32_t arg = 0, width = 0;
+	for (; f < close && *f>='0' && *f<='9'; f++) {
+		if (arg < 0x8000)
+			arg = arg * 10 + *f - '0';
+	}
+	seg.arg = int16_t(arg < 0x7fff ? arg : 0x7fff);
+	seg.hex = 0;
+	seg.zero = false;
+	if (f < close && *f == ':') {
+		f++;
+		if (f < close && (*f == 'x' || *f == 'X'))
+			seg.hex = char(*f++);
+		if (f < close && *f == '0') {
+			seg.zero = true;
+			f++;
+		}
+		for (; f < close && *f>='0' && *f<='9'; f++) {
+			if (width < 0x10000)
+				width = width * 10 + *f - '0';
+		}
+	}
+	seg.width = uint16_t(width < 0xffff ? width : 0xffff);
+}
+
+// copy format text converting escape codes
+static strl_t int_format_text(char *str, strl_t left, const uint8_t *f, const uint8_t *e)
+{
+	char *o = str, *end = str + left;
+	while (f < e && o < end) {
+		uint8_t c = *f++;
+		if (c == '\\' && f < e)
+			f += int_get_esc_code(f, strl_t(e - f), c);
+		*o++ = (char)c;
+	}
+	return strl_t(o - str);
+}
 
-	while (format) {
-		// scan for '{'
-		strl_t ins = format.find_or_full_esc('{', 0);
-		int close = format.find_after('}', ins);
-		if (close<0) {
-			ins = format.get_len();
+// write one format argument with the width and hex options, missing arguments write nothing
+static strl_t int_format_arg(char *str, strl_t left, const strformat_arg *args, int count, const strformat_seg &spec)
+{
+	if (!left || spec.arg < 0 || spec.arg >= count)
+		return 0;
+	const strformat_arg &a = args[spec.arg];
+	char buf[32];
+	const char *src = buf;
+	strl_t n;
+	switch (a.type) {
+		case SFA_STRING:
+			src = a.str;
+			n = a.len;
+			break;
+		case SFA_CHAR:
+			buf[0] = char(a.i);
+			n = 1;
+			break;
+		case SFA_DOUBLE:
+			n = _strmod_append_double(buf, sizeof(buf), a.d);
+			break;
+		case SFA_FLOAT:
+			n = _strmod_append_float(buf, sizeof(buf), float(a.d));
+			break;
+		default:
+			if (spec.hex)
+				n = _strmod_append_hex(buf, sizeof(buf), a.u, 0, spec.hex == 'X');
+			else if (a.type == SFA_INT)
+				n = _strmod_append_int64(buf, sizeof(buf), a.i);
+			else
+				n = _strmod_append_uint64(buf, sizeof(buf), a.u);
+			break;
+	}
+	bool number = a.type >= SFA_INT;
+	strl_t added = 0;
+	if (number && n < spec.width) {
+		// right align numbers, zeros go after the sign
+		strl_t pad = spec.width - n;
+		if (spec.zero && *src == '-') {
+			if (added < left)
+				str[added++] = '-';
+			src++;
+			n--;
 		}
+		strl_t room = left > added ? left - added : 0;
+		if (pad > room)
+			pad = room;
+		memset(str + added, spec.zero ? '0' : ' ', pad);
+		added += pad;
+	}
+	if (n && added < left)
+		added += int_append_buf(str + added, left - added, src, n);
+	if (!number && added < spec.width) {
+		// left align strings and characters
+		strl_t pad = spec.width - added;
+		if (pad > left - added)
+			pad = left - added;
+		memset(str + added, ' ', pad);
+		added += pad;
+	}
+	return added;
+}
 
-		// insert block before '{'
-		if (ins > 0) {
-			strl_t prev = length;
-			length = _strmod_insert_esc(string, length, cap, format.get_clipped(ins), pos);
-			pos += length - prev;
-			format += ins;
+// scan a {n} format into literal text and argument segments
+bool strformat::set(const strref format)
+{
+	count = 0;
+	const uint8_t *f = format.get_u(), *e = f + format.get_len(), *text = f;
+	bool esc = false;
+	while (f < e) {
+		uint8_t c = *f++;
+		if (c == '\\' && f < e) {
+			f += int_get_esc_code(f, strl_t(e - f), c);
+			esc = true;
+		} else if (c == '{') {
+			const uint8_t *close = (const uint8_t*)memchr(f, '}', size_t(e - f));
+			if (close) {
+				if (count == MAX_FORMAT_SEGMENTS)
+					return false;
+				strformat_seg &seg = segs[count++];
+				seg.text = strref((const char*)text, strl_t(f - 1 - text));
+				seg.esc = esc;
+				int_format_spec(f, close, seg);
+				f = text = close + 1;
+				esc = false;
+			}
 		}
+	}
+	if (text < e) {
+		if (count == MAX_FORMAT_SEGMENTS)
+			return false;
+		strformat_seg &seg = segs[count++];
+		seg.text = strref((const char*)text, strl_t(e - text));
+		seg.esc = esc;
+		seg.arg = -1;
+		seg.width = 0;
+		seg.hex = 0;
+		seg.zero = false;
+	}
+	return true;
+}
 
-		// if there was a {} process that..
-		if (format.get_first()=='{' && close>0) {
-			int64_t which = format.get_substr(1, close-ins).atoi();
-			strl_t prev = length;
-			length = _strmod_insert(string, length, cap, args[which], pos);
-			pos += length - prev;
-			format += close-ins+1;
+// append a {n} format with typed arguments, scanning the format as it is written
+strl_t _strmod_format_append(char *string, strl_t length, strl_t cap, strref format,
+							 const strformat_arg *args, int count)
+{
+	if (length >= cap)
+		return length;
+	char *o = string + length, *end = string + cap;
+	const uint8_t *f = format.get_u(), *e = f + format.get_len();
+	strformat_seg spec;
+	while (f < e && o < end) {
+		uint8_t c = *f++;
+		if (c == '\\' && f < e)
+			f += int_get_esc_code(f, strl_t(e - f), c);
+		else if (c == '{') {
+			const uint8_t *close = (const uint8_t*)memchr(f, '}', size_t(e - f));
+			if (close) {
+				int_format_spec(f, close, spec);
+				o += int_format_arg(o, strl_t(end - o), args, count, spec);
+				f = close + 1;
+				continue;
+			}
 		}
+		*o++ = (char)c;
 	}
-	return length;
+	return strl_t(o - string);
 }
 
-strl_t _strmod_append_num( char* str, strl_t left, uint32_t num, strl_t size, uint32_t radix )
+// append a compiled format with typed arguments
+strl_t _strmod_format_append(char *string, strl_t length, strl_t cap, const strformat &format,
+							 const strformat_arg *args, int count)
 {
-	strl_t div = 1;
-	if( !size ) {
-		uint32_t mul = 1;
-		do { ++size; mul *= radix; } while( mul <= num );
-	}
-	for( strl_t n = 1; n<size; ++n ) { div *= radix; }
-	strl_t added = 0;
-	for( strl_t a = 0; a<size && left; ++a ) {
-		char v = (num / div) % radix + '0';
-		div /= radix;
-		*str++ = v <= '9' ? v : (v + 'a' - '0' - 10);
-		--left;
-		++added;
+	if (length >= cap)
+		return length;
+	char *o = string + length;
+	strl_t left = cap - length;
+	for (int s = 0, n = format.segments(); s < n && left; s++) {
+		const strformat_seg &seg = format.segment(s);
+		strl_t w = 0;
+		if (seg.esc)
+			w = int_format_text(o, left, seg.text.get_u(), seg.text.get_u() + seg.text.get_len());
+		else if (seg.text)
+			w = int_append_buf(o, left, seg.text.get(), seg.text.get_len());
+		o += w;
+		left -= w;
+		if (!left)
+			break;
+		w = int_format_arg(o, left, args, count, seg);
+		o += w;
+		left -= w;
 	}
-	return added;
+	return cap - left;
 }
 
 // remove all instances of a character from a string
 strl_t _strmod_remove(char *string, strl_t length, char a)
 {
-	char *scan = string;
-	strl_t left = length;
-	while (left && *scan!=a) {
-		left--;
-		scan++;
+	uint8_t *w = (uint8_t*)memchr(string, a, length);
+	if (!w)
+		return length;
+	const uint8_t *r = w, *e = (const uint8_t*)string + length;
+	uint8_t c = (uint8_t)a;
+#ifdef STRUSE_V16
+	int_v16 vc = int_v16_set1(c);
+	while ((e - r)>=16) {
+		int_v16 v = int_v16_load(r);
+		w += int_v16_compact(w, v, int_v16_mask(int_v16_eq(v, vc)));
+		r += 16;
 	}
-	if (left) {
-		strl_t n = left;
-		char *write = scan;
-		while (left) {
-			while (left && *scan==a) {
-				left--;
-				scan++;
-			}
-			while (left && *scan!=a) {
-				*write++ = *scan++;
-				left--;
-				n--;
-			}
-		}
-		length -= n;
+#endif
+	for (; r<e; ++r) {
+		*w = *r;
+		w += *r!=c;
 	}
-	return length;
+	return strl_t(w - (uint8_t*)string);
+}
+
+// remove all characters that are in range (or not in range) from a string
+strl_t _strmod_remove(char *string, strl_t length, const strrange &range, bool in_range)
+{
+	return range.remove((uint8_t*)string, length, in_range);
 }
 
 // remove a substring from a string
@@ -4726,13 +8812,9 @@ strl_t _strmod_remove(char *string, strl_t length, strl_t start, strl_t len)
 	if (start<length) {
 		if ((start+len)>length)
 			len = length-start;
-		int left = int(length-start-len);
-		if (left>0) {
-			const char *source = string+start+len;
-			char *dest = string+start;
-			for (int i = left; i; i--)
-				*dest++ = *source++;
-		}
+		strl_t left = length-start-len;
+		if (left)
+			memmove(string+start, string+start+len, left);
 		length = length-len;
 	}
 	return length;
@@ -4756,11 +8838,7 @@ strl_t _strmod_exchange(char *string, strl_t length, strl_t cap, strl_t start, s
         length = _strmod_remove(string, length, start+size-rem, rem);
     } else if (copy > size) {
         strl_t ins = insert.get_len() - size;
-        strl_t left = length - size - start;
-        char *end = string + length + ins;
-        char *orig = string + length;
-        while (left--)
-            *--end = *--orig;
+        memmove(string + start + insert.get_len(), string + start + size, length - size - start);
         length += ins;
     }
     memcpy(string + start, insert.get(), copy);
@@ -4795,40 +8873,298 @@ strl_t _strmod_inplace_replace_int(char *string, strl_t length, strl_t cap, cons
 					while (r--)
 						*pd++ = *po++;
 				}
-				if (ps!=pd && sl) {
-					int r = sl;
-					while (r--)
-						*pd++ = *ps++;
-				}
+				memmove(pd, ps, sl);
+				pd += sl;
+				ps += sl;
 				ss += (int)len_a+sl;
 			}
 			return strl_t(pd-scan);
 		}
-	} else if (int cnt = strref(scan, left).substr_count(a)) {
+	} else {
+		// count matches the same way they are replaced
+		strl_t cnt = 0, first = 0;
+		for (strl_t o = 0; (o+len_a)<=left; cnt++) {
+			int f = strref(scan+o, left-o).find(a);
+			if (f<0)
+				break;
+			if (!cnt)
+				first = o + f;
+			o += f + len_a;
+		}
+		if (!cnt)
+			return left;
 		strl_t nl = cnt * (len_b-len_a) + left;	// new length
 		if (nl>c)
 			return left;	// didn't fit in space
-		int ss = strref(scan, left).find_last(a);
-		int se = (int)left;
-		pd += nl;
-		ps += left;
-		while (ss>=0) {
-			strl_t cp = se-ss-len_a;
-			while (cp--)
-				*--pd = *--ps;
-			ps -= len_a;
-			const char *be = b.get()+len_b;
-			cp = len_b;
-			while (cp--)
-				*--pd = *--be;
-			se = ss;
-			ss = strref(scan, se).find_last(a);
+
+		// move the text from the first match to the end of the new length once, replacing
+		// forward from there the output never catches up with the unread input
+		const char *pe = scan + nl;
+		ps = scan + nl - (left - first);
+		pd = scan + first;
+		memmove(ps, pd, left - first);
+		while (ps<pe) {
+			memcpy(pd, b.get(), len_b);
+			pd += len_b;
+			ps += len_a;
+			int sl = strref(ps, strl_t(pe-ps)).find(a);
+			strl_t cp = sl<0 ? strl_t(pe-ps) : strl_t(sl);
+			memmove(pd, ps, cp);
+			pd += cp;
+			ps += cp;
 		}
 		return nl;
 	}
 	return left;
 }
 
+// compile a table of (from, to) pairs for replace_many
+bool strreplace::set(const strref *f, const strref *t, int pairs)
+{
+	memset(head, 0xff, sizeof(head));
+	count = 0;
+	char firsts[2 * MAX_REPLACE_PAIRS];
+	strl_t num_firsts = 0;
+	bool all = pairs<=MAX_REPLACE_PAIRS;
+	for (int i = 0; i<pairs && count<MAX_REPLACE_PAIRS; ++i) {
+		if (!f[i].get_len()) {
+			all = false;
+			continue;
+		}
+		from[count] = f[i];
+		to[count] = t[i];
+		strl_t l = f[i].get_len();
+		uint8_t pre[8] = {};
+		memcpy(pre, f[i].get(), l<8 ? l : 8);
+		prefix[count] = int_read64(pre, true);
+		prefix_mask[count] = l>=8 ? ~0ULL : ((1ULL<<(8*l))-1);
+
+		// insert after longer or equal pairs with the same first character
+		uint8_t c = int_tolower_ascii7((uint8_t)f[i].get_first());
+		if (head[c]==0xff) {
+			firsts[num_firsts++] = (char)c;
+			if (int_toupper_ascii7(c)!=c)
+				firsts[num_firsts++] = (char)int_toupper_ascii7(c);
+		}
+		uint8_t *link = &head[c];
+		while (*link!=0xff && from[*link].get_len()>=l)
+			link = &next[*link];
+		next[count] = *link;
+		*link = (uint8_t)count;
+		count++;
+	}
+	first.set_chars(strref(firsts, num_firsts));
+	return all;
+}
+
+// position of the next match at or after pos and its pair, or -1 if none
+int strreplace::find(const strref str, strl_t pos, int &pair) const
+{
+	const uint8_t *s = str.get_u();
+	strl_t length = str.get_len();
+	while (pos<length) {
+		pos += first.scan(s + pos, length - pos, true);
+		if (pos>=length)
+			break;
+		// compare 8 characters at once first when there are enough left
+		bool quick = (length-pos)>=8;
+		uint64_t x = quick ? int_read64(s + pos, true) : 0;
+		for (uint8_t i = head[int_tolower_ascii7(s[pos])]; i!=0xff; i = next[i]) {
+			strl_t l = from[i].get_len();
+			if (l>(length-pos))
+				continue;
+			if (quick ? ((x & prefix_mask[i])==prefix[i] && (l<=8 || int_same_substr(s + pos + 8, from[i].get_u() + 8, l - 8, true))) :
+				int_same_substr(s + pos, from[i].get_u(), l, true)) {
+				pair = i;
+				return int(pos);
+			}
+		}
+		pos++;
+	}
+	return -1;
+}
+
+// replace all occurrences of several strings in one pass
+strl_t _strmod_inplace_replace_many_int(char *string, strl_t length, strl_t cap, const strreplace &table)
+{
+	int pair;
+	int m = table.find(strref(string, length), 0, pair);
+	if (m<0)
+		return length;
+
+	// new length and the most the output gets ahead of the input
+	strl_t first = strl_t(m), nl = length, ahead = 0;
+	while (m>=0) {
+		nl = nl + table.get_to(pair).get_len() - table.get_from(pair).get_len();
+		if (nl>length && (nl-length)>ahead)
+			ahead = nl - length;
+		m = table.find(strref(string, length), strl_t(m) + table.get_from(pair).get_len(), pair);
+	}
+	if (nl>cap || (length+ahead)>cap)
+		return length;
+
+	// move the text from the first match forward by that much once, then replace
+	// forward from where the first match was
+	strl_t rest = length - first;
+	char *ps = string + first + ahead, *pd = string + first;
+	const char *pe = ps + rest;
+	if (ahead)
+		memmove(ps, pd, rest);
+	for (;;) {
+		m = table.find(strref(ps, strl_t(pe - ps)), 0, pair);
+		strl_t cp = m<0 ? strl_t(pe - ps) : strl_t(m);
+		memmove(pd, ps, cp);
+		pd += cp;
+		ps += cp;
+		if (m<0)
+			break;
+		const strref &t = table.get_to(pair);
+		memcpy(pd, t.get(), t.get_len());
+		pd += t.get_len();
+		ps += table.get_from(pair).get_len();
+	}
+	return nl;
+}
+
+// move the gap of a gap buffer string to pos
+void strgap::move_gap(strl_t pos)
+{
+	if (pos>len())
+		pos = len();
+	if (pos<gap_start) {
+		strl_t move = gap_start - pos;
+		memmove(string_ptr + gap_end - move, string_ptr + pos, move);
+		gap_start -= move;
+		gap_end -= move;
+	} else if (pos>gap_start) {
+		strl_t move = pos - gap_start;
+		memmove(string_ptr + gap_start, string_ptr + gap_end, move);
+		gap_start += move;
+		gap_end += move;
+	}
+}
+
+// insert a substring into a gap buffer string
+bool strgap::insert(const strref sub, strl_t pos)
+{
+	strl_t l = sub.get_len();
+	if (pos>len() || l>(gap_end - gap_start))
+		return false;
+	move_gap(pos);
+	if (l)
+		memcpy(string_ptr + gap_start, sub.get(), l);
+	gap_start += l;
+	return true;
+}
+
+// remove a portion of a gap buffer string
+void strgap::remove(strl_t start, strl_t length)
+{
+	strl_t l = len();
+	if (start<l) {
+		if (length>(l - start))
+			length = l - start;
+		move_gap(start);
+		gap_end += length;
+	}
+}
+
+// exchange a substring of a gap buffer string
+bool strgap::exchange(strl_t pos, strl_t size, const strref insert)
+{
+	strl_t l = len();
+	if (pos>l)
+		return false;
+	if (size>(l - pos))
+		size = l - pos;
+	strl_t n = insert.get_len();
+	if (n>(gap_end - gap_start + size))
+		return false;
+	move_gap(pos);
+	gap_end += size;
+	if (n)
+		memcpy(string_ptr + gap_start, insert.get(), n);
+	gap_start += n;
+	return true;
+}
+
+// queue an edit against the original text
+bool stredit::exchange(strl_t pos, strl_t size, const strref insert)
+{
+	if (count>=max_ops)
+		return false;
+	const char *t = insert.get();
+	strl_t l = insert.get_len();
+	if (text && l) {
+		if ((text_cap-text_len)<l)
+			return false;
+		memcpy(text + text_len, t, l);
+		t = text + text_len;
+		text_len += l;
+	}
+	stredit_op &op = ops[count++];
+	op.pos = pos;
+	op.size = size;
+	op.text = t;
+	op.len = l;
+	return true;
+}
+
+// apply all queued edits in one forward pass
+bool stredit::apply(char *string, strl_t &length, strl_t cap)
+{
+	// stable insertion sort by position, edits are usually queued in order
+	for (int i = 1; i<count; ++i) {
+		stredit_op op = ops[i];
+		int j = i;
+		for (; j && ops[j-1].pos>op.pos; --j)
+			ops[j] = ops[j-1];
+		ops[j] = op;
+	}
+
+	// new length and the most the output gets ahead of the input
+	strl_t nl = length, ahead = 0, end = 0;
+	int num = 0;
+	for (int i = 0; i<count; ++i) {
+		stredit_op &op = ops[i];
+		if (op.pos>length)
+			break;
+		if (op.pos<end)
+			return false;
+		if (op.size>(length-op.pos))
+			op.size = length-op.pos;
+		end = op.pos + op.size;
+		nl = nl + op.len - op.size;
+		if (nl>length && (nl-length)>ahead)
+			ahead = nl - length;
+		num = i + 1;
+	}
+	if (nl>cap || (length+ahead)>cap)
+		return false;
+
+	// move the text from the first edit forward by that much once, then edit forward
+	if (num) {
+		strl_t first = ops[0].pos, rest = length - first;
+		char *ps = string + first + ahead, *pd = string + first;
+		if (ahead)
+			memmove(ps, pd, rest);
+		for (int i = 0; i<num; ++i) {
+			const stredit_op &op = ops[i];
+			strl_t cp = strl_t((string + op.pos + ahead) - ps);
+			memmove(pd, ps, cp);
+			pd += cp;
+			ps += cp + op.size;
+			if (op.len)
+				memcpy(pd, op.text, op.len);
+			pd += op.len;
+		}
+		memmove(pd, ps, strl_t((string + length + ahead) - ps));
+	}
+	length = nl;
+	clear();
+	return true;
+}
+
 // search and replace occurences of a string within a string
 strl_t _strmod_inplace_replace_bookend_int(char *string, strl_t length, strl_t cap, const strref a, const strref b, const strref bookend)
 {
@@ -4897,101 +9233,153 @@ strl_t _strmod_inplace_replace_bookend_int(char *string, strl_t length, strl_t c
 	return left;
 }
 
-// convert a string to lowercase (7 bit ascii)
-void _strmod_tolower(char *string, strl_t length)
+#ifdef STRUSE_AVX2
+// flip the case of letters from first to first+25 in 32 characters
+static inline __m256i int_change_case_avx2(__m256i v, __m256i first)
 {
-	if (string) {
-		uint8_t *s = (uint8_t*)string;
-		for (strl_t left = length; left>0; left--) {
-			*s = int_tolower_ascii7(*s);
-			s++;
+	__m256i t = _mm256_sub_epi8(v, first);
+	__m256i letter = _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8('Z'-'A')), t);
+	return _mm256_xor_si256(v, _mm256_and_si256(letter, _mm256_set1_epi8(0x20)));
+}
+#endif
+
+#ifdef STRUSE_V16
+// flip the case of letters from first to first+25 in 16 characters
+static inline int_v16 int_change_case_v16(int_v16 v, int_v16 first)
+{
+	int_v16 t = int_v16_sub(v, first);
+	int_v16 letter = int_v16_eq(int_v16_min(t, int_v16_set1('Z'-'A')), t);
+	return int_v16_xor(v, int_v16_and(letter, int_v16_set1(0x20)));
+}
+#endif
+
+// flip the case of letters from first to first+25 in 8 ascii7 characters
+static inline uint64_t int_change_case_swar(uint64_t x, uint8_t first)
+{
+	const uint64_t ones = 0x0101010101010101ULL;
+	uint64_t h = x & (0x7f*ones);
+	uint64_t letter = ((h + (0x80-first)*ones) ^ (h + (0x7f-(first+'Z'-'A'))*ones)) & ~x & (0x80*ones);
+	return x ^ (letter>>2);
+}
+
+// change the case of ascii7 letters a vector at a time, lowercase if first is 'A' and
+// uppercase if first is 'a'. Characters from 0x80 are translated through table if one
+// is given, only blocks that contain them are visited a character at a time.
+static void int_change_case(uint8_t *s, strl_t length, uint8_t first, const uint8_t *table)
+{
+	strl_t o = 0;
+#ifdef STRUSE_AVX2
+	__m256i f32 = _mm256_set1_epi8((char)first);
+#endif
+#ifdef STRUSE_V16
+	int_v16 f = int_v16_set1(first);
+#endif
+	if (!table) {
+#ifdef STRUSE_AVX2
+		for (; (o+64)<=length; o += 64) {
+			__m256i v0 = _mm256_loadu_si256((const __m256i*)(s + o)), v1 = _mm256_loadu_si256((const __m256i*)(s + o + 32));
+			_mm256_storeu_si256((__m256i*)(s + o), int_change_case_avx2(v0, f32));
+			_mm256_storeu_si256((__m256i*)(s + o + 32), int_change_case_avx2(v1, f32));
+		}
+		for (; (o+32)<=length; o += 32)
+			_mm256_storeu_si256((__m256i*)(s + o), int_change_case_avx2(_mm256_loadu_si256((const __m256i*)(s + o)), f32));
+#endif
+#ifdef STRUSE_V16
+		for (; (o+16)<=length; o += 16)
+			int_v16_store(s + o, int_change_case_v16(int_v16_load(s + o), f));
+#endif
+		// branchless so compilers can vectorize it without STRUSE_V16
+		for (; o<length; o++)
+			s[o] ^= uint8_t((uint8_t(s[o]-first)<=('Z'-'A')) << 5);
+		return;
+	}
+#ifdef STRUSE_AVX2
+	for (; (o+32)<=length; o += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)(s + o));
+		_mm256_storeu_si256((__m256i*)(s + o), int_change_case_avx2(v, f32));
+		for (uint32_t high = (uint32_t)_mm256_movemask_epi8(v); high; high &= high-1) {
+			uint8_t *c = s + o + int_ctz32(high);
+			*c = table[*c];
+		}
+	}
+#endif
+#ifdef STRUSE_V16
+	int_v16 ascii = int_v16_set1(0x7f);
+	for (; (o+16)<=length; o += 16) {
+		int_v16 v = int_v16_load(s + o);
+		int_v16_store(s + o, int_change_case_v16(v, f));
+		for (uint32_t high = int_v16_mask(int_v16_eq(int_v16_min(v, ascii), v)) ^ 0xffff; high; high &= high-1) {
+			uint8_t *c = s + o + int_ctz32(high);
+			*c = table[*c];
 		}
 	}
+#endif
+	for (; (o+8)<=length; o += 8) {
+		uint64_t x = int_read64(s + o, false);
+		int_write64(s + o, int_change_case_swar(x, first));
+		for (uint64_t high = x & 0x8080808080808080ULL; high; high &= high-1) {
+			uint8_t *c = s + o + (int_ctz64(high)>>3);
+			*c = table[*c];
+		}
+	}
+	for (; o<length; o++)
+		s[o] = table[s[o]];
+}
+
+// convert a string to lowercase (7 bit ascii)
+void _strmod_tolower(char *string, strl_t length)
+{
+	if (string)
+		int_change_case((uint8_t*)string, length, 'A', nullptr);
 }
 
 // convert a string to lowercase (windows extended ascii)
 void _strmod_tolower_win_ascii(char *string, strl_t length)
 {
-	if (string) {
-		uint8_t *s = (uint8_t*)string;
-		for (strl_t left = length; left>0; left--) {
-			*s = int_tolower_win_ascii(*s);
-			s++;
-		}
-	}
+	if (string)
+		int_change_case((uint8_t*)string, length, 'A', _aWinAscii_ToLower);
 }
 
 // convert a string to lowercase (amiga extended ascii)
 void _strmod_tolower_amiga_ascii(char *string, strl_t length)
 {
-	if (string) {
-		uint8_t *scan = (uint8_t*)string;
-		for (strl_t left = length; left>0; left--) {
-			*scan = int_tolower_amiga_ascii(*scan);
-			scan++;
-		}
-	}
+	if (string)
+		int_change_case((uint8_t*)string, length, 'A', _aAmigaAscii_ToLower);
 }
 
 // convert a string to lowercase (mac os extended ascii)
 void _strmod_tolower_macos_ascii(char *string, strl_t length)
 {
-	if (string) {
-		uint8_t *scan = (uint8_t*)string;
-		for (strl_t r = length; r>0; r--) {
-			*scan = int_tolower_macos_roman_ascii(*scan);
-			scan++;
-		}
-	}
+	if (string)
+		int_change_case((uint8_t*)string, length, 'A', _aMacOSRoman_ToLower);
 }
 
 // convert a string to uppercase
 void _strmod_toupper(char *string, strl_t length)
 {
-	if (string) {
-		uint8_t *scan = (uint8_t*)string;
-		for (strl_t left = length; left>0; left--) {
-			*scan = int_toupper_ascii7(*scan);
-			scan++;
-		}
-	}
+	if (string)
+		int_change_case((uint8_t*)string, length, 'a', nullptr);
 }
 
 // convert a string to uppercase
 void _strmod_toupper_win_ascii(char *string, strl_t length)
 {
-	if (string) {
-		uint8_t *scan = (uint8_t*)string;
-		for (strl_t left = length; left>0; left--) {
-			*scan = int_toupper_win_ascii(*scan);
-			scan++;
-		}
-	}
+	if (string)
+		int_change_case((uint8_t*)string, length, 'a', _aWinAscii_ToUpper);
 }
 
 // convert a string to uppercase
 void _strmod_toupper_amiga_ascii(char *string, strl_t length)
 {
-	if (string) {
-		uint8_t *scan = (uint8_t*)string;
-		for (strl_t left = length; left>0; left--) {
-			*scan = int_toupper_amiga_ascii(*scan);
-			scan++;
-		}
-	}
+	if (string)
+		int_change_case((uint8_t*)string, length, 'a', _aAmigaAscii_ToUpper);
 }
 
-
 // convert a string to uppercase
 void _strmod_toupper_macos_ascii(char *string, strl_t length)
 {
-	if (string) {
-		uint8_t *scan = (uint8_t*)string;
-		for (strl_t left = length; left>0; left--) {
-			*scan = int_toupper_macos_roman_ascii(*scan);
-			scan++;
-		}
-	}
+	if (string)
+		int_change_case((uint8_t*)string, length, 'a', _aMacOSRoman_ToUpper);
 }
 
 strl_t _strmod_copy(char *string, strl_t cap, const char *str)
@@ -5072,19 +9460,7 @@ size_t _strmod_read_utf8(char *string, strl_t length, strl_t pos, strl_t &skip)
 		skip = 0;
 		return 0;
 	}
-
-	string += pos;
-	length -= pos;
-	const char *start = string;
-	const char *end = string + length;
-	size_t c = (size_t)*string++;
-	c &= 0x7f;
-	for (size_t m = 0x40; (m & c) && string<end; m <<= 5) {
-		size_t n = (size_t)*string++;
-		c = ((c & ~m) << 6) | (n & 0x3f);
-	}
-	skip = strl_t(string - start);
-	return c;
+	return int_read_utf8((const uint8_t*)string + pos, (const uint8_t*)string + length, skip);
 }
 
 strl_t _strmod_write_utf8(char *string, strl_t cap, size_t code, strl_t pos) {
@@ -5114,68 +9490,160 @@ strl_t _strmod_write_utf8(char *string, strl_t cap, size_t code, strl_t pos) {
 	return 0;
 }
 
-strl_t _strmod_utf8_tolower(char *string, strl_t length, strl_t cap) {
-	char *scan = string;
-	char *write = string;
-	char *end = string + length;
-
-	while (scan<end) {
-		// get one character
-		strl_t skip;
-		size_t c = _strmod_read_utf8(scan, strl_t(end-scan), 0, skip);
-		scan += skip;
-
-		c = int_tolower_unicode(c);
-
-		strl_t add = c<size_t(0x80) ? strl_t(1) : (c<size_t(0x800) ? strl_t(2) : (c<size_t(0x10000) ? strl_t(3) : 4));
-
-		if (add > cap)
-			return (strl_t)(write-string);
+// case map one utf8 character from 0x80 up, returns the new code or 0 if unchanged. Sets
+// skip to the bytes read and add to the bytes written, other bytes are kept one at a time.
+static inline size_t int_utf8_case_char(const uint8_t *s, const uint8_t *e, bool upper, strl_t &skip, strl_t &add)
+{
+	if (!int_utf8_valid_len(s, e)) {
+		skip = add = 1;
+		return 0;
+	}
+	size_t c = int_read_utf8(s, e, skip);
+	size_t m = upper ? int_toupper_unicode(c) : int_tolower_unicode(c);
+	add = m==c ? skip : int_utf8_size(m);
+	return m==c ? 0 : m;
+}
 
-		// need to make room for new character code
-		if ((write+add)>scan) {
-			int m = (int)((write+add) - scan);
-			_strmod_shift(scan, m, (int)(end-scan));
-			scan += m;
-			end += m;
+// change the case of utf8 text from src to dst with ascii a vector at a time, characters
+// that keep their case are copied as they are. Stops before a character that does not fit
+// in cap or, if overlap is set, that would be written past where it is read from.
+// Returns bytes written and sets read to bytes read.
+static strl_t int_utf8_case(uint8_t *dst, strl_t cap, const uint8_t *src, strl_t length, bool upper, bool overlap, strl_t &read)
+{
+	uint8_t first = upper ? 'a' : 'A';
+	strl_t r = 0, w = 0;
+#ifdef STRUSE_V16
+	int_v16 f = int_v16_set1(first), ascii = int_v16_set1(0x7f);
+#endif
+	while (r<length) {
+		// a whole block is stored even if it is only ascii up to some point, that is only
+		// safe if the unread input it overwrites is the same text with its case changed
+		bool block = !overlap || (dst+w)==(src+r);
+#ifdef STRUSE_V16
+		for (; block && (r+16)<=length && (w+16)<=cap; r += 16, w += 16) {
+			int_v16 v = int_v16_load(src + r);
+			uint32_t high = int_v16_mask(int_v16_eq(int_v16_min(v, ascii), v)) ^ 0xffff;
+			int_v16_store(dst + w, int_change_case_v16(v, f));
+			if (high) {
+				strl_t n = strl_t(int_ctz32(high));
+				r += n;
+				w += n;
+				break;
+			}
+		}
+#endif
+		for (; block && (r+8)<=length && (w+8)<=cap; r += 8, w += 8) {
+			uint64_t x = int_read64(src + r, false);
+			int_write64(dst + w, int_change_case_swar(x, first));
+			if (uint64_t high = x & 0x8080808080808080ULL) {
+				strl_t n = strl_t(int_ctz64(high)>>3);
+				r += n;
+				w += n;
+				break;
+			}
+		}
+		if (r>=length || w>=cap)
+			break;
+		uint8_t a = src[r];
+		if (a<0x80) {
+			dst[w++] = a ^ uint8_t((uint8_t(a-first)<=('Z'-'A')) << 5);
+			r++;
+			continue;
 		}
-		skip = _strmod_write_utf8(write, cap, c, 0);
-		write += skip;
-		cap -= skip;
+		strl_t skip, add;
+		size_t m = int_utf8_case_char(src + r, src + length, upper, skip, add);
+		if ((w+add)>cap || (overlap && (dst+w+add)>(src+r+skip)))
+			break;
+		if (m)
+			_strmod_write_utf8((char*)dst, cap, m, w);
+		else if ((dst+w)!=(src+r))
+			memmove(dst+w, src+r, skip);
+		r += skip;
+		w += add;
+	}
+	read = r;
+	return w;
+}
+
+// change the case of utf8 in place in linear time. When a character grows the rest of the
+// string is measured and moved once to where it can be converted without overtaking
+// itself. If the output would get ahead of the input by more than the free room the
+// characters that do not grow are converted first and the rest is converted after, and
+// if the result does not fit it is cut at the last whole character that fits in cap.
+static strl_t int_utf8_case_in_place(uint8_t *string, strl_t length, strl_t cap, bool upper)
+{
+	strl_t read;
+	strl_t w = int_utf8_case(string, cap, string, length, upper, true, read);
+	if (read>=length)
+		return w;
+
+	// largest amount the output gets ahead of the input in the rest of the string
+	strl_t rest = length - read, in = 0, out = 0, ahead = 0;
+	for (const uint8_t *s = string + read, *e = string + length; s<e;) {
+		strl_t skip = 1, add = 1;
+		if (*s>=0x80)
+			int_utf8_case_char(s, e, upper, skip, add);
+		s += skip;
+		in += skip;
+		out += add;
+		if (out>in && (out-in)>ahead)
+			ahead = out-in;
+	}
+	if ((w + ahead + rest)<=cap) {
+		memmove(string + w + ahead, string + read, rest);
+		return w + int_utf8_case(string + w, cap - w, string + w + ahead, rest, upper, true, read);
+	}
+
+	// convert the characters that do not grow where they are and keep the ones that grow,
+	// after that the output only gets further ahead so all of it fits once moved to the end
+	strl_t o = w, end = w;
+	for (strl_t r = read; r<length;) {
+		uint8_t a = string[r];
+		strl_t skip = 1, add = 1;
+		size_t m = a<0x80 ? 0 : int_utf8_case_char(string + r, string + length, upper, skip, add);
+		if ((end + add)>cap)
+			break;
+		if (a<0x80)
+			string[o] = a ^ uint8_t((uint8_t(a-(upper ? 'a' : 'A'))<=('Z'-'A')) << 5);
+		else if (m && add<=skip)
+			_strmod_write_utf8((char*)string, cap, m, o);
+		else
+			memmove(string + o, string + r, skip);
+		o += add<=skip ? add : skip;
+		end += add;
+		r += skip;
 	}
-	return (strl_t)(end-string);
+	// converting the characters that already changed case again leaves them as they are
+	memmove(string + w + end - o, string + w, o - w);
+	return w + int_utf8_case(string + w, end - w, string + w + end - o, o - w, upper, true, read);
 }
 
-strl_t _strmod_utf8_toupper(char *string, strl_t length, strl_t cap) {
-	char *scan = string;
-	char *write = string;
-	char *end = string + length;
-
-	while (scan<end) {
-		// get one character
-		strl_t skip;
-		size_t c = _strmod_read_utf8(scan, strl_t(end-scan), 0, skip);
-		scan += skip;
+strl_t _strmod_utf8_tolower(char *string, strl_t length, strl_t cap) {
+	return string ? int_utf8_case_in_place((uint8_t*)string, length, cap, false) : 0;
+}
 
-		c = int_toupper_unicode(c);
+strl_t _strmod_utf8_toupper(char *string, strl_t length, strl_t cap) {
+	return string ? int_utf8_case_in_place((uint8_t*)string, length, cap, true) : 0;
+}
 
-		strl_t add = c<0x80 ? strl_t(1) : (c<0x800 ? strl_t(2) : (c<0x10000 ? strl_t(3) : strl_t(4)));
+// change the case of utf8 into a separate string, returns the length written
+strl_t _strmod_utf8_case_to(char *out, strl_t cap, const strref str, bool upper) {
+	strl_t read;
+	if (!out || !str.valid())
+		return 0;
+	return int_utf8_case((uint8_t*)out, cap, str.get_u(), str.get_len(), upper, false, read);
+}
 
-		if (add > cap)
-			return (strl_t)(write-string);
+// convert utf16 to utf8, returns the length written and sets read to units read
+strl_t _strmod_utf16_to_utf8(char *out, strl_t cap, const uint16_t *src, strl_t count, strl_t &read) {
+	read = 0;
+	return (out && src) ? int_units_to_utf8((uint8_t*)out, cap, src, count, read) : 0;
+}
 
-		// need to make room for new character code?
-		if ((write+add)>scan) {
-			int m = (int)((write+add) - scan);
-			_strmod_shift(scan, m, (int)(end-scan));
-			scan += m;
-			end += m;
-		}
-		skip = _strmod_write_utf8(write, cap, c, 0);
-		write += skip;
-		cap -= skip;
-	}
-	return (strl_t)(end-string);
+// convert utf32 to utf8, returns the length written and sets read to units read
+strl_t _strmod_utf32_to_utf8(char *out, strl_t cap, const uint32_t *src, strl_t count, strl_t &read) {
+	read = 0;
+	return (out && src) ? int_units_to_utf8((uint8_t*)out, cap, src, count, read) : 0;
 }
 
 strl_t _strmod_cleanup_path(char *file, strl_t len)